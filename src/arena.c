@@ -0,0 +1,221 @@
+/* arena.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALINEACION alignof(max_align_t)
+
+/**
+ * Un bloque de memoria de la arena. Los bytes alojables empiezan justo
+ * después de la estructura.
+ */
+typedef struct __ArenaBloque {
+  struct __ArenaBloque *siguiente;
+  size_t size;
+  size_t usado;
+  alignas(max_align_t) unsigned char datos[];
+} ArenaBloque;
+
+/**
+ * Los bloques nunca se liberan al reiniciar, solo se vuelven a usar desde el
+ * principio. Así, después de la primera ronda, alojar en la arena ya no
+ * necesita pedirle memoria a malloc.
+ *
+ * @n_alojamientos y @alojado cuentan lo que se ha alojado desde el último
+ * reinicio, para las métricas.
+ */
+struct __Arena {
+  ArenaBloque *primero;
+  ArenaBloque *actual;
+  size_t bloque_size;
+  size_t n_alojamientos;
+  size_t alojado;
+};
+
+ArenaBloque *arena_bloque_nuevo(size_t);
+
+ArenaBloque *arena_bloque_nuevo(size_t size)
+{
+  ArenaBloque *bloque;
+
+  bloque = malloc(sizeof(ArenaBloque) + size);
+  if (bloque == NULL) {
+    return NULL;
+  }
+  bloque->siguiente = NULL;
+  bloque->size = size;
+  bloque->usado = 0;
+
+  return bloque;
+}
+
+/**
+ * Crea una arena nueva
+ *
+ * @bloque_size El tamaño de cada bloque que se le pide a malloc
+ *
+ * Returns: La nueva arena
+ */
+Arena *arena_nueva(size_t bloque_size)
+{
+  Arena *self;
+
+  self = malloc(sizeof(Arena));
+  self->bloque_size = bloque_size > 0 ? bloque_size : 4096;
+  self->primero = arena_bloque_nuevo(self->bloque_size);
+  self->actual = self->primero;
+  self->n_alojamientos = 0;
+  self->alojado = 0;
+
+  return self;
+}
+
+/**
+ * Aloja @size bytes en @self, alineados para cualquier tipo
+ *
+ * Returns: (transfer: none) La memoria alojada, válida hasta que se reinicie
+ * o destruya @self
+ */
+void *arena_alojar(Arena *self, size_t size)
+{
+  ArenaBloque *bloque;
+  void *retval;
+
+  if (self == NULL) {
+    return NULL;
+  }
+
+  size = (size + ARENA_ALINEACION - 1) / ARENA_ALINEACION * ARENA_ALINEACION;
+
+  /*
+   * Buscamos un bloque con espacio a partir del actual. Los que le siguen ya
+   * existen de rondas anteriores y están vacíos.
+   */
+  bloque = self->actual;
+  while (bloque != NULL && bloque->size - bloque->usado < size) {
+    if (bloque->siguiente == NULL) {
+      bloque->siguiente = arena_bloque_nuevo(size > self->bloque_size
+                                             ? size : self->bloque_size);
+    }
+    bloque = bloque->siguiente;
+  }
+  if (bloque == NULL) {
+    return NULL;
+  }
+
+  retval = &bloque->datos[bloque->usado];
+  bloque->usado += size;
+  self->actual = bloque;
+  self->n_alojamientos++;
+  self->alojado += size;
+
+  return retval;
+}
+
+/**
+ * Igual que arena_alojar(), pero con la memoria en ceros
+ */
+void *arena_alojar0(Arena *self, size_t size)
+{
+  void *retval = arena_alojar(self, size);
+  if (retval != NULL) {
+    memset(retval, 0, size);
+  }
+  return retval;
+}
+
+/**
+ * Copia los primeros @n bytes de @str en @self y les agrega un NUL
+ *
+ * Returns: (transfer: none) La copia
+ */
+char *arena_strndup(Arena *self, const char *str, size_t n)
+{
+  char *retval;
+
+  if (str == NULL) {
+    return NULL;
+  }
+  retval = arena_alojar(self, n + 1);
+  if (retval == NULL) {
+    return NULL;
+  }
+  memcpy(retval, str, n);
+  retval[n] = '\0';
+
+  return retval;
+}
+
+char *arena_strdup(Arena *self, const char *str)
+{
+  if (str == NULL) {
+    return NULL;
+  }
+  return arena_strndup(self, str, strlen(str));
+}
+
+/**
+ * Libera de golpe todo lo que se alojó en @self, pero se queda con los
+ * bloques para volver a usarlos
+ */
+void arena_reiniciar(Arena *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  for (ArenaBloque *bloque = self->primero; bloque != NULL;
+       bloque = bloque->siguiente) {
+    bloque->usado = 0;
+  }
+  self->actual = self->primero;
+  self->n_alojamientos = 0;
+  self->alojado = 0;
+}
+
+/**
+ * Returns: Cuántas veces se ha alojado en @self desde que se creó o se
+ * reinició por última vez
+ */
+size_t arena_get_n_alojamientos(Arena *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->n_alojamientos;
+}
+
+/**
+ * Returns: Cuántos bytes se han alojado en @self, contando la alineación,
+ * desde que se creó o se reinició por última vez
+ */
+size_t arena_get_alojado(Arena *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->alojado;
+}
+
+void arena_destruir(Arena *self)
+{
+  ArenaBloque *bloque, *siguiente;
+
+  if (self == NULL) {
+    return;
+  }
+  for (bloque = self->primero; bloque != NULL; bloque = siguiente) {
+    siguiente = bloque->siguiente;
+    free(bloque);
+  }
+  free(self);
+}
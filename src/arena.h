@@ -0,0 +1,31 @@
+/* arena.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Una arena es un alojador que solo avanza un puntero dentro de bloques
+ * grandes. No se puede liberar lo que se aloja por separado: todo se libera
+ * junto al reiniciar o destruir la arena. Sirve para memoria que vive lo mismo,
+ * como todo lo de una ronda o todo lo que se carga al iniciar el juego.
+ */
+struct __Arena;
+typedef struct __Arena Arena;
+
+Arena *arena_nueva(size_t);
+void *arena_alojar(Arena *, size_t);
+void *arena_alojar0(Arena *, size_t);
+char *arena_strndup(Arena *, const char *, size_t);
+char *arena_strdup(Arena *, const char *);
+void arena_reiniciar(Arena *);
+size_t arena_get_n_alojamientos(Arena *);
+size_t arena_get_alojado(Arena *);
+void arena_destruir(Arena *);
@@ -0,0 +1,137 @@
+/* azar.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include "azar.h"
+
+uint64_t azar_rotar(uint64_t, int);
+uint64_t azar_splitmix(uint64_t *);
+
+uint64_t azar_rotar(uint64_t x,
+                    int      k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Avanza @estado y regresa el siguiente número de splitmix64, que solo se
+ * usa para convertir una semilla en un estado completo
+ */
+uint64_t azar_splitmix(uint64_t *estado)
+{
+  uint64_t z = (*estado += 0x9E3779B97F4A7C15ull);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Deja a @self listo para dar la secuencia de @semilla. Dos generadores con
+ * la misma semilla dan exactamente los mismos números.
+ */
+void azar_sembrar(Azar     *self,
+                  uint64_t  semilla)
+{
+  // splitmix64 nunca deja el estado en ceros, que es el único prohibido
+  for (int i = 0; i < 4; i++) {
+    self->s[i] = azar_splitmix(&semilla);
+  }
+}
+
+/**
+ * Returns: El siguiente número de @self, con sus 64 bits al azar
+ */
+uint64_t azar_siguiente(Azar *self)
+{
+  uint64_t *s = self->s;
+  uint64_t retval = azar_rotar(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = azar_rotar(s[3], 45);
+
+  return retval;
+}
+
+/**
+ * Elige un número de 0 a @n - 1, todos con la misma probabilidad.
+ *
+ * Con azar_siguiente() % @n, los números chicos salen un poco más que los
+ * grandes cuando @n no divide a 2^64. Aquí multiplicamos 32 bits al azar
+ * por @n y nos quedamos con la parte alta, y solo en el raro caso de que
+ * la parte baja caiga en la zona sesgada volvemos a tirar (Lemire, "Fast
+ * Random Integer Generation in an Interval", 2019). Casi nunca hace falta
+ * dividir.
+ *
+ * Returns: El número elegido, o 0 si @n es 0
+ */
+uint32_t azar_acotado(Azar     *self,
+                      uint32_t  n)
+{
+  uint64_t m;
+  uint32_t bajo;
+
+  if (n == 0) {
+    return 0;
+  }
+
+  m = (azar_siguiente(self) >> 32) * n;
+  bajo = (uint32_t) m;
+  if (bajo < n) {
+    // 2^32 % n, sin salirnos de 32 bits
+    uint32_t umbral = -n % n;
+
+    while (bajo < umbral) {
+      m = (azar_siguiente(self) >> 32) * n;
+      bajo = (uint32_t) m;
+    }
+  }
+  return m >> 32;
+}
+
+/**
+ * Revuelve @semilla con @n, para sacar de una sola semilla muchas otras
+ * (una por partida o por sesión) que no se parezcan aunque @n sea
+ * consecutivo
+ *
+ * Returns: La semilla número @n derivada de @semilla
+ */
+uint64_t azar_mezclar(uint64_t semilla,
+                      uint64_t n)
+{
+  uint64_t estado = semilla + n * 0x9E3779B97F4A7C15ull;
+
+  return azar_splitmix(&estado);
+}
+
+/**
+ * Returns: Una semilla distinta en cada llamada, para cuando no se pidió
+ * una en particular
+ */
+uint64_t azar_semilla_nueva(void)
+{
+  uint64_t semilla;
+  struct timespec ts;
+
+  if (getentropy(&semilla, sizeof(semilla)) == 0) {
+    return semilla;
+  }
+
+  // Sin getentropy(3), la hora y una dirección de la pila dan algo distinto
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  semilla = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+  return azar_mezclar(semilla, (uint64_t) (uintptr_t) &ts);
+}
@@ -0,0 +1,30 @@
+/* azar.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Un generador de números aleatorios (xoshiro256**) con su estado propio,
+ * para que cada partida tenga el suyo sin candados y se pueda repetir con
+ * la misma semilla. No sirve para criptografía.
+ *
+ * No es opaco porque es pequeño y vive dentro de quien lo usa; su estado
+ * solo se toca con estas funciones.
+ */
+typedef struct {
+  uint64_t s[4];
+} Azar;
+
+void azar_sembrar(Azar *, uint64_t);
+uint64_t azar_siguiente(Azar *);
+uint32_t azar_acotado(Azar *, uint32_t);
+uint64_t azar_mezclar(uint64_t, uint64_t);
+uint64_t azar_semilla_nueva(void);
@@ -0,0 +1,686 @@
+/* bitacora.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bitacora.h"
+
+/* Cuánto junta cada buffer antes de escribirse */
+#define BITACORA_BUFFER (1024 * 1024)
+
+/* Cada cuánto se escribe lo que haya, aunque no se llene el buffer */
+#define BITACORA_INTERVALO_MS 200
+
+/**
+ * Los eventos se copian a @activo con el candado tomado, que es lo único
+ * que espera quien los anota. Cuando @activo se llena a la mitad, o cada
+ * BITACORA_INTERVALO_MS, se intercambia con @lleno y el hilo @hilo lo
+ * escribe sin el candado, mientras se sigue llenando el otro.
+ *
+ * Si el disco no alcanza y los dos buffers están llenos, el evento se
+ * tira y se cuenta en @perdidos: la partida nunca espera a que se escriba.
+ *
+ * Los eventos de todas las sesiones van al mismo buffer, en el orden en que
+ * se anotan. Una sesión puede pasar de un hilo a otro, pero solo uno la
+ * atiende a la vez, así que sus eventos nunca se desordenan.
+ */
+struct __Bitacora {
+  int fd;
+  pthread_t hilo;
+  pthread_mutex_t candado;
+  pthread_cond_t listo;
+  char *activo;
+  size_t activo_len;
+  char *lleno;
+  size_t lleno_len;
+  bool cerrando;
+  bool fallo;
+  uint64_t perdidos;
+};
+
+/**
+ * La bitácora se mapea completa y se lee de @offset en adelante. @error
+ * dice si se encontró algo que no es un evento, normalmente porque el
+ * último quedó a medias.
+ */
+struct __BitacoraLector {
+  void *mapa;
+  size_t size;
+  size_t offset;
+  bool error;
+};
+
+void *bitacora_escribir_hilo(void *);
+void bitacora_escribir_todo(Bitacora *, const char *, size_t);
+void bitacora_intercambiar(Bitacora *);
+char *bitacora_reservar(Bitacora *, size_t);
+void bitacora_soltar(Bitacora *);
+size_t bitacora_varint_size(uint64_t);
+size_t bitacora_texto_size(size_t);
+char *bitacora_poner_varint(char *, uint64_t);
+char *bitacora_poner_texto(char *, const char *, size_t);
+bool bitacora_leer_byte(BitacoraLector *, uint8_t *);
+bool bitacora_leer_varint(BitacoraLector *, uint64_t *);
+bool bitacora_leer_texto(BitacoraLector *, const char **, size_t *);
+
+/**
+ * Abre @archivo para agregarle los eventos de esta ejecución, creándolo si
+ * no existe, y empieza el hilo que los escribe
+ *
+ * Cada hilo escribe buffers completos, pero los de dos procesos se
+ * intercalarían en el archivo y la repetición mezclaría sus sesiones. Por
+ * eso nos quedamos con el archivo (flock) mientras esté abierto, y si ya lo
+ * tiene otro proceso no lo abrimos.
+ *
+ * Returns: (transfer: full) La bitácora, o NULL si no se pudo abrir o ya la
+ * está escribiendo otro proceso
+ */
+Bitacora *bitacora_abrir(const char *archivo)
+{
+  BitacoraCabecera cabecera = { BITACORA_MAGIA, BITACORA_VERSION };
+  pthread_condattr_t atributos;
+  sigset_t senales, anteriores;
+  Bitacora *self;
+  bool creado;
+  int fd;
+
+  if (archivo == NULL) {
+    return NULL;
+  }
+
+  fd = open(archivo, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    fprintf(stderr, "No se pudo abrir la bitácora %s\n", archivo);
+    return NULL;
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+    if (errno == EWOULDBLOCK) {
+      fprintf(stderr, "Otro proceso ya está escribiendo la bitácora %s\n",
+              archivo);
+    } else {
+      fprintf(stderr, "No se pudo apartar la bitácora %s: %s\n", archivo,
+              strerror(errno));
+    }
+    close(fd);
+    return NULL;
+  }
+
+  self = calloc(1, sizeof(Bitacora));
+  self->fd = fd;
+  self->activo = malloc(BITACORA_BUFFER);
+  self->lleno = malloc(BITACORA_BUFFER);
+  pthread_mutex_init(&self->candado, NULL);
+  pthread_condattr_init(&atributos);
+  pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC);
+  pthread_cond_init(&self->listo, &atributos);
+  pthread_condattr_destroy(&atributos);
+
+  // La cabecera separa esta ejecución de las que ya estaban en el archivo
+  memcpy(self->activo, &cabecera, sizeof(cabecera));
+  self->activo_len = sizeof(cabecera);
+
+  // El hilo no debe recibir las señales que esperan los demás (SIGINT y
+  // SIGTERM en el servidor), así que se crea con todas bloqueadas
+  sigfillset(&senales);
+  pthread_sigmask(SIG_BLOCK, &senales, &anteriores);
+  creado = pthread_create(&self->hilo, NULL, bitacora_escribir_hilo, self) == 0;
+  pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+
+  if (!creado) {
+    fprintf(stderr, "No se pudo crear el hilo de la bitácora\n");
+    pthread_cond_destroy(&self->listo);
+    pthread_mutex_destroy(&self->candado);
+    free(self->activo);
+    free(self->lleno);
+    close(fd);
+    free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+/**
+ * Lo que hace el hilo de la bitácora: escribe cada buffer que se llena, y
+ * lo que lleve el activo cada BITACORA_INTERVALO_MS y al cerrar
+ */
+void *bitacora_escribir_hilo(void *datos)
+{
+  Bitacora *self = datos;
+  bool vencido = false;
+
+  pthread_mutex_lock(&self->candado);
+  for (;;) {
+    if (self->lleno_len == 0 && self->activo_len > 0
+        && (vencido || self->cerrando)) {
+      bitacora_intercambiar(self);
+    }
+
+    if (self->lleno_len > 0) {
+      // Mientras @lleno tenga algo, nadie más lo toca
+      const char *lleno = self->lleno;
+      size_t lleno_len = self->lleno_len;
+
+      pthread_mutex_unlock(&self->candado);
+      bitacora_escribir_todo(self, lleno, lleno_len);
+      pthread_mutex_lock(&self->candado);
+      self->lleno_len = 0;
+      vencido = false;
+      continue;
+    }
+    if (self->cerrando) {
+      break;
+    }
+
+    {
+      struct timespec limite;
+
+      clock_gettime(CLOCK_MONOTONIC, &limite);
+      limite.tv_nsec += BITACORA_INTERVALO_MS * 1000000L;
+      limite.tv_sec += limite.tv_nsec / 1000000000L;
+      limite.tv_nsec %= 1000000000L;
+      vencido = pthread_cond_timedwait(&self->listo, &self->candado,
+                                       &limite) == ETIMEDOUT;
+    }
+  }
+  pthread_mutex_unlock(&self->candado);
+
+  return NULL;
+}
+
+/**
+ * Escribe @len bytes de @datos completos. Si falla, lo dice una vez y
+ * descarta lo demás.
+ */
+void bitacora_escribir_todo(Bitacora   *self,
+                            const char *datos,
+                            size_t      len)
+{
+  while (len > 0 && !self->fallo) {
+    ssize_t n = write(self->fd, datos, len);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "No se pudo escribir la bitácora: %s\n", strerror(errno));
+      self->fallo = true;
+      break;
+    }
+    datos += n;
+    len -= n;
+  }
+}
+
+/**
+ * Pasa @activo a @lleno, que debe estar vacío, y avisa al hilo. Se llama
+ * con el candado tomado.
+ */
+void bitacora_intercambiar(Bitacora *self)
+{
+  char *vacio = self->lleno;
+
+  self->lleno = self->activo;
+  self->lleno_len = self->activo_len;
+  self->activo = vacio;
+  self->activo_len = 0;
+  pthread_cond_signal(&self->listo);
+}
+
+/**
+ * Aparta @len bytes en el buffer activo y deja tomado el candado hasta
+ * bitacora_soltar()
+ *
+ * Returns: Dónde escribir el evento, o NULL (ya sin el candado) si no cabe
+ * y hay que tirarlo
+ */
+char *bitacora_reservar(Bitacora *self,
+                        size_t    len)
+{
+  char *lugar;
+
+  pthread_mutex_lock(&self->candado);
+  if (self->activo_len + len > BITACORA_BUFFER) {
+    if (self->lleno_len > 0 || len > BITACORA_BUFFER) {
+      self->perdidos++;
+      pthread_mutex_unlock(&self->candado);
+      return NULL;
+    }
+    bitacora_intercambiar(self);
+  }
+  lugar = &self->activo[self->activo_len];
+  self->activo_len += len;
+
+  return lugar;
+}
+
+/**
+ * Suelta el candado de bitacora_reservar(). Si el buffer activo ya va a la
+ * mitad, se lo pasa al hilo en lugar de esperar a que se llene.
+ */
+void bitacora_soltar(Bitacora *self)
+{
+  if (self->activo_len >= BITACORA_BUFFER / 2 && self->lleno_len == 0) {
+    bitacora_intercambiar(self);
+  }
+  pthread_mutex_unlock(&self->candado);
+}
+
+/**
+ * Anota que empezó la sesión @sesion, con @semilla
+ */
+void bitacora_sesion(Bitacora *self,
+                     uint64_t  sesion,
+                     uint64_t  semilla)
+{
+  char *lugar;
+
+  if (self == NULL) {
+    return;
+  }
+  lugar = bitacora_reservar(self, 1 + bitacora_varint_size(sesion)
+                                  + bitacora_varint_size(semilla));
+  if (lugar == NULL) {
+    return;
+  }
+  *lugar++ = BITACORA_SESION;
+  lugar = bitacora_poner_varint(lugar, sesion);
+  bitacora_poner_varint(lugar, semilla);
+  bitacora_soltar(self);
+}
+
+/**
+ * Anota que la sesión @sesion empezó una ronda con la palabra @indice de
+ * @categoria, que es @palabra
+ *
+ * @dificultad La dificultad con la que se eligió, o CATEGORIA_N_DIFICULTADES
+ * si se eligió entre todas
+ * @len Cuántos bytes mide @palabra
+ */
+void bitacora_ronda(Bitacora   *self,
+                    uint64_t    sesion,
+                    const char *categoria,
+                    uint64_t    indice,
+                    uint8_t     dificultad,
+                    const char *palabra,
+                    size_t      len)
+{
+  size_t categoria_len;
+  char *lugar;
+
+  if (self == NULL || palabra == NULL) {
+    return;
+  }
+  if (categoria == NULL) {
+    categoria = "";
+  }
+  categoria_len = strlen(categoria);
+
+  lugar = bitacora_reservar(self, 2 + bitacora_varint_size(sesion)
+                                  + bitacora_varint_size(indice)
+                                  + bitacora_texto_size(categoria_len)
+                                  + bitacora_texto_size(len));
+  if (lugar == NULL) {
+    return;
+  }
+  *lugar++ = BITACORA_RONDA;
+  lugar = bitacora_poner_varint(lugar, sesion);
+  *lugar++ = dificultad;
+  lugar = bitacora_poner_varint(lugar, indice);
+  lugar = bitacora_poner_texto(lugar, categoria, categoria_len);
+  bitacora_poner_texto(lugar, palabra, len);
+  bitacora_soltar(self);
+}
+
+/**
+ * Anota un intento de la sesión @sesion y cómo quedó la partida después
+ *
+ * @tipo 'c' si fue de un caracter, 'p' si fue de la palabra completa
+ * @texto Lo que escribió el jugador
+ * @resultado El PartidaIntento que regresó
+ * @vidas Las vidas que quedaron
+ * @estado El PartidaEstado en el que quedó
+ */
+void bitacora_intento(Bitacora   *self,
+                      uint64_t    sesion,
+                      char        tipo,
+                      const char *texto,
+                      uint8_t     resultado,
+                      uint8_t     vidas,
+                      uint8_t     estado)
+{
+  size_t len;
+  char *lugar;
+
+  if (self == NULL || texto == NULL) {
+    return;
+  }
+  len = strlen(texto);
+
+  lugar = bitacora_reservar(self, 5 + bitacora_varint_size(sesion)
+                                  + bitacora_texto_size(len));
+  if (lugar == NULL) {
+    return;
+  }
+  *lugar++ = BITACORA_INTENTO;
+  lugar = bitacora_poner_varint(lugar, sesion);
+  *lugar++ = tipo;
+  *lugar++ = resultado;
+  *lugar++ = vidas;
+  *lugar++ = estado;
+  bitacora_poner_texto(lugar, texto, len);
+  bitacora_soltar(self);
+}
+
+/**
+ * Anota que terminó la sesión @sesion
+ */
+void bitacora_fin(Bitacora *self,
+                  uint64_t  sesion)
+{
+  char *lugar;
+
+  if (self == NULL) {
+    return;
+  }
+  lugar = bitacora_reservar(self, 1 + bitacora_varint_size(sesion));
+  if (lugar == NULL) {
+    return;
+  }
+  *lugar++ = BITACORA_FIN;
+  bitacora_poner_varint(lugar, sesion);
+  bitacora_soltar(self);
+}
+
+/**
+ * Escribe lo que falte y cierra @self. Ya nadie debe estar anotando.
+ */
+void bitacora_cerrar(Bitacora *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&self->candado);
+  self->cerrando = true;
+  pthread_cond_signal(&self->listo);
+  pthread_mutex_unlock(&self->candado);
+  pthread_join(self->hilo, NULL);
+
+  if (self->perdidos > 0) {
+    fprintf(stderr, "Se perdieron %llu eventos de la bitácora\n",
+            (unsigned long long) self->perdidos);
+  }
+
+  close(self->fd);
+  pthread_cond_destroy(&self->listo);
+  pthread_mutex_destroy(&self->candado);
+  free(self->activo);
+  free(self->lleno);
+  free(self);
+}
+
+size_t bitacora_varint_size(uint64_t valor)
+{
+  size_t n = 1;
+
+  while (valor >= 0x80) {
+    valor >>= 7;
+    n++;
+  }
+  return n;
+}
+
+size_t bitacora_texto_size(size_t len)
+{
+  return bitacora_varint_size(len) + len + 1;
+}
+
+/**
+ * Returns: Lo que sigue de @lugar después del varint
+ */
+char *bitacora_poner_varint(char     *lugar,
+                            uint64_t  valor)
+{
+  while (valor >= 0x80) {
+    *lugar++ = (valor & 0x7F) | 0x80;
+    valor >>= 7;
+  }
+  *lugar++ = valor;
+  return lugar;
+}
+
+/**
+ * Returns: Lo que sigue de @lugar después del texto
+ */
+char *bitacora_poner_texto(char       *lugar,
+                           const char *texto,
+                           size_t      len)
+{
+  lugar = bitacora_poner_varint(lugar, len);
+  memcpy(lugar, texto, len);
+  lugar[len] = '\0';
+  return &lugar[len + 1];
+}
+
+/**
+ * Abre la bitácora @archivo para leer sus eventos
+ *
+ * Returns: (transfer: full) El lector, o NULL si @archivo no es una
+ * bitácora
+ */
+BitacoraLector *bitacora_lector_abrir(const char *archivo)
+{
+  const BitacoraCabecera *cabecera;
+  BitacoraLector *self;
+  struct stat info;
+  void *mapa;
+  int fd;
+
+  if (archivo == NULL) {
+    return NULL;
+  }
+
+  fd = open(archivo, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return NULL;
+  }
+  if (fstat(fd, &info) == -1 || info.st_size < sizeof(BitacoraCabecera)) {
+    close(fd);
+    return NULL;
+  }
+  mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return NULL;
+  }
+  madvise(mapa, info.st_size, MADV_SEQUENTIAL);
+
+  cabecera = mapa;
+  if (memcmp(cabecera->magia, BITACORA_MAGIA, sizeof(cabecera->magia)) != 0) {
+    munmap(mapa, info.st_size);
+    return NULL;
+  }
+
+  self = calloc(1, sizeof(BitacoraLector));
+  self->mapa = mapa;
+  self->size = info.st_size;
+
+  return self;
+}
+
+/**
+ * Lee el siguiente evento de @self
+ *
+ * @evento (out) El evento
+ *
+ * Returns: true si había otro evento completo. Si no, con
+ * bitacora_lector_terminado() se sabe si se acabó el archivo o se encontró
+ * uno a medias.
+ */
+bool bitacora_lector_siguiente(BitacoraLector *self,
+                               BitacoraEvento *evento)
+{
+  const char *datos;
+  size_t inicio;
+  uint8_t tipo;
+
+  if (self == NULL || self->error || self->offset >= self->size) {
+    return false;
+  }
+  datos = self->mapa;
+  inicio = self->offset;
+  memset(evento, 0, sizeof(BitacoraEvento));
+
+  if (self->size - self->offset >= sizeof(BitacoraCabecera)
+      && memcmp(&datos[self->offset], BITACORA_MAGIA,
+                sizeof(BITACORA_MAGIA)) == 0) {
+    BitacoraCabecera cabecera;
+
+    memcpy(&cabecera, &datos[self->offset], sizeof(cabecera));
+    if (cabecera.version != BITACORA_VERSION) {
+      self->error = true;
+      return false;
+    }
+    self->offset += sizeof(cabecera);
+    evento->tipo = BITACORA_CABECERA;
+    return true;
+  }
+
+  if (!bitacora_leer_byte(self, &tipo)
+      || !bitacora_leer_varint(self, &evento->sesion)) {
+    self->error = true;
+    self->offset = inicio;
+    return false;
+  }
+  evento->tipo = tipo;
+
+  switch (tipo) {
+  case BITACORA_SESION:
+    self->error = !bitacora_leer_varint(self, &evento->semilla);
+    break;
+  case BITACORA_RONDA:
+    self->error = !bitacora_leer_byte(self, &evento->dificultad)
+                  || !bitacora_leer_varint(self, &evento->indice)
+                  || !bitacora_leer_texto(self, &evento->categoria,
+                                          &evento->categoria_len)
+                  || !bitacora_leer_texto(self, &evento->texto,
+                                          &evento->texto_len);
+    break;
+  case BITACORA_INTENTO:
+    self->error = !bitacora_leer_byte(self, &evento->intento)
+                  || !bitacora_leer_byte(self, &evento->resultado)
+                  || !bitacora_leer_byte(self, &evento->vidas)
+                  || !bitacora_leer_byte(self, &evento->estado)
+                  || !bitacora_leer_texto(self, &evento->texto,
+                                          &evento->texto_len);
+    break;
+  case BITACORA_FIN:
+    break;
+  default:
+    self->error = true;
+    break;
+  }
+
+  if (self->error) {
+    self->offset = inicio;
+  }
+  return !self->error;
+}
+
+/**
+ * Returns: true si @self leyó todos los eventos, sin encontrar ninguno a
+ * medias
+ */
+bool bitacora_lector_terminado(BitacoraLector *self)
+{
+  if (self == NULL) {
+    return false;
+  }
+  return !self->error && self->offset >= self->size;
+}
+
+/**
+ * Returns: En qué byte del archivo va @self; si hubo un error, dónde
+ * empieza lo que no se pudo leer
+ */
+size_t bitacora_lector_get_offset(BitacoraLector *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->offset;
+}
+
+bool bitacora_leer_byte(BitacoraLector *self,
+                        uint8_t        *valor)
+{
+  if (self->offset >= self->size) {
+    return false;
+  }
+  *valor = ((const uint8_t *) self->mapa)[self->offset++];
+  return true;
+}
+
+bool bitacora_leer_varint(BitacoraLector *self,
+                          uint64_t       *valor)
+{
+  uint8_t byte;
+
+  *valor = 0;
+  for (int desplazamiento = 0; desplazamiento < 64; desplazamiento += 7) {
+    if (!bitacora_leer_byte(self, &byte)) {
+      return false;
+    }
+    *valor |= (uint64_t) (byte & 0x7F) << desplazamiento;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool bitacora_leer_texto(BitacoraLector  *self,
+                         const char     **texto,
+                         size_t          *len)
+{
+  uint64_t longitud;
+
+  if (!bitacora_leer_varint(self, &longitud)
+      || longitud >= self->size - self->offset) {
+    return false;
+  }
+  *texto = &((const char *) self->mapa)[self->offset];
+  *len = longitud;
+  if ((*texto)[longitud] != '\0') {
+    return false;
+  }
+  self->offset += longitud + 1;
+  return true;
+}
+
+void bitacora_lector_cerrar(BitacoraLector *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  munmap(self->mapa, self->size);
+  free(self);
+}
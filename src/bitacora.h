@@ -0,0 +1,101 @@
+/* bitacora.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * La bitácora guarda todo lo que pasa en las partidas para poder repetirlo
+ * después con adivinador-repetir: la semilla de cada sesión, cada palabra
+ * que se eligió y cada intento con lo que pasó.
+ *
+ * El archivo solo crece, y lo escribe un solo proceso a la vez. Cada vez que
+ * se abre para escribir se agrega una cabecera (BitacoraCabecera), y después
+ * vienen los eventos de esa ejecución, uno detrás de otro:
+ *
+ *   tipo (1 byte) | sesión (varint) | lo de cada tipo
+ *
+ *   BITACORA_SESION   semilla (varint)
+ *   BITACORA_RONDA    dificultad (1 byte) | índice (varint) |
+ *                     categoría (texto) | palabra (texto)
+ *   BITACORA_INTENTO  tipo ('c' o 'p') | resultado | vidas | estado
+ *                     (1 byte cada uno) | lo que escribió el jugador (texto)
+ *   BITACORA_FIN      nada
+ *
+ * Los varint son LEB128: siete bits por byte, empezando por los bajos, con
+ * el bit alto encendido si sigue otro byte. Un texto es su longitud como
+ * varint, sus bytes y un NUL, para poder usarlo directo desde el archivo.
+ *
+ * Los números de sesión solo son únicos dentro de una ejecución, es decir,
+ * entre dos cabeceras.
+ */
+#define BITACORA_MAGIA "ADVNBIT"
+#define BITACORA_VERSION 1
+
+typedef struct {
+  char     magia[8];
+  uint32_t version;
+  uint32_t reservado;
+} BitacoraCabecera;
+
+typedef enum {
+  BITACORA_CABECERA,
+  BITACORA_SESION,
+  BITACORA_RONDA,
+  BITACORA_INTENTO,
+  BITACORA_FIN
+} BitacoraTipo;
+
+/**
+ * Un evento leído de la bitácora. Solo tienen sentido los campos de su
+ * @tipo; los textos apuntan dentro del archivo y terminan en NUL.
+ */
+typedef struct {
+  BitacoraTipo tipo;
+  uint64_t sesion;
+
+  uint64_t semilla;
+
+  uint8_t dificultad;
+  uint64_t indice;
+  const char *categoria;
+  size_t categoria_len;
+
+  uint8_t intento;
+  uint8_t resultado;
+  uint8_t vidas;
+  uint8_t estado;
+
+  const char *texto;
+  size_t texto_len;
+} BitacoraEvento;
+
+struct __Bitacora;
+typedef struct __Bitacora Bitacora;
+
+struct __BitacoraLector;
+typedef struct __BitacoraLector BitacoraLector;
+
+Bitacora *bitacora_abrir(const char *);
+void bitacora_sesion(Bitacora *, uint64_t, uint64_t);
+void bitacora_ronda(Bitacora *, uint64_t, const char *, uint64_t, uint8_t,
+                    const char *, size_t);
+void bitacora_intento(Bitacora *, uint64_t, char, const char *, uint8_t,
+                      uint8_t, uint8_t);
+void bitacora_fin(Bitacora *, uint64_t);
+void bitacora_cerrar(Bitacora *);
+
+BitacoraLector *bitacora_lector_abrir(const char *);
+bool bitacora_lector_siguiente(BitacoraLector *, BitacoraEvento *);
+bool bitacora_lector_terminado(BitacoraLector *);
+size_t bitacora_lector_get_offset(BitacoraLector *);
+void bitacora_lector_cerrar(BitacoraLector *);
@@ -0,0 +1,1099 @@
+/* categoria.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "categoria.h"
+#include "indice.h"
+#include "metricas.h"
+#include "u8.h"
+
+/**
+ * Este será el tamaño que tendrá el arreglo de palabras. Lo haremos un número
+ * relativamente grande, porque si no tendríamos que realojar muchas veces,
+ * y eso es una operación muy cara. Mejor nos ahorramos eso aunque tengamos
+ * un poquillo de overhead.
+ */
+#define DEFAULT_N_PALABRAS 32
+#define DEFAULT_DATOS_SIZE 512
+
+/*
+ * A partir de este tamaño, una lista sin índice se indexa en lugar de
+ * cargarse, y sus palabras se leen una por una del archivo
+ */
+#define CATEGORIA_INDICE_MINIMO (64 * 1024 * 1024)
+
+/*
+ * Las letras que menos aparecen en las listas; casi nadie las prueba pronto,
+ * así que cada una que tenga una palabra suele costar una vida
+ */
+#define CATEGORIA_LETRAS_RARAS "bgvyqhfzjxkw"
+
+/* Los puntos de una palabra nunca pasan de aquí */
+#define CATEGORIA_MAX_PUNTOS 255
+
+/* Cuántas letras distintas se cuentan, como mucho, al puntuar una palabra */
+#define CATEGORIA_MAX_LETRAS 64
+
+/**
+ * Todas las palabras de una categoría viven juntas en @datos, cada una
+ * terminada en NUL. @datos puede ser memoria del heap (cuando las palabras
+ * se registran una por una) o el archivo de la categoría mapeado con mmap,
+ * en cuyo caso @mapa apunta al inicio del mapeo.
+ *
+ * Si @prestada es true, tanto @datos como @palabras pertenecen a alguien más
+ * (por ejemplo, a un paquete de recursos) y no los debemos liberar. Si
+ * @en_arena es true, la estructura y el nombre viven en una arena y se
+ * liberan junto con ella.
+ *
+ * Las categorías de archivos y paquetes se cargan hasta que alguien pide sus
+ * palabras: mientras @cargada sea false, de una categoría de archivo solo
+ * sabemos su @archivo y su @archivo_size, y las de paquete todavía no se
+ * validan. @candado hace que, si varios hilos las piden a la vez, solo uno
+ * las cargue.
+ *
+ * Si la lista tiene un índice (@idx), nunca se carga: @datos y @palabras
+ * se quedan vacíos y cada palabra se lee de @fd cuando se necesita.
+ *
+ * @orden tiene los índices de las palabras de menos a más puntos, y las de
+ * la dificultad d son las que van de @limites[d] a @limites[d + 1]. Se arma
+ * al cargar, o la primera vez que se pide si las palabras se registraron una
+ * por una; @clasificada dice si ya está. Las categorías indexadas no se
+ * clasifican, porque habría que leer la lista completa.
+ */
+struct __Categoria {
+  char *nombre;
+  char *archivo;
+  size_t archivo_size;
+
+  char *datos;
+  size_t datos_len;
+  size_t datos_size;
+
+  CategoriaPalabra *palabras;
+  size_t n_palabras;
+  size_t buffer_size;
+
+  void *mapa;
+  size_t mapa_size;
+
+  Indice *idx;
+  int fd;
+
+  bool prestada;
+  bool en_arena;
+
+  uint32_t *orden;
+  size_t limites[CATEGORIA_N_DIFICULTADES + 1];
+
+  atomic_bool cargada;
+  atomic_bool clasificada;
+  pthread_mutex_t candado;
+};
+
+void categoria_realloc(Categoria *);
+void categoria_reservar_datos(Categoria *, size_t);
+bool categoria_indexar_lineas(Categoria *);
+bool categoria_cargar_ahora(Categoria *);
+bool categoria_mapear_archivo(Categoria *);
+bool categoria_abrir_indice(Categoria *);
+bool categoria_validar_datos(Categoria *);
+void categoria_clasificar(Categoria *);
+void categoria_clasificar_ahora(Categoria *);
+
+/**
+ * Función que crea una nueva categoría de nombre @nombre
+ *
+ * @nombre El nombre de la categoría
+ *
+ * Returns: una categoría nueva
+ */
+Categoria *categoria_nueva(const char *nombre)
+{
+  Categoria *nueva;
+  if (nombre == NULL) {
+    return NULL;
+  }
+
+  nueva = malloc(sizeof(Categoria));
+  nueva->nombre = strdup (nombre);
+  nueva->archivo = NULL;
+  nueva->archivo_size = 0;
+
+  nueva->datos = NULL;
+  nueva->datos_len = 0;
+  nueva->datos_size = 0;
+
+  nueva->palabras = calloc(DEFAULT_N_PALABRAS, sizeof(CategoriaPalabra));
+  nueva->n_palabras = 0;
+  nueva->buffer_size = DEFAULT_N_PALABRAS;
+
+  nueva->mapa = NULL;
+  nueva->mapa_size = 0;
+
+  nueva->idx = NULL;
+  nueva->fd = -1;
+
+  nueva->prestada = false;
+  nueva->en_arena = false;
+
+  nueva->orden = NULL;
+  memset(nueva->limites, 0, sizeof(nueva->limites));
+
+  atomic_init(&nueva->cargada, true);
+  atomic_init(&nueva->clasificada, false);
+  pthread_mutex_init(&nueva->candado, NULL);
+
+  return nueva;
+}
+
+/**
+ * Función que crea una nueva categoría de nombre @nombre sobre palabras que
+ * ya están en memoria, sin copiarlas. @datos y @palabras deben vivir más que
+ * la categoría.
+ *
+ * Las palabras no se revisan sino hasta que se piden por primera vez; si no
+ * son UTF-8 válido, la categoría se queda sin palabras.
+ *
+ * @nombre El nombre de la categoría
+ *
+ * @datos Las palabras, cada una terminada en NUL
+ *
+ * @datos_len La longitud de @datos
+ *
+ * @palabras La tabla de palabras dentro de @datos
+ *
+ * @n_palabras El número de entradas en @palabras
+ *
+ * @arena (nullable) Una arena donde alojar la categoría, o NULL para usar malloc
+ *
+ * Returns: una categoría nueva
+ */
+Categoria *categoria_nueva_desde_memoria(const char             *nombre,
+                                         const char             *datos,
+                                         size_t                  datos_len,
+                                         const CategoriaPalabra *palabras,
+                                         size_t                  n_palabras,
+                                         Arena                  *arena)
+{
+  Categoria *nueva;
+  if (nombre == NULL) {
+    return NULL;
+  }
+  if (datos == NULL || palabras == NULL) {
+    return NULL;
+  }
+
+  if (arena != NULL) {
+    nueva = arena_alojar(arena, sizeof(Categoria));
+    nueva->nombre = arena_strdup(arena, nombre);
+  } else {
+    nueva = malloc(sizeof(Categoria));
+    nueva->nombre = strdup (nombre);
+  }
+  nueva->en_arena = arena != NULL;
+  nueva->archivo = NULL;
+  nueva->archivo_size = 0;
+
+  /*
+   * Las categorías prestadas nunca escriben sobre sus datos: si alguien
+   * registra otra palabra, primero se copian al heap
+   */
+  nueva->datos = (char *) datos;
+  nueva->datos_len = datos_len;
+  nueva->datos_size = datos_len;
+
+  nueva->palabras = (CategoriaPalabra *) palabras;
+  nueva->n_palabras = n_palabras;
+  nueva->buffer_size = n_palabras;
+
+  nueva->mapa = NULL;
+  nueva->mapa_size = 0;
+
+  nueva->idx = NULL;
+  nueva->fd = -1;
+
+  nueva->prestada = true;
+
+  nueva->orden = NULL;
+  memset(nueva->limites, 0, sizeof(nueva->limites));
+
+  atomic_init(&nueva->cargada, false);
+  atomic_init(&nueva->clasificada, false);
+  pthread_mutex_init(&nueva->candado, NULL);
+
+  return nueva;
+}
+
+/**
+ * Función que registra la categoría @nombre, cuyas palabras están en
+ * @archivo, sin leerlo todavía: solo revisa que exista. Las palabras se
+ * cargan la primera vez que se piden, así que registrar muchas listas
+ * grandes no cuesta más que registrar una.
+ *
+ * @nombre El nombre de la categoría
+ *
+ * @archivo El camino al archivo
+ *
+ * Returns: una categoría nueva, o NULL si no existe @archivo
+ */
+Categoria *categoria_nueva_perezosa(const char *nombre,
+                                    const char *archivo)
+{
+  Categoria *nueva;
+  struct stat info;
+
+  if (nombre == NULL) {
+    return NULL;
+  }
+  if (archivo == NULL) {
+    return NULL;
+  }
+
+  if (stat(archivo, &info) == -1) {
+    fprintf (stderr, "No se pudo abrir el archivo %s para la categoría %s\n",
+                     archivo, nombre);
+    return NULL;
+  }
+  if (!S_ISREG(info.st_mode)) {
+    fprintf (stderr, "El archivo %s no es válido para la categoría %s\n",
+                     archivo, nombre);
+    return NULL;
+  }
+
+  nueva = categoria_nueva(nombre);
+  nueva->archivo = strdup(archivo);
+  nueva->archivo_size = info.st_size;
+  atomic_init(&nueva->cargada, false);
+
+  return nueva;
+}
+
+/**
+ * Función que crea una nueva categoría de nombre @nombre a partir de las
+ * palabras de @archivo, leyéndolo de una vez. A diferencia de las
+ * perezosas, nunca usa el índice de @archivo, así que todas sus palabras
+ * están en memoria.
+ *
+ * @nombre El nombre de la categoría
+ *
+ * @archivo El camino al archivo
+ *
+ * Returns: una categoría nueva, o NULL si no se pudo leer @archivo
+ */
+Categoria *categoria_nueva_desde_archivo(const char *nombre,
+                                         const char *archivo)
+{
+  Categoria *nueva = categoria_nueva_perezosa(nombre, archivo);
+
+  if (nueva == NULL) {
+    return NULL;
+  }
+  if (!categoria_mapear_archivo(nueva)) {
+    categoria_destruir(nueva);
+    return NULL;
+  }
+  atomic_store(&nueva->cargada, true);
+  return nueva;
+}
+
+/**
+ * Carga las palabras de @self si todavía no se han cargado. Se puede llamar
+ * desde varios hilos a la vez: solo uno carga y los demás lo esperan. Ya
+ * cargada, solo cuesta leer una bandera.
+ *
+ * @self La categoría
+ *
+ * Returns: true si @self tiene palabras
+ */
+bool categoria_cargar(Categoria *self)
+{
+  if (self == NULL) {
+    return false;
+  }
+  if (!atomic_load_explicit(&self->cargada, memory_order_acquire)) {
+    pthread_mutex_lock(&self->candado);
+    if (!atomic_load_explicit(&self->cargada, memory_order_relaxed)) {
+      categoria_cargar_ahora(self);
+    }
+    pthread_mutex_unlock(&self->candado);
+  }
+  return self->n_palabras > 0;
+}
+
+/**
+ * Carga las palabras de @self, ya sea de su archivo o revisando las que le
+ * prestaron, y la marca como cargada aunque no se haya podido, para no
+ * volverlo a intentar en cada palabra. No toma el candado.
+ *
+ * Returns: true si se pudo cargar
+ */
+bool categoria_cargar_ahora(Categoria *self)
+{
+  uint64_t inicio = metricas_ahora();
+  bool correcto;
+
+  if (self->archivo != NULL) {
+    correcto = categoria_abrir_indice(self) || categoria_mapear_archivo(self);
+  } else {
+    correcto = categoria_validar_datos(self);
+  }
+  if (!correcto) {
+    self->n_palabras = 0;
+  }
+  categoria_clasificar_ahora(self);
+
+  metricas_cargar_categoria(self->nombre, inicio, metricas_ahora());
+  atomic_store_explicit(&self->cargada, true, memory_order_release);
+
+  return correcto;
+}
+
+/**
+ * Si la lista de @self tiene un índice al día, o es tan grande que vale la
+ * pena generarlo, deja a @self leyendo sus palabras del archivo en lugar de
+ * cargarlas. Así una lista de cien millones de palabras no ocupa memoria más
+ * que por las páginas del índice que se tocan.
+ *
+ * Returns: true si @self quedó indexada
+ */
+bool categoria_abrir_indice(Categoria *self)
+{
+  Indice *idx = indice_abrir(self->archivo);
+  int fd;
+
+  if (idx == NULL && self->archivo_size >= CATEGORIA_INDICE_MINIMO
+      && indice_generar(self->archivo)) {
+    idx = indice_abrir(self->archivo);
+  }
+  if (idx == NULL) {
+    return false;
+  }
+
+  fd = open(self->archivo, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    indice_cerrar(idx);
+    return false;
+  }
+  self->idx = idx;
+  self->fd = fd;
+  self->n_palabras = indice_get_n_palabras(idx);
+
+  return true;
+}
+
+/**
+ * Revisa que cada entrada de @palabras quede dentro de @datos y termine en
+ * NUL, para que una tabla dañada (o de otro paquete) no haga que se lea
+ * fuera de @datos
+ *
+ * @datos Las palabras
+ * @datos_len La longitud de @datos
+ * @palabras La tabla de palabras dentro de @datos
+ * @n_palabras El número de entradas en @palabras
+ *
+ * Returns: true si todas las entradas son válidas
+ */
+bool categoria_validar_palabras(const char             *datos,
+                                size_t                  datos_len,
+                                const CategoriaPalabra *palabras,
+                                size_t                  n_palabras)
+{
+  if (n_palabras > 0 && (datos == NULL || palabras == NULL)) {
+    return false;
+  }
+  for (size_t i = 0; i < n_palabras; i++) {
+    uint64_t fin = (uint64_t) palabras[i].offset + palabras[i].longitud;
+
+    if (fin >= datos_len || datos[fin] != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Revisa que las palabras prestadas a @self sean UTF-8 válido y que cada
+ * entrada de su tabla quede dentro de los datos. Aunque el paquete se
+ * generó a partir de listas ya validadas, no sabemos de dónde salió el
+ * archivo; revisarlo completo es barato, y después categoria_get_palabra()
+ * ya no tiene que revisar nada.
+ *
+ * Returns: true si son válidas
+ */
+bool categoria_validar_datos(Categoria *self)
+{
+  if (!categoria_validar_palabras(self->datos, self->datos_len,
+                                  self->palabras, self->n_palabras)) {
+    fprintf (stderr, "La categoría %s tiene palabras fuera de sus datos\n",
+                     self->nombre);
+    return false;
+  }
+  if (!u8_validar(self->datos, self->datos_len, NULL)) {
+    fprintf (stderr, "La categoría %s no es UTF-8 válido\n", self->nombre);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Lee las palabras del archivo de @self.
+ *
+ * En lugar de leer el archivo línea por línea y copiar cada palabra, lo
+ * mapeamos completo en memoria, solo para leer, y anotamos dónde empieza y
+ * cuánto mide cada línea. Las palabras se sirven directamente desde el
+ * mapeo y nunca lo escribimos, así que sus páginas son las mismas del caché
+ * de archivos: cargar una lista no aloja nada por palabra ni copia el
+ * archivo.
+ *
+ * Returns: true si se pudo leer el archivo
+ */
+bool categoria_mapear_archivo(Categoria *self)
+{
+  struct stat info;
+  char *mapa;
+  int fd;
+
+  fd = open(self->archivo, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    fprintf (stderr, "No se pudo abrir el archivo %s para la categoría %s\n",
+                     self->archivo, self->nombre);
+    return false;
+  }
+
+  // El archivo pudo cambiar desde que se registró la categoría. Las listas
+  // más grandes que CATEGORIA_LONGITUD_MAXIMA solo sirven indexadas.
+  if (fstat(fd, &info) == -1 || info.st_size > CATEGORIA_LONGITUD_MAXIMA) {
+    fprintf (stderr, "El archivo %s no es válido para la categoría %s\n",
+                     self->archivo, self->nombre);
+    close(fd);
+    return false;
+  }
+  self->archivo_size = info.st_size;
+  if (info.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    fprintf (stderr, "No se pudo mapear el archivo %s para la categoría %s\n",
+                     self->archivo, self->nombre);
+    return false;
+  }
+
+  self->mapa = mapa;
+  self->mapa_size = info.st_size;
+  self->datos = mapa;
+  self->datos_len = info.st_size;
+  self->datos_size = info.st_size;
+
+  return categoria_indexar_lineas(self);
+}
+
+/**
+ * Parte los datos de @self en líneas y llena la tabla de palabras.
+ *
+ * Primero contamos las líneas para alojar la tabla una sola vez, y luego
+ * anotamos cada una sin su salto de línea (ni el \r de los archivos de
+ * Windows). Los datos no se tocan, así que estas palabras no terminan en
+ * NUL. Las líneas vacías no son palabras, así que no las registramos.
+ *
+ * Antes validamos que todo el archivo sea UTF-8, que es lo que el juego
+ * espera al decodificar las palabras. Casi siempre lo es, y de paso sabemos
+ * si es puramente ASCII; solo si no lo es revisamos línea por línea para
+ * descartar las palabras inválidas.
+ *
+ * @self La categoría, con sus datos ya mapeados
+ *
+ * Returns: true si se pudo alojar la tabla de palabras
+ */
+bool categoria_indexar_lineas(Categoria *self)
+{
+  const char *inicio, *fin, *salto;
+  CategoriaPalabra *tabla;
+  size_t n_lineas = 1, n_invalidas = 0;
+  bool valido, ascii;
+
+  inicio = self->datos;
+  fin = self->datos + self->datos_len;
+  for (salto = memchr(inicio, '\n', fin - inicio); salto != NULL;
+       salto = memchr(salto + 1, '\n', fin - salto - 1)) {
+    n_lineas++;
+  }
+
+  tabla = realloc(self->palabras, n_lineas * sizeof(CategoriaPalabra));
+  if (tabla == NULL) {
+    return false;
+  }
+  self->palabras = tabla;
+  self->buffer_size = n_lineas;
+  self->n_palabras = 0;
+
+  valido = u8_validar(inicio, fin - inicio, &ascii);
+
+  while (inicio < fin) {
+    size_t longitud;
+    bool linea_ascii = ascii;
+
+    salto = memchr(inicio, '\n', fin - inicio);
+    if (salto == NULL) {
+      salto = fin;
+    }
+    longitud = salto - inicio;
+    if (longitud > 0 && inicio[longitud - 1] == '\r') {
+      longitud--;
+    }
+    if (longitud > 0 && !valido && !u8_validar(inicio, longitud, &linea_ascii)) {
+      n_invalidas++;
+    } else if (longitud > 0) {
+      if (valido && !ascii) {
+        linea_ascii = u8_es_ascii(inicio, longitud);
+      }
+      tabla[self->n_palabras].offset = inicio - self->datos;
+      tabla[self->n_palabras].longitud = longitud;
+      tabla[self->n_palabras].ascii = linea_ascii;
+      self->n_palabras++;
+    }
+    inicio = salto + 1;
+  }
+
+  if (n_invalidas > 0) {
+    fprintf (stderr, "Se ignoraron %zu palabras de la categoría %s que no "
+                     "son UTF-8 válido\n", n_invalidas, self->nombre);
+  }
+
+  return true;
+}
+
+/**
+ * Registra @palabra en @self
+ *
+ * @self La categoría
+ *
+ * @palabra La palabra a registrar
+ *
+ * @palabra_size La longitud de la palabra, o -1 si @palabra termina en NUL
+ */
+void categoria_registrar_palabra(Categoria *self, const char *palabra,
+                                 int palabra_size)
+{
+  CategoriaPalabra *entrada;
+  if (self == NULL) {
+    return;
+  }
+  if (palabra == NULL) {
+    return;
+  }
+
+  categoria_cargar(self);
+  if (self->idx != NULL) {
+    fprintf (stderr,
+             "No se pueden agregar palabras a la categoría indexada %s\n",
+             self->nombre);
+    return;
+  }
+  if (self->n_palabras >= self->buffer_size || self->prestada) {
+    categoria_realloc(self);
+  }
+
+  if (palabra_size < 0) {
+    palabra_size = strlen(palabra);
+  }
+
+  categoria_reservar_datos(self, palabra_size + 1);
+
+  entrada = &self->palabras[self->n_palabras];
+  entrada->offset = self->datos_len;
+  entrada->longitud = palabra_size;
+  entrada->ascii = u8_es_ascii(palabra, palabra_size);
+
+  memcpy(&self->datos[self->datos_len], palabra, palabra_size);
+  self->datos[self->datos_len + palabra_size] = '\0';
+  self->datos_len += palabra_size + 1;
+
+  self->n_palabras++;
+
+  // Se vuelve a clasificar la próxima vez que se pida una dificultad
+  atomic_store(&self->clasificada, false);
+}
+
+/**
+ * Añade espacios al arreglo interno para que puedan haber más palabras.
+ * Duplicamos el tamaño cada vez, para que registrar muchas palabras no
+ * termine copiando la tabla completa en cada realojo.
+ *
+ * Si la tabla es prestada, la copiamos al heap aunque todavía tenga espacio.
+ */
+void categoria_realloc(Categoria *self) {
+  CategoriaPalabra *nuevo;
+  size_t nuevo_size;
+  if (self == NULL) {
+    return;
+  }
+
+  nuevo_size = self->buffer_size * 2;
+  if (nuevo_size < DEFAULT_N_PALABRAS) {
+    nuevo_size = DEFAULT_N_PALABRAS;
+  }
+
+  if (self->prestada) {
+    nuevo = malloc(nuevo_size * sizeof(CategoriaPalabra));
+    if (nuevo == NULL) {
+      return;
+    }
+    memcpy(nuevo, self->palabras, self->n_palabras * sizeof(CategoriaPalabra));
+  } else {
+    nuevo = realloc(self->palabras, nuevo_size * sizeof(CategoriaPalabra));
+    if (nuevo == NULL) {
+      return;
+    }
+  }
+
+  self->palabras = nuevo;
+  self->buffer_size = nuevo_size;
+}
+
+/**
+ * Se asegura de que quepan @extra bytes más en los datos de @self.
+ *
+ * Si las palabras de @self vienen de un archivo mapeado o son prestadas,
+ * antes de poder agregar otra tenemos que copiarlas al heap, porque esa
+ * memoria no puede crecer.
+ *
+ * Esta función debe llamarse después de categoria_realloc(), que es la que
+ * se encarga de la tabla de palabras.
+ */
+void categoria_reservar_datos(Categoria *self, size_t extra)
+{
+  size_t nuevo_size;
+  char *nuevo;
+
+  if (self->mapa == NULL && !self->prestada
+      && self->datos_len + extra <= self->datos_size) {
+    return;
+  }
+
+  nuevo_size = self->datos_size > 0 ? self->datos_size : DEFAULT_DATOS_SIZE;
+  while (nuevo_size < self->datos_len + extra) {
+    nuevo_size *= 2;
+  }
+
+  if (self->mapa != NULL || self->prestada) {
+    nuevo = malloc(nuevo_size);
+    if (nuevo == NULL) {
+      return;
+    }
+    memcpy(nuevo, self->datos, self->datos_len);
+    if (self->mapa != NULL) {
+      munmap(self->mapa, self->mapa_size);
+    }
+    self->mapa = NULL;
+    self->mapa_size = 0;
+    self->prestada = false;
+  } else {
+    nuevo = realloc(self->datos, nuevo_size);
+    if (nuevo == NULL) {
+      return;
+    }
+  }
+
+  self->datos = nuevo;
+  self->datos_size = nuevo_size;
+}
+
+/**
+ * Obtiene la palabra @indice dentro de @self. Las palabras de una categoría
+ * indexada no están en memoria; para ellas hay que usar
+ * categoria_leer_palabra().
+ *
+ * Las palabras que se leen de un archivo se sirven desde su mapeo y no
+ * terminan en NUL: miden categoria_get_longitud_palabra() bytes.
+ *
+ * @self La categoría
+ *
+ * @indice El índice de la palabra
+ *
+ * Returns: (transfer: None) La palabra @indice de @self ó NULL si @indice no es válido
+ * o @self está indexada
+ */
+const char *categoria_get_palabra(Categoria *self, unsigned int indice) {
+  if (self == NULL) {
+    return NULL;
+  }
+  categoria_cargar(self);
+  if (indice >= self->n_palabras || self->idx != NULL) {
+    return NULL;
+  }
+  return &self->datos[self->palabras[indice].offset];
+}
+
+/**
+ * Obtiene la palabra @indice dentro de @self, aunque @self esté indexada:
+ * en ese caso se lee del archivo con un solo pread(2) y se copia en @arena.
+ * Si no, es la misma que da categoria_get_palabra() y no se copia.
+ *
+ * @self La categoría
+ *
+ * @indice El índice de la palabra
+ *
+ * @arena Donde copiar la palabra si hay que leerla
+ *
+ * Returns: (transfer: None) La palabra @indice de @self, de
+ * categoria_get_longitud_palabra() bytes y válida hasta que se reinicie
+ * @arena, ó NULL si @indice no es válido o no se pudo leer
+ */
+const char *categoria_leer_palabra(Categoria    *self,
+                                   unsigned int  indice,
+                                   Arena        *arena)
+{
+  uint64_t offset;
+  size_t longitud, leido = 0;
+  char *palabra;
+
+  if (self == NULL) {
+    return NULL;
+  }
+  categoria_cargar(self);
+  if (self->idx == NULL) {
+    return categoria_get_palabra(self, indice);
+  }
+  if (!indice_get_palabra(self->idx, indice, &offset, &longitud, NULL)) {
+    return NULL;
+  }
+
+  palabra = arena_alojar(arena, longitud + 1);
+  if (palabra == NULL) {
+    return NULL;
+  }
+  while (leido < longitud) {
+    ssize_t n = pread(self->fd, &palabra[leido], longitud - leido,
+                      offset + leido);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // El archivo se recortó desde que se indexó
+      return NULL;
+    }
+    leido += n;
+  }
+  palabra[longitud] = '\0';
+
+  return palabra;
+}
+
+/**
+ * Obtiene la longitud en bytes de la palabra @indice dentro de @self, sin
+ * tener que recorrerla con strlen
+ *
+ * @self La categoría
+ *
+ * @indice El índice de la palabra
+ *
+ * Returns: La longitud de la palabra @indice de @self ó -1 si @indice no es válido
+ */
+int categoria_get_longitud_palabra(Categoria *self, unsigned int indice) {
+  uint64_t offset;
+  size_t longitud;
+
+  if (self == NULL) {
+    return -1;
+  }
+  categoria_cargar(self);
+  if (indice >= self->n_palabras) {
+    return -1;
+  }
+  if (self->idx != NULL) {
+    indice_get_palabra(self->idx, indice, &offset, &longitud, NULL);
+    return longitud;
+  }
+  return self->palabras[indice].longitud;
+}
+
+/**
+ * Indica si la palabra @indice dentro de @self es puramente ASCII, en cuyo
+ * caso cada byte es un caracter
+ *
+ * @self La categoría
+ *
+ * @indice El índice de la palabra
+ *
+ * Returns: true si la palabra @indice de @self es ASCII
+ */
+bool categoria_palabra_es_ascii(Categoria *self, unsigned int indice) {
+  uint64_t offset;
+  size_t longitud;
+  bool ascii;
+
+  if (self == NULL) {
+    return false;
+  }
+  categoria_cargar(self);
+  if (indice >= self->n_palabras) {
+    return false;
+  }
+  if (self->idx != NULL) {
+    indice_get_palabra(self->idx, indice, &offset, &longitud, &ascii);
+    return ascii;
+  }
+  return self->palabras[indice].ascii;
+}
+
+/**
+ * Obtiene el número de palabras de @self
+ *
+ * @self La categoría
+ *
+ * Returns: El numero de palabras en @self ó -1 si @self es NULL
+ */
+int categoria_get_n_palabras(Categoria *self) {
+  if (self == NULL) {
+    return -1;
+  }
+  categoria_cargar(self);
+  return self->n_palabras;
+}
+
+/**
+ * Obtiene cuántas palabras de @self son de la dificultad @dificultad
+ *
+ * @self La categoría
+ *
+ * @dificultad La dificultad
+ *
+ * Returns: El número de palabras de @dificultad ó -1 si @self es NULL o
+ * @dificultad no es válida. Las categorías indexadas no tienen ninguna.
+ */
+int categoria_get_n_palabras_dificultad(Categoria           *self,
+                                        CategoriaDificultad  dificultad)
+{
+  if (self == NULL || (unsigned int) dificultad >= CATEGORIA_N_DIFICULTADES) {
+    return -1;
+  }
+  categoria_clasificar(self);
+  return self->limites[dificultad + 1] - self->limites[dificultad];
+}
+
+/**
+ * Obtiene el índice de la palabra @indice entre las de dificultad
+ * @dificultad, para elegir una palabra de una dificultad sin recorrer la
+ * categoría
+ *
+ * @self La categoría
+ *
+ * @dificultad La dificultad
+ *
+ * @indice De 0 a categoria_get_n_palabras_dificultad() - 1
+ *
+ * Returns: El índice de la palabra dentro de @self ó -1 si @indice no es
+ * válido
+ */
+int categoria_get_palabra_dificultad(Categoria           *self,
+                                     CategoriaDificultad  dificultad,
+                                     unsigned int         indice)
+{
+  if (self == NULL || (unsigned int) dificultad >= CATEGORIA_N_DIFICULTADES) {
+    return -1;
+  }
+  categoria_clasificar(self);
+  if (indice >= self->limites[dificultad + 1] - self->limites[dificultad]) {
+    return -1;
+  }
+  return self->orden[self->limites[dificultad] + indice];
+}
+
+/**
+ * Clasifica las palabras de @self por dificultad si todavía no se ha hecho.
+ * Como categoria_cargar(), se puede llamar desde varios hilos a la vez.
+ */
+void categoria_clasificar(Categoria *self)
+{
+  categoria_cargar(self);
+  if (!atomic_load_explicit(&self->clasificada, memory_order_acquire)) {
+    pthread_mutex_lock(&self->candado);
+    if (!atomic_load_explicit(&self->clasificada, memory_order_relaxed)) {
+      categoria_clasificar_ahora(self);
+    }
+    pthread_mutex_unlock(&self->candado);
+  }
+}
+
+/**
+ * Puntúa todas las palabras de @self y las ordena por puntos en @orden. Los
+ * puntos van de 0 a CATEGORIA_MAX_PUNTOS, así que basta un conteo por
+ * puntos en lugar de comparar palabras: se cuenta cuántas palabras tienen
+ * cada puntaje, eso dice dónde empieza cada puntaje en @orden, y se
+ * acomodan en una sola pasada. No toma el candado.
+ */
+void categoria_clasificar_ahora(Categoria *self)
+{
+  size_t conteo[CATEGORIA_MAX_PUNTOS + 2] = { 0 };
+  uint8_t *puntos;
+
+  free(self->orden);
+  self->orden = NULL;
+  memset(self->limites, 0, sizeof(self->limites));
+
+  if (self->idx != NULL || self->n_palabras == 0) {
+    atomic_store_explicit(&self->clasificada, true, memory_order_release);
+    return;
+  }
+
+  puntos = malloc(self->n_palabras);
+  for (size_t i = 0; i < self->n_palabras; i++) {
+    const CategoriaPalabra *palabra = &self->palabras[i];
+
+    puntos[i] = categoria_puntuar_palabra(&self->datos[palabra->offset],
+                                          palabra->longitud, palabra->ascii);
+    conteo[puntos[i] + 1]++;
+  }
+  // Ahora conteo[p] es dónde empiezan las palabras con p puntos
+  for (size_t p = 1; p <= CATEGORIA_MAX_PUNTOS; p++) {
+    conteo[p] += conteo[p - 1];
+  }
+
+  self->orden = malloc(self->n_palabras * sizeof(uint32_t));
+  for (size_t i = 0; i < self->n_palabras; i++) {
+    self->orden[conteo[puntos[i]]++] = i;
+  }
+  free(puntos);
+
+  for (size_t d = 0; d <= CATEGORIA_N_DIFICULTADES; d++) {
+    self->limites[d] = d * self->n_palabras / CATEGORIA_N_DIFICULTADES;
+  }
+
+  atomic_store_explicit(&self->clasificada, true, memory_order_release);
+}
+
+/**
+ * Calcula qué tan difícil es adivinar @palabra: entre más letras distintas
+ * tenga hay que revelar más, y cada letra rara (CATEGORIA_LETRAS_RARAS, o
+ * cualquiera fuera del alfabeto) probablemente cuesta una vida. Las
+ * palabras largas repiten más letras, así que cada caracter resta un poco.
+ *
+ * Las letras se comparan por su llave plegada, igual que en el juego, y
+ * los espacios no cuentan.
+ *
+ * @palabra La palabra, en UTF-8
+ * @len Cuántos bytes mide @palabra
+ * @ascii Si @palabra es puramente ASCII
+ *
+ * Returns: Los puntos de @palabra, de 0 a CATEGORIA_MAX_PUNTOS
+ */
+unsigned int categoria_puntuar_palabra(const char *palabra,
+                                       size_t      len,
+                                       bool        ascii)
+{
+  uint32_t letras[CATEGORIA_MAX_LETRAS];
+  size_t n_letras = 0, n_caracteres = 0, n_raras = 0;
+  long puntos;
+
+  for (size_t i = 0; i < len;) {
+    uint32_t clave;
+    size_t j, n = 1;
+
+    if (ascii) {
+      clave = char_minuscula(palabra[i]);
+    } else {
+      clave = u8_plegar(u8_decodificar(&palabra[i], len - i, &n));
+    }
+    i += n;
+    if (clave == ' ') {
+      continue;
+    }
+    n_caracteres++;
+
+    for (j = 0; j < n_letras && letras[j] != clave; j++);
+    if (j < n_letras || n_letras == CATEGORIA_MAX_LETRAS) {
+      continue;
+    }
+    letras[n_letras++] = clave;
+    if (clave >= 0x80 ? clave != 0xF1 /* ñ */
+                      : clave < 'a' || clave > 'z'
+                        || strchr(CATEGORIA_LETRAS_RARAS, clave) != NULL) {
+      n_raras++;
+    }
+  }
+
+  puntos = 2 * n_letras + 4 * n_raras - n_caracteres / 2;
+  if (puntos < 0) {
+    return 0;
+  }
+  return puntos < CATEGORIA_MAX_PUNTOS ? puntos : CATEGORIA_MAX_PUNTOS;
+}
+
+/**
+ * Retorna la representación en cadena de caracteres de @dificultad
+ *
+ * Returns: (transfer: none) El nombre de @dificultad, para mostrarlo
+ */
+const char *categoria_dificultad_to_string(CategoriaDificultad dificultad)
+{
+  switch (dificultad) {
+  case CATEGORIA_FACIL:
+    return "fácil";
+  case CATEGORIA_MEDIA:
+    return "media";
+  case CATEGORIA_DIFICIL:
+    return "difícil";
+  case CATEGORIA_N_DIFICULTADES:
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * Obteiene el nombre de @self
+ *
+ * @self La categoría
+ *
+ * Returns: (transfer: none) El nombre de @self
+ */
+const char *categoria_get_nombre(Categoria *self) {
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->nombre;
+}
+
+void categoria_destruir(Categoria *self) {
+  if (self == NULL) {
+    return;
+  }
+  if (self->mapa != NULL) {
+    munmap(self->mapa, self->mapa_size);
+    free(self->palabras);
+  } else if (!self->prestada) {
+    free(self->datos);
+    free(self->palabras);
+  }
+  if (self->idx != NULL) {
+    indice_cerrar(self->idx);
+    close(self->fd);
+  }
+  free(self->archivo);
+  free(self->orden);
+  pthread_mutex_destroy(&self->candado);
+  if (!self->en_arena) {
+    free(self->nombre);
+    free(self);
+  }
+}
@@ -0,0 +1,80 @@
+/* categoria.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+/**
+ * Una entrada en la tabla de palabras de una categoría.
+ *
+ * En vez de guardar un puntero por palabra, guardamos en qué posición de
+ * los datos de la categoría empieza y cuánto mide. Así la misma tabla nos
+ * sirve para palabras que viven en el heap, dentro de un archivo mapeado en
+ * memoria o dentro de un paquete de recursos, y no tenemos que alojar nada
+ * por palabra.
+ *
+ * @ascii dice si la palabra es puramente ASCII, para que el juego pueda
+ * tratarla byte por byte sin decodificar UTF-8.
+ */
+typedef struct {
+  uint32_t offset;
+  uint32_t longitud : 31;
+  uint32_t ascii : 1;
+} CategoriaPalabra;
+
+/* La palabra más larga que cabe en CategoriaPalabra */
+#define CATEGORIA_LONGITUD_MAXIMA 0x7FFFFFFF
+
+/**
+ * Qué tan difícil es adivinar una palabra. Al cargar una categoría, sus
+ * palabras se ordenan por puntos (ver categoria_puntuar_palabra()) y se
+ * reparten en tercios: el de menos puntos son las fáciles y el de más las
+ * difíciles.
+ */
+typedef enum {
+  CATEGORIA_FACIL,
+  CATEGORIA_MEDIA,
+  CATEGORIA_DIFICIL,
+  CATEGORIA_N_DIFICULTADES
+} CategoriaDificultad;
+
+/*
+ * Vamos a crear una estructura opaca para que no se puedan modificar
+ * los campos de la categoría más que dentro del mismo código de la categoría
+ */
+struct __Categoria;
+typedef struct __Categoria Categoria;
+
+Categoria *categoria_nueva(const char *nombre);
+Categoria *categoria_nueva_perezosa(const char *, const char *);
+Categoria *categoria_nueva_desde_archivo(const char *, const char *);
+Categoria *categoria_nueva_desde_memoria(const char *, const char *, size_t,
+                                         const CategoriaPalabra *, size_t,
+                                         Arena *);
+bool categoria_validar_palabras(const char *, size_t, const CategoriaPalabra *,
+                                size_t);
+bool categoria_cargar(Categoria *);
+const char *categoria_get_nombre(Categoria *);
+void categoria_registrar_palabra(Categoria *, const char *, int);
+const char *categoria_get_palabra(Categoria *, unsigned int);
+const char *categoria_leer_palabra(Categoria *, unsigned int, Arena *);
+int categoria_get_longitud_palabra(Categoria *, unsigned int);
+bool categoria_palabra_es_ascii(Categoria *, unsigned int);
+int categoria_get_n_palabras(Categoria *);
+int categoria_get_n_palabras_dificultad(Categoria *, CategoriaDificultad);
+int categoria_get_palabra_dificultad(Categoria *, CategoriaDificultad,
+                                     unsigned int);
+unsigned int categoria_puntuar_palabra(const char *, size_t, bool);
+const char *categoria_dificultad_to_string(CategoriaDificultad);
+void categoria_destruir(Categoria *);
@@ -0,0 +1,297 @@
+/* empaquetar.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * Herramienta que se corre al compilar para juntar las listas de palabras y
+ * las texturas de src/recursos en un solo paquete (.pak). Ver paquete.h para
+ * el formato.
+ *
+ * Uso: adivinador-empaquetar [--c] SALIDA [-c NOMBRE ARCHIVO | -t NOMBRE ARCHIVO]...
+ *
+ * Con --c, en vez del .pak se escribe un archivo de C que contiene el paquete
+ * como un arreglo constante, para meterlo dentro del ejecutable.
+ *
+ * O: adivinador-empaquetar --idx LISTA...
+ *
+ * genera el índice (ver indice.h) de cada lista, para no tener que generarlo
+ * la primera vez que se juega con ella.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "categoria.h"
+#include "indice.h"
+#include "paquete.h"
+#include "textura.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+/**
+ * Una entrada del paquete mientras la armamos. Las texturas se guardan igual
+ * que las categorías: cada linea es una "palabra".
+ */
+typedef struct {
+  PaqueteTipo tipo;
+  const char *nombre;
+  Categoria *palabras;
+  PaqueteEntrada entrada;
+} Pieza;
+
+Categoria *leer_textura(const char *, const char *);
+size_t alinear(size_t);
+bool escribir_paquete(FILE *, Pieza *, size_t);
+bool escribir_c(const char *, const unsigned char *, size_t);
+void escribir_relleno(FILE *, size_t);
+
+int main(int argc,
+         char **argv)
+{
+  Pieza *piezas;
+  size_t n_piezas = 0;
+  const char *salida;
+  bool exito, en_c = false;
+  FILE *stream;
+  char *buffer = NULL;
+  size_t buffer_size = 0;
+  int primero = 2;
+
+  if (argc > 1 && strcmp(argv[1], "--idx") == 0) {
+    for (int i = 2; i < argc; i++) {
+      if (!indice_generar(argv[i])) {
+        fprintf (stderr, "No se pudo generar el índice de %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--c") == 0) {
+    en_c = true;
+    primero++;
+  }
+
+  if (argc < primero || (argc - primero) % 3 != 0) {
+    fprintf (stderr, "Uso: %s [--c] SALIDA [-c NOMBRE ARCHIVO | -t NOMBRE ARCHIVO]...\n",
+             argv[0]);
+    return EXIT_FAILURE;
+  }
+  salida = argv[primero - 1];
+
+  piezas = calloc((argc - primero) / 3 + 1, sizeof(Pieza));
+  for (int i = primero; i < argc; i += 3) {
+    Pieza *pieza = &piezas[n_piezas];
+
+    if (strcmp(argv[i], "-c") == 0) {
+      pieza->tipo = PAQUETE_CATEGORIA;
+      pieza->palabras = categoria_nueva_desde_archivo(argv[i + 1], argv[i + 2]);
+    } else if (strcmp(argv[i], "-t") == 0) {
+      pieza->tipo = PAQUETE_TEXTURA;
+      pieza->palabras = leer_textura(argv[i + 1], argv[i + 2]);
+    } else {
+      fprintf (stderr, "Opción desconocida: %s\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+
+    if (pieza->palabras == NULL) {
+      fprintf (stderr, "No se pudo leer %s\n", argv[i + 2]);
+      return EXIT_FAILURE;
+    }
+    pieza->nombre = argv[i + 1];
+    n_piezas++;
+  }
+
+  if (en_c) {
+    stream = open_memstream(&buffer, &buffer_size);
+  } else {
+    stream = fopen(salida, "wb");
+  }
+  if (stream == NULL) {
+    fprintf (stderr, "No se pudo crear %s\n", salida);
+    return EXIT_FAILURE;
+  }
+
+  exito = escribir_paquete(stream, piezas, n_piezas);
+  if (fclose(stream) != 0) {
+    fprintf (stderr, "No se pudo escribir %s\n", salida);
+    exito = false;
+  }
+  if (exito && en_c) {
+    exito = escribir_c(salida, (const unsigned char *) buffer, buffer_size);
+  }
+  free(buffer);
+
+  for (size_t i = 0; i < n_piezas; i++) {
+    categoria_destruir(piezas[i].palabras);
+  }
+  free(piezas);
+
+  return exito ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Lee la textura en @archivo y guarda sus lineas como palabras de una
+ * categoría, para poder escribirlas igual que las listas de palabras. A
+ * diferencia de las palabras, aquí sí importan las lineas vacías.
+ */
+Categoria *leer_textura(const char *nombre,
+                        const char *archivo)
+{
+  Textura *textura;
+  Categoria *lineas;
+
+  textura = textura_nueva_desde_archivo(archivo);
+  if (textura == NULL) {
+    return NULL;
+  }
+
+  lineas = categoria_nueva(nombre);
+  for (int i = 0; i < textura_get_altura(textura); i++) {
+    categoria_registrar_palabra(lineas, textura_get_linea(textura, i),
+                                textura_get_longitud_linea(textura, i));
+  }
+  textura_liberar(textura);
+
+  return lineas;
+}
+
+size_t alinear(size_t offset)
+{
+  return (offset + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+void escribir_relleno(FILE *stream, size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    fputc(0, stream);
+  }
+}
+
+/**
+ * Escribe @piezas en @stream. Primero calculamos dónde va a quedar cada cosa
+ * y después escribimos todo de corrido.
+ */
+bool escribir_paquete(FILE  *stream,
+                      Pieza *piezas,
+                      size_t n_piezas)
+{
+  PaqueteCabecera cabecera;
+  size_t offset, nombres_len = 0, escrito;
+
+  memset(&cabecera, 0, sizeof(cabecera));
+  memcpy(cabecera.magia, PAQUETE_MAGIA, sizeof(PAQUETE_MAGIA));
+  cabecera.version = PAQUETE_VERSION;
+  cabecera.n_entradas = n_piezas;
+  cabecera.entradas_offset = alinear(sizeof(PaqueteCabecera));
+
+  for (size_t i = 0; i < n_piezas; i++) {
+    piezas[i].entrada.tipo = piezas[i].tipo;
+    piezas[i].entrada.nombre = nombres_len;
+    nombres_len += strlen(piezas[i].nombre) + 1;
+  }
+  cabecera.nombres_offset = cabecera.entradas_offset
+                            + n_piezas * sizeof(PaqueteEntrada);
+  cabecera.nombres_len = nombres_len;
+
+  offset = alinear(cabecera.nombres_offset + nombres_len);
+  for (size_t i = 0; i < n_piezas; i++) {
+    PaqueteEntrada *entrada = &piezas[i].entrada;
+    Categoria *palabras = piezas[i].palabras;
+    size_t datos_len = 0;
+
+    entrada->n_palabras = categoria_get_n_palabras(palabras);
+    for (size_t j = 0; j < entrada->n_palabras; j++) {
+      datos_len += categoria_get_longitud_palabra(palabras, j) + 1;
+    }
+
+    entrada->palabras_offset = offset;
+    entrada->datos_offset = offset + entrada->n_palabras
+                                     * sizeof(CategoriaPalabra);
+    entrada->datos_len = datos_len;
+    offset = alinear(entrada->datos_offset + datos_len);
+    if (offset > UINT32_MAX) {
+      fprintf (stderr, "El paquete no cabe en 4 GiB\n");
+      return false;
+    }
+  }
+  cabecera.size = offset;
+
+  fwrite(&cabecera, sizeof(cabecera), 1, stream);
+  escribir_relleno(stream, cabecera.entradas_offset - sizeof(cabecera));
+  for (size_t i = 0; i < n_piezas; i++) {
+    fwrite(&piezas[i].entrada, sizeof(PaqueteEntrada), 1, stream);
+  }
+  for (size_t i = 0; i < n_piezas; i++) {
+    fwrite(piezas[i].nombre, strlen(piezas[i].nombre) + 1, 1, stream);
+  }
+  escrito = cabecera.nombres_offset + nombres_len;
+
+  for (size_t i = 0; i < n_piezas; i++) {
+    PaqueteEntrada *entrada = &piezas[i].entrada;
+    Categoria *palabras = piezas[i].palabras;
+    CategoriaPalabra fila = { 0, 0 };
+
+    escribir_relleno(stream, entrada->palabras_offset - escrito);
+    for (size_t j = 0; j < entrada->n_palabras; j++) {
+      fila.longitud = categoria_get_longitud_palabra(palabras, j);
+      fila.ascii = categoria_palabra_es_ascii(palabras, j);
+      fwrite(&fila, sizeof(fila), 1, stream);
+      fila.offset += fila.longitud + 1;
+    }
+    for (size_t j = 0; j < entrada->n_palabras; j++) {
+      // Las palabras de un archivo no terminan en NUL; el paquete sí
+      fwrite(categoria_get_palabra(palabras, j),
+             categoria_get_longitud_palabra(palabras, j), 1, stream);
+      fputc('\0', stream);
+    }
+    escrito = entrada->datos_offset + entrada->datos_len;
+  }
+  escribir_relleno(stream, cabecera.size - escrito);
+
+  return ferror(stream) == 0;
+}
+
+/**
+ * Escribe en @camino un archivo de C con los @size bytes de @paquete como un
+ * arreglo constante. Lo alineamos igual que un mmap para poder leer las tablas
+ * del paquete directamente.
+ */
+bool escribir_c(const char          *camino,
+                const unsigned char *paquete,
+                size_t               size)
+{
+  FILE *stream;
+
+  stream = fopen(camino, "w");
+  if (stream == NULL) {
+    fprintf (stderr, "No se pudo crear %s\n", camino);
+    return false;
+  }
+
+  fprintf (stream, "/* Generado por adivinador-empaquetar. No editar. */\n\n");
+  fprintf (stream, "#include <stddef.h>\n\n");
+  fprintf (stream, "extern const unsigned char recursos_embebidos[];\n");
+  fprintf (stream, "extern const size_t recursos_embebidos_size;\n\n");
+  fprintf (stream, "__attribute__((aligned(16)))\n");
+  fprintf (stream, "const unsigned char recursos_embebidos[] = {");
+  for (size_t i = 0; i < size; i++) {
+    fprintf (stream, i % 12 == 0 ? "\n  0x%02x," : " 0x%02x,", paquete[i]);
+  }
+  fprintf (stream, "\n};\n\n");
+  fprintf (stream, "const size_t recursos_embebidos_size = %zu;\n", size);
+
+  if (fclose(stream) != 0) {
+    fprintf (stderr, "No se pudo escribir %s\n", camino);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# generar-corpus.py
+#
+# Copyright 2023 Diego Iván M.E
+# Copyright 2023 Juan Pablo Alquicer
+# Copyright 2023 Mariana García
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""
+Genera una lista de palabras sintética, con el formato de las de
+recursos/categorias/ (una palabra por línea, en UTF-8), para medir el juego
+con listas mucho más grandes que las reales.
+
+Las palabras se arman con sílabas del español y se parecen a las de las
+listas reales: miden unos 8 caracteres, alrededor de una de cada cuatro
+tiene un acento, una ñ o una ü, y una de cada siete tiene más de una
+palabra ("Estados Unidos"). La misma semilla da siempre la misma lista.
+
+Uso: generar-corpus.py SALIDA [N_PALABRAS] [SEMILLA]
+"""
+
+import random
+import sys
+
+ATAQUES = ['', 'b', 'c', 'ch', 'd', 'f', 'g', 'j', 'l', 'll', 'm', 'n', 'p',
+           'qu', 'r', 'rr', 's', 't', 'v', 'y', 'z', 'br', 'cr', 'pl', 'tr']
+NUCLEOS = ['a', 'e', 'i', 'o', 'u'] * 4 + ['ia', 'ie', 'ue', 'ua']
+CODAS = [''] * 6 + ['n', 's', 'r', 'l']
+ACENTOS = {'a': 'á', 'e': 'é', 'i': 'í', 'o': 'ó', 'u': 'ú'}
+
+# Qué tanto aparecen en las listas de recursos/categorias/
+PROPORCION_ACENTOS = 0.24
+PROPORCION_ESPACIOS = 0.14
+
+
+# Todas las sílabas posibles, para elegir una con un solo número al azar
+SILABAS = [a + n + c for a in ATAQUES for n in NUCLEOS for c in CODAS]
+
+
+def palabra(azar):
+    """Una palabra de 2 a 4 sílabas, quizá con un acento, una ñ o una ü."""
+    n_silabas = 2 if azar.random() < 0.45 else 3 if azar.random() < 0.8 else 4
+    texto = ''.join(azar.choices(SILABAS, k=n_silabas))
+
+    if azar.random() < PROPORCION_ACENTOS:
+        especial = azar.random()
+        if especial < 0.1 and 'n' in texto:
+            i = texto.index('n')
+            texto = texto[:i] + 'ñ' + texto[i + 1:]
+        elif especial < 0.12 and 'gu' in texto:
+            i = texto.index('gu')
+            texto = texto[:i] + 'gü' + texto[i + 2:]
+        else:
+            vocales = [i for i, c in enumerate(texto) if c in ACENTOS]
+            i = azar.choice(vocales)
+            texto = texto[:i] + ACENTOS[texto[i]] + texto[i + 1:]
+
+    return texto[0].upper() + texto[1:]
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+
+    n_palabras = int(sys.argv[2]) if len(sys.argv) > 2 else 2000000
+    azar = random.Random(int(sys.argv[3]) if len(sys.argv) > 3 else 1)
+
+    with open(sys.argv[1], 'w', encoding='utf-8') as salida:
+        for _ in range(n_palabras):
+            linea = palabra(azar)
+            if azar.random() < PROPORCION_ESPACIOS:
+                linea += ' ' + palabra(azar)
+            salida.write(linea + '\n')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# generar-tablas-u8.py
+#
+# Copyright 2023 Diego Iván M.E
+# Copyright 2023 Juan Pablo Alquicer
+# Copyright 2023 Mariana García
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""
+Genera u8-tablas.h, las tablas con la minúscula, la mayúscula y la letra
+base (sin acento y en minúscula) de cada caracter, desde U+0000 hasta el
+final de Latin Extended-A (U+017F).
+
+Las tablas son de dos niveles: u8_paginas lleva de los bits altos del código
+a un bloque de U8_PAGINA caracteres en u8_bloques, y cada casilla del bloque
+guarda cuánto hay que sumarle al código para obtener el resultado. Como lo
+que se guarda es la diferencia, todos los bloques que no cambian nada (como
+el de los signos de puntuación) son el mismo bloque de ceros.
+
+Uso: generar-tablas-u8.py SALIDA
+"""
+
+import sys
+import unicodedata
+
+ULTIMO = 0x17F
+PAGINA = 64
+
+# En español la ñ es otra letra, no una n con tilde
+BASES_PROPIAS = {'ñ': 'ñ', 'Ñ': 'ñ'}
+
+
+def simple(convertido, c):
+    """Solo usamos conversiones de un caracter a un caracter."""
+    return convertido if len(convertido) == 1 else c
+
+
+def base(c):
+    if c in BASES_PROPIAS:
+        return BASES_PROPIAS[c]
+    descompuesto = unicodedata.normalize('NFD', c)[0]
+    return simple(descompuesto.lower(), descompuesto)
+
+
+def casilla(codigo):
+    c = chr(codigo)
+    return (ord(simple(c.lower(), c)) - codigo,
+            ord(simple(c.upper(), c)) - codigo,
+            ord(base(c)) - codigo)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('Uso: generar-tablas-u8.py SALIDA', file=sys.stderr)
+        return 1
+
+    bloques = []
+    paginas = []
+    for inicio in range(0, ULTIMO + 1, PAGINA):
+        bloque = tuple(casilla(c) for c in range(inicio, inicio + PAGINA))
+        if bloque not in bloques:
+            bloques.append(bloque)
+        paginas.append(bloques.index(bloque))
+
+    with open(sys.argv[1], 'w', encoding='utf-8') as salida:
+        salida.write('/* Generado por generar-tablas-u8.py con Unicode %s. '
+                     'No editar. */\n\n' % unicodedata.unidata_version)
+        salida.write('#pragma once\n\n#include <stdint.h>\n\n')
+        salida.write('#define U8_ULTIMO_TABULADO 0x%X\n' % ULTIMO)
+        salida.write('#define U8_PAGINA %d\n\n' % PAGINA)
+        salida.write('typedef struct {\n  int16_t minuscula;\n'
+                     '  int16_t mayuscula;\n  int16_t base;\n} U8Casilla;\n\n')
+
+        salida.write('static const uint8_t u8_paginas[] = {\n')
+        salida.write('  %s,\n};\n\n' % ', '.join(str(p) for p in paginas))
+
+        salida.write('static const U8Casilla u8_bloques[][U8_PAGINA] = {\n')
+        for bloque in bloques:
+            salida.write('  {\n')
+            for i in range(0, PAGINA, 4):
+                salida.write('   ')
+                for c in bloque[i:i + 4]:
+                    salida.write(' { %d, %d, %d },' % c)
+                salida.write('\n')
+            salida.write('  },\n')
+        salida.write('};\n')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,281 @@
+/* indice.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "indice.h"
+#include "u8.h"
+
+/**
+ * El índice se mapea completo, pero solo de lectura y sin copiarlo, así que
+ * solo ocupan memoria las páginas de las entradas que se leen
+ */
+struct __Indice {
+  void *mapa;
+  size_t mapa_size;
+  const uint64_t *entradas;
+  size_t n_palabras;
+};
+
+char *indice_camino(const char *);
+bool indice_escribir(int, FILE *, const struct stat *);
+
+/**
+ * Returns: (transfer: full) El camino del índice de la lista @lista
+ */
+char *indice_camino(const char *lista)
+{
+  size_t len = strlen(lista);
+  char *camino = malloc(len + sizeof(".idx"));
+
+  memcpy(camino, lista, len);
+  memcpy(&camino[len], ".idx", sizeof(".idx"));
+  return camino;
+}
+
+/**
+ * Genera el índice de la lista de palabras @lista. Se escribe primero en un
+ * archivo temporal que luego se renombra, así que otro proceso que abra el
+ * índice al mismo tiempo nunca ve uno a medias.
+ *
+ * @lista El camino a la lista de palabras
+ *
+ * Returns: true si se pudo escribir el índice
+ */
+bool indice_generar(const char *lista)
+{
+  char *camino, *temporal;
+  struct stat info;
+  FILE *salida;
+  bool correcto;
+  int fd;
+
+  if (lista == NULL) {
+    return false;
+  }
+
+  fd = open(lista, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  if (fstat(fd, &info) == -1) {
+    close(fd);
+    return false;
+  }
+
+  camino = indice_camino(lista);
+  temporal = malloc(strlen(camino) + 32);
+  sprintf(temporal, "%s.%ld", camino, (long) getpid());
+
+  salida = fopen(temporal, "wb");
+  if (salida == NULL) {
+    free(temporal);
+    free(camino);
+    close(fd);
+    return false;
+  }
+
+  correcto = indice_escribir(fd, salida, &info);
+  correcto = fclose(salida) == 0 && correcto;
+  if (correcto) {
+    correcto = rename(temporal, camino) == 0;
+  }
+  if (!correcto) {
+    unlink(temporal);
+  }
+
+  free(temporal);
+  free(camino);
+  close(fd);
+
+  return correcto;
+}
+
+/**
+ * Recorre la lista abierta en @fd, de tamaño @info, y escribe en @salida la
+ * cabecera y una entrada por palabra.
+ *
+ * La lista se mapea solo de lectura: no escribimos en ella como al cargar
+ * una categoría, así que sus páginas se pueden volver a tirar en cuanto
+ * pasamos por ellas y generar el índice de una lista enorme no ocupa su
+ * tamaño en memoria.
+ */
+bool indice_escribir(int                fd,
+                     FILE              *salida,
+                     const struct stat *info)
+{
+  IndiceCabecera cabecera = { INDICE_MAGIA, INDICE_VERSION };
+  const char *datos, *inicio, *fin;
+  void *mapa;
+
+  cabecera.lista_size = info->st_size;
+  cabecera.lista_mtime_s = info->st_mtim.tv_sec;
+  cabecera.lista_mtime_ns = info->st_mtim.tv_nsec;
+
+  // La cabecera definitiva se escribe al final, ya con el número de palabras
+  if (fwrite(&cabecera, sizeof(cabecera), 1, salida) != 1) {
+    return false;
+  }
+  if (info->st_size == 0) {
+    return true;
+  }
+
+  mapa = mmap(NULL, info->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapa == MAP_FAILED) {
+    return false;
+  }
+  madvise(mapa, info->st_size, MADV_SEQUENTIAL);
+
+  datos = mapa;
+  fin = datos + info->st_size;
+  for (inicio = datos; inicio < fin;) {
+    const char *salto = memchr(inicio, '\n', fin - inicio);
+    size_t longitud;
+    bool ascii;
+
+    if (salto == NULL) {
+      salto = fin;
+    }
+    longitud = salto - inicio;
+    if (longitud > 0 && inicio[longitud - 1] == '\r') {
+      longitud--;
+    }
+
+    // Las mismas palabras que se quedan al indexar una categoría
+    if (longitud > 0 && longitud <= INDICE_LONGITUD_MAXIMA
+        && (uint64_t) (inicio - datos) < UINT64_C(1) << INDICE_OFFSET_BITS
+        && u8_validar(inicio, longitud, &ascii)) {
+      uint64_t entrada = (uint64_t) (inicio - datos)
+                         | (uint64_t) longitud << INDICE_OFFSET_BITS
+                         | (uint64_t) ascii << 63;
+
+      if (fwrite(&entrada, sizeof(entrada), 1, salida) != 1) {
+        munmap(mapa, info->st_size);
+        return false;
+      }
+      cabecera.n_palabras++;
+    }
+    inicio = salto + 1;
+  }
+  munmap(mapa, info->st_size);
+
+  return fseek(salida, 0, SEEK_SET) == 0
+         && fwrite(&cabecera, sizeof(cabecera), 1, salida) == 1;
+}
+
+/**
+ * Abre el índice de la lista de palabras @lista, si existe y sigue al día
+ * con la lista
+ *
+ * @lista El camino a la lista de palabras
+ *
+ * Returns: (transfer: full) El índice, o NULL si no hay uno que sirva
+ */
+Indice *indice_abrir(const char *lista)
+{
+  const IndiceCabecera *cabecera;
+  struct stat info_lista, info;
+  Indice *self;
+  char *camino;
+  void *mapa;
+  int fd;
+
+  if (lista == NULL || stat(lista, &info_lista) == -1) {
+    return NULL;
+  }
+
+  camino = indice_camino(lista);
+  fd = open(camino, O_RDONLY | O_CLOEXEC);
+  free(camino);
+  if (fd == -1) {
+    return NULL;
+  }
+  if (fstat(fd, &info) == -1 || info.st_size < sizeof(IndiceCabecera)) {
+    close(fd);
+    return NULL;
+  }
+  mapa = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return NULL;
+  }
+
+  cabecera = mapa;
+  if (memcmp(cabecera->magia, INDICE_MAGIA, sizeof(cabecera->magia)) != 0
+      || cabecera->version != INDICE_VERSION
+      || cabecera->n_palabras != (info.st_size - sizeof(IndiceCabecera))
+                                 / sizeof(uint64_t)
+      || cabecera->lista_size != (uint64_t) info_lista.st_size
+      || cabecera->lista_mtime_s != info_lista.st_mtim.tv_sec
+      || cabecera->lista_mtime_ns != info_lista.st_mtim.tv_nsec) {
+    munmap(mapa, info.st_size);
+    return NULL;
+  }
+
+  self = malloc(sizeof(Indice));
+  self->mapa = mapa;
+  self->mapa_size = info.st_size;
+  self->entradas = (const uint64_t *) (cabecera + 1);
+  self->n_palabras = cabecera->n_palabras;
+
+  return self;
+}
+
+size_t indice_get_n_palabras(Indice *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->n_palabras;
+}
+
+/**
+ * Dice dónde está la palabra @indice dentro de la lista
+ *
+ * @offset (out) Dónde empieza la palabra
+ * @longitud (out) Cuántos bytes mide
+ * @ascii (out) (nullable) Si es puramente ASCII
+ *
+ * Returns: false si @indice no es válido
+ */
+bool indice_get_palabra(Indice   *self,
+                        size_t    indice,
+                        uint64_t *offset,
+                        size_t   *longitud,
+                        bool     *ascii)
+{
+  uint64_t entrada;
+
+  if (self == NULL || indice >= self->n_palabras) {
+    return false;
+  }
+
+  entrada = self->entradas[indice];
+  *offset = entrada & ((UINT64_C(1) << INDICE_OFFSET_BITS) - 1);
+  *longitud = (entrada >> INDICE_OFFSET_BITS) & INDICE_LONGITUD_MAXIMA;
+  if (ascii != NULL) {
+    *ascii = entrada >> 63;
+  }
+  return true;
+}
+
+void indice_cerrar(Indice *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  munmap(self->mapa, self->mapa_size);
+  free(self);
+}
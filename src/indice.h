@@ -0,0 +1,60 @@
+/* indice.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Un índice (.idx) dice dónde empieza cada palabra de una lista de palabras,
+ * para poder leer solo la palabra que se necesita con un pread(2) sin cargar
+ * la lista. Vive junto a la lista ("paises.txt.idx") y se genera la primera
+ * vez que se usa una lista grande, o al compilar con adivinador-empaquetar
+ * --idx:
+ *
+ *   IndiceCabecera
+ *   uint64_t[n_palabras]
+ *
+ * Cada entrada junta el offset de la palabra en la lista (40 bits), su
+ * longitud en bytes (23 bits) y si es ASCII (el bit más alto). Las palabras
+ * son las mismas que toma una Categoria al leer la lista: sin líneas vacías
+ * ni líneas que no sean UTF-8 válido.
+ *
+ * La cabecera guarda el tamaño y la fecha de modificación de la lista; si la
+ * lista cambió, el índice ya no sirve y se vuelve a generar.
+ */
+#define INDICE_MAGIA "ADVNIDX"
+#define INDICE_VERSION 1
+
+#define INDICE_OFFSET_BITS 40
+#define INDICE_LONGITUD_BITS 23
+
+/* La palabra más larga que cabe en una entrada */
+#define INDICE_LONGITUD_MAXIMA ((UINT64_C(1) << INDICE_LONGITUD_BITS) - 1)
+
+typedef struct {
+  char     magia[8];
+  uint32_t version;
+  uint32_t reservado;
+  uint64_t n_palabras;
+  uint64_t lista_size;
+  int64_t  lista_mtime_s;
+  int64_t  lista_mtime_ns;
+} IndiceCabecera;
+
+struct __Indice;
+typedef struct __Indice Indice;
+
+bool indice_generar(const char *);
+Indice *indice_abrir(const char *);
+size_t indice_get_n_palabras(Indice *);
+bool indice_get_palabra(Indice *, size_t, uint64_t *, size_t *, bool *);
+void indice_cerrar(Indice *);
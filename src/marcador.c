@@ -0,0 +1,442 @@
+/* marcador.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "marcador.h"
+
+/* Cuántas veces se cede el procesador esperando a que otro proceso termine
+ * de ocupar un registro antes de darlo por abandonado */
+#define MARCADOR_ESPERAS 1000
+
+/**
+ * Un registro del archivo. Solo @clave y @listo sirven para ocuparlo; @tipo
+ * y @nombre no cambian después de que @listo se enciende.
+ */
+typedef struct {
+  _Atomic uint64_t clave;
+  _Atomic uint32_t listo;
+  uint32_t tipo;
+  char nombre[MARCADOR_NOMBRE];
+  _Atomic uint64_t ganadas;
+  _Atomic uint64_t perdidas;
+  _Atomic uint64_t vidas;
+  _Atomic uint64_t racha;
+  _Atomic uint64_t mejor_racha;
+  uint64_t reservado[2];
+} MarcadorRegistro;
+
+_Static_assert(sizeof(MarcadorRegistro) == MARCADOR_REGISTRO,
+               "Cambió el tamaño de los registros del marcador");
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+               "El marcador necesita atómicos de 64 bits sin candados");
+
+struct __Marcador {
+  void *mapa;
+  size_t mapa_size;
+  MarcadorRegistro *registros;
+  size_t n_registros;
+  atomic_bool lleno;
+};
+
+bool marcador_crear(const char *);
+void *marcador_mapear(const char *, int, size_t *);
+size_t marcador_copiar_nombre(char *, const char *);
+uint64_t marcador_clave(MarcadorTipo, const char *, size_t);
+MarcadorRegistro *marcador_buscar(Marcador *, MarcadorTipo, const char *);
+void marcador_anotar_registro(MarcadorRegistro *, bool, int);
+int marcador_comparar_filas(const void *, const void *);
+
+/**
+ * Abre el marcador @archivo para anotar en él, y lo crea si no existe
+ *
+ * Returns: (transfer: full) El marcador, o NULL si no se pudo abrir
+ */
+Marcador *marcador_abrir(const char *archivo)
+{
+  Marcador *self;
+  size_t mapa_size;
+  void *mapa;
+
+  if (archivo == NULL) {
+    return NULL;
+  }
+
+  mapa = marcador_mapear(archivo, O_RDWR, &mapa_size);
+  if (mapa == NULL && errno == ENOENT) {
+    // Si otro proceso lo creó primero, marcador_crear() falla pero el suyo
+    // ya está en su lugar
+    marcador_crear(archivo);
+    mapa = marcador_mapear(archivo, O_RDWR, &mapa_size);
+  }
+  if (mapa == NULL) {
+    fprintf(stderr, "No se pudo abrir el marcador %s\n", archivo);
+    return NULL;
+  }
+
+  self = malloc(sizeof(Marcador));
+  self->mapa = mapa;
+  self->mapa_size = mapa_size;
+  self->registros = (MarcadorRegistro *) ((MarcadorCabecera *) mapa + 1);
+  self->n_registros = (mapa_size - sizeof(MarcadorCabecera)) / sizeof(MarcadorRegistro);
+  atomic_init(&self->lleno, false);
+
+  return self;
+}
+
+/**
+ * Crea un marcador vacío en @archivo, si no existe. Se escribe completo en
+ * un temporal que después se enlaza; a diferencia de rename(2), link(2) no
+ * reemplaza un marcador que otro proceso haya creado mientras tanto.
+ *
+ * Returns: true si se creó
+ */
+bool marcador_crear(const char *archivo)
+{
+  MarcadorCabecera cabecera = { MARCADOR_MAGIA, MARCADOR_VERSION,
+                                sizeof(MarcadorRegistro) };
+  char *temporal = malloc(strlen(archivo) + 32);
+  bool correcto;
+  int fd;
+
+  sprintf(temporal, "%s.%ld", archivo, (long) getpid());
+  fd = open(temporal, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    free(temporal);
+    return false;
+  }
+
+  // Los registros vacíos son ceros, así que basta con agrandar el archivo
+  correcto = write(fd, &cabecera, sizeof(cabecera)) == sizeof(cabecera)
+             && ftruncate(fd, sizeof(cabecera)
+                              + MARCADOR_REGISTROS * sizeof(MarcadorRegistro)) == 0;
+  correcto = close(fd) == 0 && correcto;
+  correcto = correcto && link(temporal, archivo) == 0;
+
+  unlink(temporal);
+  free(temporal);
+  return correcto;
+}
+
+/**
+ * Mapea el marcador @archivo y revisa su cabecera
+ *
+ * @modo O_RDONLY u O_RDWR
+ * @mapa_size (out) El tamaño del mapa
+ *
+ * Returns: El mapa, o NULL (con errno) si no se pudo abrir o no es un
+ * marcador
+ */
+void *marcador_mapear(const char *archivo,
+                      int         modo,
+                      size_t     *mapa_size)
+{
+  const MarcadorCabecera *cabecera;
+  struct stat info;
+  void *mapa;
+  int fd;
+
+  fd = open(archivo, modo | O_CLOEXEC);
+  if (fd == -1) {
+    return NULL;
+  }
+  if (fstat(fd, &info) == -1) {
+    close(fd);
+    return NULL;
+  }
+  if (info.st_size < sizeof(MarcadorCabecera) + sizeof(MarcadorRegistro)
+      || (info.st_size - sizeof(MarcadorCabecera)) % sizeof(MarcadorRegistro) != 0) {
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  mapa = mmap(NULL, info.st_size,
+              modo == O_RDONLY ? PROT_READ : PROT_READ | PROT_WRITE,
+              MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return NULL;
+  }
+
+  cabecera = mapa;
+  if (memcmp(cabecera->magia, MARCADOR_MAGIA, sizeof(cabecera->magia)) != 0
+      || cabecera->version != MARCADOR_VERSION
+      || cabecera->registro_size != sizeof(MarcadorRegistro)) {
+    munmap(mapa, info.st_size);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  *mapa_size = info.st_size;
+  return mapa;
+}
+
+/**
+ * Anota una partida terminada de @jugador en @categoria
+ *
+ * @jugador (nullable) Quién jugó; sin él solo se anota la categoría
+ * @categoria (nullable) El nombre de la categoría
+ * @ganada Si se ganó la partida
+ * @vidas Las vidas que sobraron
+ */
+void marcador_anotar(Marcador   *self,
+                     const char *jugador,
+                     const char *categoria,
+                     bool        ganada,
+                     int         vidas)
+{
+  MarcadorRegistro *registro;
+
+  if (self == NULL) {
+    return;
+  }
+
+  if (jugador != NULL) {
+    registro = marcador_buscar(self, MARCADOR_JUGADOR, jugador);
+    marcador_anotar_registro(registro, ganada, vidas);
+  }
+  if (categoria != NULL) {
+    registro = marcador_buscar(self, MARCADOR_CATEGORIA, categoria);
+    marcador_anotar_registro(registro, ganada, vidas);
+  }
+}
+
+void marcador_anotar_registro(MarcadorRegistro *registro,
+                              bool              ganada,
+                              int               vidas)
+{
+  uint64_t racha, mejor;
+
+  if (registro == NULL) {
+    return;
+  }
+
+  if (!ganada) {
+    atomic_fetch_add_explicit(&registro->perdidas, 1, memory_order_relaxed);
+    atomic_store_explicit(&registro->racha, 0, memory_order_relaxed);
+    return;
+  }
+
+  atomic_fetch_add_explicit(&registro->ganadas, 1, memory_order_relaxed);
+  if (vidas > 0) {
+    atomic_fetch_add_explicit(&registro->vidas, vidas, memory_order_relaxed);
+  }
+
+  // Si otro proceso del mismo jugador pierde al mismo tiempo, la racha
+  // puede quedar con una victoria de más o de menos, pero la mejor racha
+  // nunca baja
+  racha = atomic_fetch_add_explicit(&registro->racha, 1, memory_order_relaxed) + 1;
+  mejor = atomic_load_explicit(&registro->mejor_racha, memory_order_relaxed);
+  while (racha > mejor
+         && !atomic_compare_exchange_weak_explicit(&registro->mejor_racha,
+                                                   &mejor, racha,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed)) {
+  }
+}
+
+/**
+ * Busca el registro de @nombre, y lo ocupa si todavía no tiene
+ *
+ * Returns: (transfer: none) El registro, o NULL si el marcador está lleno
+ */
+MarcadorRegistro *marcador_buscar(Marcador     *self,
+                                  MarcadorTipo  tipo,
+                                  const char   *nombre)
+{
+  char recortado[MARCADOR_NOMBRE];
+  size_t len = marcador_copiar_nombre(recortado, nombre);
+  uint64_t clave = marcador_clave(tipo, recortado, len);
+  size_t i = clave % self->n_registros;
+
+  for (size_t n = 0; n < self->n_registros; n++) {
+    MarcadorRegistro *registro = &self->registros[i];
+    uint64_t actual = atomic_load_explicit(&registro->clave, memory_order_acquire);
+    unsigned int esperas = 0;
+
+    if (actual == 0) {
+      if (atomic_compare_exchange_strong_explicit(&registro->clave, &actual,
+                                                  clave, memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+        registro->tipo = tipo;
+        memcpy(registro->nombre, recortado, sizeof(recortado));
+        atomic_store_explicit(&registro->listo, 1, memory_order_release);
+        return registro;
+      }
+      // Alguien más lo ocupó primero; quizá con el mismo nombre
+    }
+
+    if (actual == clave) {
+      // Quien lo ocupó está copiando el nombre; si el proceso murió a la
+      // mitad, el registro se queda así y seguimos buscando
+      while (!atomic_load_explicit(&registro->listo, memory_order_acquire)
+             && esperas++ < MARCADOR_ESPERAS) {
+        sched_yield();
+      }
+      if (atomic_load_explicit(&registro->listo, memory_order_acquire)
+          && registro->tipo == tipo
+          && memcmp(registro->nombre, recortado, sizeof(recortado)) == 0) {
+        return registro;
+      }
+    }
+
+    i = i + 1 < self->n_registros ? i + 1 : 0;
+  }
+
+  if (!atomic_exchange(&self->lleno, true)) {
+    fprintf(stderr, "El marcador está lleno; ya no se anotan jugadores ni "
+            "categorías nuevas\n");
+  }
+  return NULL;
+}
+
+/**
+ * Copia @nombre a @destino (de MARCADOR_NOMBRE bytes, rellenando con
+ * ceros), recortado sin partir un carácter de UTF-8
+ *
+ * Returns: Los bytes que se copiaron
+ */
+size_t marcador_copiar_nombre(char       *destino,
+                              const char *nombre)
+{
+  size_t len = strnlen(nombre, MARCADOR_NOMBRE);
+
+  if (len == MARCADOR_NOMBRE) {
+    len--;
+    while (len > 0 && ((unsigned char) nombre[len] & 0xC0) == 0x80) {
+      len--;
+    }
+  }
+  memset(destino, 0, MARCADOR_NOMBRE);
+  memcpy(destino, nombre, len);
+  return len;
+}
+
+/**
+ * Returns: El hash FNV-1a de @tipo y @nombre, que nunca es 0
+ */
+uint64_t marcador_clave(MarcadorTipo  tipo,
+                        const char   *nombre,
+                        size_t        len)
+{
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  hash = (hash ^ (uint8_t) tipo) * UINT64_C(1099511628211);
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t) nombre[i]) * UINT64_C(1099511628211);
+  }
+  return hash != 0 ? hash : 1;
+}
+
+void marcador_cerrar(Marcador *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  munmap(self->mapa, self->mapa_size);
+  free(self);
+}
+
+/**
+ * Lee el marcador @archivo de una pasada, en orden, y junta lo de cada
+ * jugador y cada categoría. Un nombre solo aparece en dos registros si un
+ * proceso murió mientras ocupaba el primero.
+ *
+ * @n_filas (out) Cuántas filas hay
+ *
+ * Returns: (transfer: full) Las filas, primero los jugadores y luego las
+ * categorías, cada uno por nombre; o NULL si no se pudo leer
+ */
+MarcadorFila *marcador_leer(const char *archivo,
+                            size_t     *n_filas)
+{
+  const MarcadorRegistro *registros;
+  MarcadorFila *filas;
+  size_t mapa_size, n_registros, n = 0;
+  void *mapa;
+
+  *n_filas = 0;
+  if (archivo == NULL) {
+    return NULL;
+  }
+  mapa = marcador_mapear(archivo, O_RDONLY, &mapa_size);
+  if (mapa == NULL) {
+    return NULL;
+  }
+  madvise(mapa, mapa_size, MADV_SEQUENTIAL);
+
+  registros = (const MarcadorRegistro *) ((const MarcadorCabecera *) mapa + 1);
+  n_registros = (mapa_size - sizeof(MarcadorCabecera)) / sizeof(MarcadorRegistro);
+  filas = malloc(n_registros * sizeof(MarcadorFila));
+
+  for (size_t i = 0; i < n_registros; i++) {
+    const MarcadorRegistro *registro = &registros[i];
+    MarcadorFila *fila = &filas[n];
+
+    if (!atomic_load_explicit(&registro->listo, memory_order_acquire)
+        || (registro->tipo != MARCADOR_JUGADOR
+            && registro->tipo != MARCADOR_CATEGORIA)) {
+      continue;
+    }
+    fila->tipo = registro->tipo;
+    memcpy(fila->nombre, registro->nombre, sizeof(fila->nombre));
+    fila->nombre[MARCADOR_NOMBRE - 1] = '\0';
+    fila->ganadas = atomic_load_explicit(&registro->ganadas, memory_order_relaxed);
+    fila->perdidas = atomic_load_explicit(&registro->perdidas, memory_order_relaxed);
+    fila->vidas = atomic_load_explicit(&registro->vidas, memory_order_relaxed);
+    fila->racha = atomic_load_explicit(&registro->racha, memory_order_relaxed);
+    fila->mejor_racha = atomic_load_explicit(&registro->mejor_racha,
+                                             memory_order_relaxed);
+    n++;
+  }
+  munmap(mapa, mapa_size);
+
+  // Juntamos los registros repetidos, que quedan uno junto al otro
+  qsort(filas, n, sizeof(MarcadorFila), marcador_comparar_filas);
+  for (size_t i = 0; i < n; i++) {
+    MarcadorFila *anterior = *n_filas > 0 ? &filas[*n_filas - 1] : NULL;
+
+    if (anterior != NULL && marcador_comparar_filas(anterior, &filas[i]) == 0) {
+      anterior->ganadas += filas[i].ganadas;
+      anterior->perdidas += filas[i].perdidas;
+      anterior->vidas += filas[i].vidas;
+      if (filas[i].racha > anterior->racha) {
+        anterior->racha = filas[i].racha;
+      }
+      if (filas[i].mejor_racha > anterior->mejor_racha) {
+        anterior->mejor_racha = filas[i].mejor_racha;
+      }
+    } else {
+      filas[(*n_filas)++] = filas[i];
+    }
+  }
+
+  return filas;
+}
+
+int marcador_comparar_filas(const void *a,
+                            const void *b)
+{
+  const MarcadorFila *fila_a = a, *fila_b = b;
+
+  if (fila_a->tipo != fila_b->tipo) {
+    return fila_a->tipo < fila_b->tipo ? -1 : 1;
+  }
+  return strcmp(fila_a->nombre, fila_b->nombre);
+}
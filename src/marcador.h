@@ -0,0 +1,78 @@
+/* marcador.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * El marcador guarda cuántas partidas ha ganado y perdido cada jugador y
+ * cada categoría, su racha de victorias y las vidas que le sobraron. Vive en
+ * un archivo de tamaño fijo que cada proceso mapea completo; varios
+ * adivinador pueden anotar en él al mismo tiempo sin candados, porque cada
+ * contador se actualiza con operaciones atómicas directamente en el mapa:
+ *
+ *   MarcadorCabecera
+ *   registro[n_registros]       (MARCADOR_REGISTRO bytes cada uno)
+ *
+ * Los registros forman una tabla hash de direccionamiento abierto. Un
+ * registro libre tiene clave 0; para ocuparlo, un proceso cambia la clave
+ * (el hash del tipo y el nombre) con compare-and-swap, copia el nombre y lo
+ * marca como listo. Nunca se borran, así que no hay que mover nada.
+ *
+ * El archivo se crea completo en un temporal que luego se enlaza con
+ * link(2), así que nadie ve uno a medias.
+ */
+#define MARCADOR_MAGIA "ADVNMRC"
+#define MARCADOR_VERSION 1
+
+/* Cuántos jugadores y categorías caben en un marcador nuevo */
+#define MARCADOR_REGISTROS 4096
+
+#define MARCADOR_REGISTRO 128
+
+/* Los nombres más largos se recortan */
+#define MARCADOR_NOMBRE 56
+
+typedef struct {
+  char     magia[8];
+  uint32_t version;
+  uint32_t registro_size;
+} MarcadorCabecera;
+
+typedef enum {
+  MARCADOR_JUGADOR = 1,
+  MARCADOR_CATEGORIA
+} MarcadorTipo;
+
+/**
+ * Lo que lleva un jugador o una categoría. @vidas es la suma de las vidas
+ * que sobraron en las partidas ganadas, y @racha las victorias seguidas
+ * hasta la última partida.
+ */
+typedef struct {
+  MarcadorTipo tipo;
+  char nombre[MARCADOR_NOMBRE];
+  uint64_t ganadas;
+  uint64_t perdidas;
+  uint64_t vidas;
+  uint64_t racha;
+  uint64_t mejor_racha;
+} MarcadorFila;
+
+struct __Marcador;
+typedef struct __Marcador Marcador;
+
+Marcador *marcador_abrir(const char *);
+void marcador_anotar(Marcador *, const char *, const char *, bool, int);
+void marcador_cerrar(Marcador *);
+
+MarcadorFila *marcador_leer(const char *, size_t *);
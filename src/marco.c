@@ -0,0 +1,216 @@
+/* marco.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "marco.h"
+
+#define DEFAULT_MARCO_SIZE 1024
+
+struct __Marco {
+  char *datos;
+  size_t len;
+  size_t size;
+};
+
+void marco_reservar(Marco *, size_t);
+
+Marco *marco_nuevo(void)
+{
+  Marco *self;
+
+  self = malloc(sizeof(Marco));
+  self->datos = malloc(DEFAULT_MARCO_SIZE);
+  self->len = 0;
+  self->size = DEFAULT_MARCO_SIZE;
+
+  return self;
+}
+
+/**
+ * Se asegura de que quepan @extra bytes más en @self
+ */
+void marco_reservar(Marco *self, size_t extra)
+{
+  if (self->len + extra <= self->size) {
+    return;
+  }
+  while (self->len + extra > self->size) {
+    self->size *= 2;
+  }
+  self->datos = realloc(self->datos, self->size);
+}
+
+/**
+ * Agrega @len bytes de @texto al final de @self
+ */
+void marco_agregar(Marco      *self,
+                   const char *texto,
+                   size_t      len)
+{
+  if (self == NULL || texto == NULL) {
+    return;
+  }
+  marco_reservar(self, len);
+  memcpy(&self->datos[self->len], texto, len);
+  self->len += len;
+}
+
+void marco_agregar_cadena(Marco      *self,
+                          const char *texto)
+{
+  if (texto == NULL) {
+    return;
+  }
+  marco_agregar(self, texto, strlen(texto));
+}
+
+/**
+ * Agrega @n veces @c al final de @self, por ejemplo, para rellenar con
+ * espacios una linea
+ */
+void marco_agregar_relleno(Marco *self,
+                           char   c,
+                           size_t n)
+{
+  if (self == NULL) {
+    return;
+  }
+  marco_reservar(self, n);
+  memset(&self->datos[self->len], c, n);
+  self->len += n;
+}
+
+/**
+ * Agrega texto con formato al final de @self, igual que printf()
+ */
+void marco_printf(Marco      *self,
+                  const char *formato,
+                  ...)
+{
+  va_list args;
+  int len;
+
+  if (self == NULL || formato == NULL) {
+    return;
+  }
+
+  va_start(args, formato);
+  len = vsnprintf(&self->datos[self->len], self->size - self->len, formato, args);
+  va_end(args);
+  if (len < 0) {
+    return;
+  }
+
+  // No cupo: hacemos espacio y volvemos a intentar
+  if (self->len + len >= self->size) {
+    marco_reservar(self, len + 1);
+    va_start(args, formato);
+    vsnprintf(&self->datos[self->len], self->size - self->len, formato, args);
+    va_end(args);
+  }
+  self->len += len;
+}
+
+/**
+ * Returns: (transfer: none) Lo que se ha armado en @self. No termina en NUL.
+ */
+const char *marco_get_datos(Marco *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->datos;
+}
+
+size_t marco_get_len(Marco *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->len;
+}
+
+/**
+ * Descarta lo que se ha armado en @self, pero se queda con su memoria
+ */
+void marco_vaciar(Marco *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->len = 0;
+}
+
+/**
+ * Descarta los primeros @n bytes de @self y recorre el resto al inicio, por
+ * ejemplo, cuando un socket solo aceptó parte de lo que se armó
+ */
+void marco_descartar(Marco  *self,
+                     size_t  n)
+{
+  if (self == NULL) {
+    return;
+  }
+  if (n >= self->len) {
+    self->len = 0;
+    return;
+  }
+  memmove(self->datos, &self->datos[n], self->len - n);
+  self->len -= n;
+}
+
+/**
+ * Manda todo lo que se ha armado en @self a @fd y vacía @self.
+ *
+ * Se escribe con una sola llamada a write(2); solo si la terminal acepta
+ * menos bytes de los que le dimos se vuelve a llamar con lo que falta. Quien
+ * también escriba con printf debe hacer fflush(stdout) antes, para que no se
+ * desordene la salida.
+ *
+ * Returns: true si se pudo escribir todo
+ */
+bool marco_volcar(Marco *self,
+                  int    fd)
+{
+  size_t escrito = 0;
+
+  if (self == NULL) {
+    return false;
+  }
+
+  while (escrito < self->len) {
+    ssize_t n = write(fd, &self->datos[escrito], self->len - escrito);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      self->len = 0;
+      return false;
+    }
+    escrito += n;
+  }
+  self->len = 0;
+
+  return true;
+}
+
+void marco_destruir(Marco *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  free(self->datos);
+  free(self);
+}
@@ -0,0 +1,34 @@
+/* marco.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Un marco es un buffer donde se arma una pantalla completa antes de
+ * mandarla a la terminal con un solo write(2). El buffer se reutiliza entre
+ * cuadros, así que después del primero ya no se aloja memoria.
+ */
+struct __Marco;
+typedef struct __Marco Marco;
+
+Marco *marco_nuevo(void);
+void marco_agregar(Marco *, const char *, size_t);
+void marco_agregar_cadena(Marco *, const char *);
+void marco_agregar_relleno(Marco *, char, size_t);
+void marco_printf(Marco *, const char *, ...)
+  __attribute__((format(printf, 2, 3)));
+const char *marco_get_datos(Marco *);
+size_t marco_get_len(Marco *);
+void marco_vaciar(Marco *);
+void marco_descartar(Marco *, size_t);
+bool marco_volcar(Marco *, int);
+void marco_destruir(Marco *);
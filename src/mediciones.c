@@ -0,0 +1,612 @@
+/* mediciones.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * adivinador-bench: mide las partes del juego que más se repiten. Cada
+ * medición imprime una línea de JSON por resultado, así que se pueden
+ * comparar entre versiones con cualquier herramienta:
+ *
+ *   {"medicion": "carga", "ops": 2000000, "ns_op": 41.2, "bytes_op": 12.7}
+ *
+ * @ns_op es lo que tarda cada operación (el menor de varias rondas, que es
+ * el menos afectado por el ruido) y @bytes_op cuántos bytes procesa. Qué es
+ * una operación depende de la medición; se describe en cada una.
+ *
+ * Uso:
+ *   adivinador-bench carga CORPUS
+ *   adivinador-bench texturas TEXTURA...
+ *   adivinador-bench revelar CORPUS
+ *   adivinador-bench u8 CORPUS
+ *   adivinador-bench dibujar
+ *   adivinador-bench indice CORPUS
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "azar.h"
+#include "indice.h"
+#include "marco.h"
+#include "palabra.h"
+#include "pantalla.h"
+#include "partida.h"
+#include "recursos.h"
+#include "textura.h"
+#include "u8.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+/* Cada medición se repite hasta juntar este tiempo y al menos 3 rondas */
+#define MEDICION_SEGUNDOS 0.5
+#define MEDICION_MIN_RONDAS 3
+
+/* Cuántas palabras del corpus se juegan en "revelar" */
+#define MEDICION_PALABRAS 100000
+
+/* Cuántas palabras al azar se leen en "indice" por ronda */
+#define MEDICION_LECTURAS 100000
+
+/* Las letras que se intentan en "revelar", en orden de frecuencia */
+#define ALFABETO "eaosrnidlctumpbgvyqhfzjñxkw"
+
+/**
+ * Lo que se mide: una función que hace una ronda completa con @datos y
+ * regresa cuántas operaciones hizo
+ */
+typedef size_t (*Medible)(void *datos);
+
+typedef struct {
+  const char *archivo;
+  const char *const *archivos;
+  size_t n_archivos;
+  Categoria *categoria;
+  Partida *partida;
+  const char *texto;
+  size_t len;
+  uint32_t *codigos;
+  size_t n_codigos;
+  Pantalla *pantalla;
+  Recursos *recursos;
+  Arena *arena;
+  Azar azar;
+  size_t bytes;
+} Medicion;
+
+double medicion_ahora(void);
+void medicion_reportar(const char *, size_t, double, double);
+double medicion_correr(Medible, void *, size_t *);
+char *medicion_leer_archivo(const char *, size_t *);
+
+int medir_carga(const char *);
+size_t medir_carga_ronda(void *);
+int medir_texturas(const char *const *, size_t);
+size_t medir_texturas_ronda(void *);
+int medir_revelar(const char *);
+size_t medir_revelar_elegir(void *);
+size_t medir_revelar_intentos(void *);
+int medir_u8(const char *);
+size_t medir_u8_validar(void *);
+size_t medir_u8_es_ascii(void *);
+size_t medir_u8_decodificar(void *);
+size_t medir_u8_plegar(void *);
+int medir_dibujar(void);
+size_t medir_dibujar_ronda(void *);
+int medir_indice(const char *);
+size_t medir_indice_generar(void *);
+size_t medir_indice_leer(void *);
+
+int main(int argc,
+         char **argv)
+{
+  if (argc >= 3 && strcmp(argv[1], "carga") == 0) {
+    return medir_carga(argv[2]);
+  }
+  if (argc >= 3 && strcmp(argv[1], "texturas") == 0) {
+    return medir_texturas((const char *const *) &argv[2], argc - 2);
+  }
+  if (argc >= 3 && strcmp(argv[1], "revelar") == 0) {
+    return medir_revelar(argv[2]);
+  }
+  if (argc >= 3 && strcmp(argv[1], "u8") == 0) {
+    return medir_u8(argv[2]);
+  }
+  if (argc >= 2 && strcmp(argv[1], "dibujar") == 0) {
+    return medir_dibujar();
+  }
+  if (argc >= 3 && strcmp(argv[1], "indice") == 0) {
+    return medir_indice(argv[2]);
+  }
+
+  fprintf(stderr,
+          "Uso: %s carga CORPUS\n"
+          "     %s texturas TEXTURA...\n"
+          "     %s revelar CORPUS\n"
+          "     %s u8 CORPUS\n"
+          "     %s dibujar\n"
+          "     %s indice CORPUS\n",
+          argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+  return EXIT_FAILURE;
+}
+
+double medicion_ahora(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+void medicion_reportar(const char *nombre,
+                       size_t      ops,
+                       double      ns_op,
+                       double      bytes_op)
+{
+  printf("{\"medicion\": \"%s\", \"ops\": %zu, \"ns_op\": %.3f, "
+         "\"bytes_op\": %.3f}\n", nombre, ops, ns_op, bytes_op);
+}
+
+/**
+ * Corre rondas de @medible hasta juntar MEDICION_SEGUNDOS
+ *
+ * @ops (out) Cuántas operaciones hace cada ronda
+ *
+ * Returns: Los nanosegundos por operación de la ronda más rápida
+ */
+double medicion_correr(Medible  medible,
+                       void    *datos,
+                       size_t  *ops)
+{
+  double total = 0, mejor = -1;
+  int rondas = 0;
+
+  while (total < MEDICION_SEGUNDOS || rondas < MEDICION_MIN_RONDAS) {
+    double inicio = medicion_ahora(), duracion;
+
+    *ops = medible(datos);
+    duracion = medicion_ahora() - inicio;
+    if (mejor < 0 || duracion < mejor) {
+      mejor = duracion;
+    }
+    total += duracion;
+    rondas++;
+  }
+
+  return *ops > 0 ? mejor * 1e9 / *ops : 0;
+}
+
+/**
+ * Returns: (transfer: full) Todo el contenido de @archivo, o NULL
+ */
+char *medicion_leer_archivo(const char *archivo,
+                            size_t     *len)
+{
+  struct stat info;
+  char *datos;
+  size_t leido = 0;
+  int fd = open(archivo, O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0 || fstat(fd, &info) < 0) {
+    fprintf(stderr, "No se pudo leer %s\n", archivo);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return NULL;
+  }
+
+  datos = malloc(info.st_size + 1);
+  while (leido < (size_t) info.st_size) {
+    ssize_t n = read(fd, &datos[leido], info.st_size - leido);
+    if (n <= 0) {
+      break;
+    }
+    leido += n;
+  }
+  close(fd);
+  datos[leido] = '\0';
+  *len = leido;
+
+  return datos;
+}
+
+/**
+ * carga: una operación es una palabra de la lista al cargarla con
+ * categoria_nueva_desde_archivo()
+ */
+int medir_carga(const char *archivo)
+{
+  Medicion medicion = { .archivo = archivo };
+  struct stat info;
+  size_t ops;
+  double ns_op;
+
+  if (stat(archivo, &info) < 0) {
+    fprintf(stderr, "No se pudo leer %s\n", archivo);
+    return EXIT_FAILURE;
+  }
+
+  ns_op = medicion_correr(medir_carga_ronda, &medicion, &ops);
+  medicion_reportar("carga", ops, ns_op, ops > 0 ? (double) info.st_size / ops : 0);
+  return EXIT_SUCCESS;
+}
+
+size_t medir_carga_ronda(void *datos)
+{
+  Medicion *medicion = datos;
+  Categoria *categoria = categoria_nueva_desde_archivo("Corpus", medicion->archivo);
+  size_t n = categoria_get_n_palabras(categoria);
+
+  categoria_destruir(categoria);
+  return n;
+}
+
+/**
+ * texturas: una operación es una textura cargada con
+ * textura_nueva_desde_archivo()
+ */
+int medir_texturas(const char *const *archivos,
+                   size_t             n_archivos)
+{
+  Medicion medicion = { .archivos = archivos, .n_archivos = n_archivos };
+  size_t ops;
+  double ns_op;
+
+  for (size_t i = 0; i < n_archivos; i++) {
+    struct stat info;
+
+    if (stat(archivos[i], &info) < 0) {
+      fprintf(stderr, "No se pudo leer %s\n", archivos[i]);
+      return EXIT_FAILURE;
+    }
+    medicion.bytes += info.st_size;
+  }
+
+  ns_op = medicion_correr(medir_texturas_ronda, &medicion, &ops);
+  medicion_reportar("texturas", ops, ns_op, (double) medicion.bytes / n_archivos);
+  return EXIT_SUCCESS;
+}
+
+size_t medir_texturas_ronda(void *datos)
+{
+  Medicion *medicion = datos;
+
+  for (size_t i = 0; i < medicion->n_archivos; i++) {
+    textura_liberar(textura_nueva_desde_archivo(medicion->archivos[i]));
+  }
+  return medicion->n_archivos;
+}
+
+/**
+ * revelar: juega las primeras MEDICION_PALABRAS palabras del corpus
+ * intentando letras en orden de frecuencia. Se reportan dos resultados:
+ * "revelar.elegir", donde una operación es empezar una ronda con una
+ * palabra (decodificarla y armar su índice), y "revelar.intento", donde una
+ * operación es un partida_intentar_caracter(), sin contar lo de elegir.
+ */
+int medir_revelar(const char *archivo)
+{
+  Medicion medicion = { 0 };
+  size_t n_palabras, ops_elegir, ops_intentos;
+  double ns_elegir, ns_total;
+
+  medicion.categoria = categoria_nueva_desde_archivo("Corpus", archivo);
+  if (medicion.categoria == NULL) {
+    return EXIT_FAILURE;
+  }
+  medicion.partida = partida_nueva();
+
+  n_palabras = categoria_get_n_palabras(medicion.categoria);
+  if (n_palabras > MEDICION_PALABRAS) {
+    n_palabras = MEDICION_PALABRAS;
+  }
+  for (size_t i = 0; i < n_palabras; i++) {
+    medicion.bytes += categoria_get_longitud_palabra(medicion.categoria, i);
+  }
+
+  ns_elegir = medicion_correr(medir_revelar_elegir, &medicion, &ops_elegir);
+  ns_total = medicion_correr(medir_revelar_intentos, &medicion, &ops_intentos);
+
+  medicion_reportar("revelar.elegir", ops_elegir, ns_elegir,
+                    ops_elegir > 0 ? (double) medicion.bytes / ops_elegir : 0);
+  if (ops_intentos > 0) {
+    // Lo que tardaron las rondas completas menos lo que tardó elegir
+    double ns_intento = (ns_total * ops_intentos - ns_elegir * ops_elegir)
+                        / ops_intentos;
+    medicion_reportar("revelar.intento", ops_intentos, ns_intento, 0);
+  }
+
+  partida_destruir(medicion.partida);
+  categoria_destruir(medicion.categoria);
+  return EXIT_SUCCESS;
+}
+
+size_t medir_revelar_elegir(void *datos)
+{
+  Medicion *medicion = datos;
+  size_t n = categoria_get_n_palabras(medicion->categoria);
+
+  if (n > MEDICION_PALABRAS) {
+    n = MEDICION_PALABRAS;
+  }
+  for (size_t i = 0; i < n; i++) {
+    partida_elegir_palabra_indice(medicion->partida, medicion->categoria, i);
+  }
+  return n;
+}
+
+size_t medir_revelar_intentos(void *datos)
+{
+  Medicion *medicion = datos;
+  size_t n = categoria_get_n_palabras(medicion->categoria), intentos = 0;
+  size_t alfabeto_len = strlen(ALFABETO);
+
+  if (n > MEDICION_PALABRAS) {
+    n = MEDICION_PALABRAS;
+  }
+  for (size_t i = 0; i < n; i++) {
+    size_t j = 0;
+
+    partida_elegir_palabra_indice(medicion->partida, medicion->categoria, i);
+    while (j < alfabeto_len
+           && partida_get_estado(medicion->partida) == PARTIDA_EN_CURSO) {
+      size_t consumidos;
+
+      u8_decodificar(&ALFABETO[j], alfabeto_len - j, &consumidos);
+      partida_intentar_caracter(medicion->partida, &ALFABETO[j]);
+      j += consumidos;
+      intentos++;
+    }
+  }
+  return intentos;
+}
+
+/**
+ * u8: los ayudantes de UTF-8 sobre el corpus completo. En "u8.validar" una
+ * operación es el corpus entero; en "u8.es_ascii", una línea (como al
+ * marcar las palabras ASCII), y en "u8.decodificar" y "u8.plegar", un
+ * caracter.
+ */
+int medir_u8(const char *archivo)
+{
+  Medicion medicion = { 0 };
+  size_t ops;
+  double ns_op;
+
+  medicion.texto = medicion_leer_archivo(archivo, &medicion.len);
+  if (medicion.texto == NULL) {
+    return EXIT_FAILURE;
+  }
+  medicion.codigos = malloc((medicion.len + 1) * sizeof(uint32_t));
+  medicion.n_codigos = u8_decodificar_cadena(medicion.texto, medicion.len,
+                                             medicion.codigos, NULL);
+
+  ns_op = medicion_correr(medir_u8_validar, &medicion, &ops);
+  medicion_reportar("u8.validar", ops, ns_op, medicion.len);
+  ns_op = medicion_correr(medir_u8_es_ascii, &medicion, &ops);
+  medicion_reportar("u8.es_ascii", ops, ns_op, (double) medicion.len / ops);
+  ns_op = medicion_correr(medir_u8_decodificar, &medicion, &ops);
+  medicion_reportar("u8.decodificar", ops, ns_op,
+                    (double) medicion.len / medicion.n_codigos);
+  ns_op = medicion_correr(medir_u8_plegar, &medicion, &ops);
+  medicion_reportar("u8.plegar", ops, ns_op, 0);
+
+  free(medicion.codigos);
+  free((char *) medicion.texto);
+  return EXIT_SUCCESS;
+}
+
+size_t medir_u8_validar(void *datos)
+{
+  Medicion *medicion = datos;
+  bool ascii;
+
+  if (!u8_validar(medicion->texto, medicion->len, &ascii)) {
+    fprintf(stderr, "El corpus no es UTF-8 válido\n");
+  }
+  return 1;
+}
+
+size_t medir_u8_es_ascii(void *datos)
+{
+  Medicion *medicion = datos;
+  const char *linea = medicion->texto, *fin = medicion->texto + medicion->len;
+  volatile size_t ascii;
+  size_t n = 0, a = 0;
+
+  while (linea < fin) {
+    const char *salto = memchr(linea, '\n', fin - linea);
+    size_t len = salto != NULL ? (size_t) (salto - linea) : (size_t) (fin - linea);
+
+    a += u8_es_ascii(linea, len);
+    n++;
+    linea += len + 1;
+  }
+  ascii = a;
+  (void) ascii;
+  return n;
+}
+
+size_t medir_u8_decodificar(void *datos)
+{
+  Medicion *medicion = datos;
+
+  return u8_decodificar_cadena(medicion->texto, medicion->len,
+                               medicion->codigos, NULL);
+}
+
+size_t medir_u8_plegar(void *datos)
+{
+  Medicion *medicion = datos;
+  volatile uint32_t suma = 0;
+  uint32_t s = 0;
+
+  for (size_t i = 0; i < medicion->n_codigos; i++) {
+    s += u8_plegar(medicion->codigos[i]);
+  }
+  suma = s;
+  (void) suma;
+  return medicion->n_codigos;
+}
+
+/**
+ * dibujar: una operación es un cuadro completo de la partida, como los de
+ * juego_imprimir_partida(), presentado en /dev/null. Se mide como si fuera
+ * una terminal ("dibujar.terminal", que solo manda lo que cambia) y como si
+ * no ("dibujar.completo"). Los bytes son los del cuadro armado.
+ */
+int medir_dibujar(void)
+{
+  const char *nombres[] = { "dibujar.terminal", "dibujar.completo" };
+  Medicion medicion = { 0 };
+  Categoria *categoria;
+  int fd;
+
+  medicion.recursos = recursos_cargar();
+  categoria = recursos_get_categoria(medicion.recursos, 0);
+  fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (categoria == NULL || fd < 0) {
+    fprintf(stderr, "No hay recursos con qué dibujar\n");
+    recursos_destruir(medicion.recursos);
+    return EXIT_FAILURE;
+  }
+  medicion.partida = partida_nueva();
+  partida_elegir_palabra_indice(medicion.partida, categoria, 0);
+
+  for (int terminal = 1; terminal >= 0; terminal--) {
+    size_t ops;
+    double ns_op;
+
+    medicion.pantalla = pantalla_nueva_en(fd, terminal);
+    medicion.bytes = 0;
+    ns_op = medicion_correr(medir_dibujar_ronda, &medicion, &ops);
+    medicion_reportar(nombres[!terminal], ops, ns_op,
+                      (double) medicion.bytes / ops);
+    pantalla_destruir(medicion.pantalla);
+  }
+
+  close(fd);
+  partida_destruir(medicion.partida);
+  recursos_destruir(medicion.recursos);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Dibuja un cuadro por cada número de vidas, para que cambie algo entre
+ * uno y otro igual que en el juego
+ */
+size_t medir_dibujar_ronda(void *datos)
+{
+  Medicion *medicion = datos;
+  const size_t n_cuadros = 1000;
+
+  medicion->bytes = 0;
+  for (size_t i = 0; i < n_cuadros; i++) {
+    Marco *marco = pantalla_get_cuadro(medicion->pantalla);
+
+    marco_agregar_cadena(marco, "Tus vidas:\n\n");
+    textura_dibujar(recursos_get_vidas(medicion->recursos,
+                                       i % (PARTIDA_VIDAS + 1)),
+                    marco);
+    marco_agregar_cadena(marco, "\n\n");
+    palabra_dibujar(partida_get_palabra(medicion->partida), marco);
+    medicion->bytes += marco_get_len(marco);
+    pantalla_presentar(medicion->pantalla);
+  }
+  return n_cuadros;
+}
+
+/**
+ * indice: se reportan dos resultados: "indice.generar", donde una operación
+ * es una palabra de la lista al generar su .idx con indice_generar(), e
+ * "indice.leer", donde una operación es leer una palabra al azar con
+ * categoria_leer_palabra() de una categoría que usa ese índice.
+ */
+int medir_indice(const char *archivo)
+{
+  Medicion medicion = { .archivo = archivo };
+  size_t ops_generar, ops_leer;
+  double ns_generar, ns_leer;
+  struct stat info;
+
+  if (stat(archivo, &info) < 0) {
+    fprintf(stderr, "No se pudo leer %s\n", archivo);
+    return EXIT_FAILURE;
+  }
+
+  ns_generar = medicion_correr(medir_indice_generar, &medicion, &ops_generar);
+  if (ops_generar == 0) {
+    fprintf(stderr, "No se pudo generar el índice de %s\n", archivo);
+    return EXIT_FAILURE;
+  }
+  medicion_reportar("indice.generar", ops_generar, ns_generar,
+                    (double) info.st_size / ops_generar);
+
+  // Con el .idx al día, la categoría lo usa aunque la lista sea pequeña
+  medicion.categoria = categoria_nueva_perezosa("Corpus", archivo);
+  if (!categoria_cargar(medicion.categoria)
+      || categoria_get_palabra(medicion.categoria, 0) != NULL) {
+    fprintf(stderr, "%s no se cargó con su índice\n", archivo);
+    categoria_destruir(medicion.categoria);
+    return EXIT_FAILURE;
+  }
+  medicion.arena = arena_nueva(4096);
+  azar_sembrar(&medicion.azar, 1);
+
+  ns_leer = medicion_correr(medir_indice_leer, &medicion, &ops_leer);
+  medicion_reportar("indice.leer", ops_leer, ns_leer,
+                    ops_leer > 0 ? (double) medicion.bytes / ops_leer : 0);
+
+  arena_destruir(medicion.arena);
+  categoria_destruir(medicion.categoria);
+  return EXIT_SUCCESS;
+}
+
+size_t medir_indice_generar(void *datos)
+{
+  Medicion *medicion = datos;
+  Indice *indice;
+  size_t n;
+
+  if (!indice_generar(medicion->archivo)) {
+    return 0;
+  }
+  indice = indice_abrir(medicion->archivo);
+  n = indice_get_n_palabras(indice);
+  indice_cerrar(indice);
+
+  return n;
+}
+
+size_t medir_indice_leer(void *datos)
+{
+  Medicion *medicion = datos;
+  uint32_t n = categoria_get_n_palabras(medicion->categoria);
+
+  medicion->bytes = 0;
+  for (size_t i = 0; i < MEDICION_LECTURAS; i++) {
+    uint32_t indice = azar_acotado(&medicion->azar, n);
+
+    arena_reiniciar(medicion->arena);
+    if (categoria_leer_palabra(medicion->categoria, indice,
+                               medicion->arena) == NULL) {
+      return i;
+    }
+    medicion->bytes += categoria_get_longitud_palabra(medicion->categoria,
+                                                      indice);
+  }
+  return MEDICION_LECTURAS;
+}
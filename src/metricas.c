@@ -0,0 +1,576 @@
+/* metricas.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "metricas.h"
+
+/* 0 y una cubeta por cada bit de un uint64_t */
+#define METRICAS_CUBETAS 65
+
+/*
+ * Cuántos eventos guarda cada hilo para la traza. El simulador juega
+ * millones de intentos por segundo; de ahí en adelante solo se cuentan.
+ */
+#define METRICAS_MAX_EVENTOS 262144
+
+typedef struct {
+  uint64_t n;
+  uint64_t suma;
+  uint64_t min;
+  uint64_t max;
+  uint64_t cubetas[METRICAS_CUBETAS];
+} MetricasCubetas;
+
+/* Un evento de la traza, con tiempos en nanosegundos desde metricas_iniciar() */
+typedef struct {
+  const char *nombre;
+  uint64_t inicio;
+  uint64_t duracion;
+} MetricasEvento;
+
+/**
+ * Lo que lleva cada hilo. Solo lo toca su hilo hasta metricas_finalizar(),
+ * así que no necesita candados; @siguiente lo encadena con los de los demás
+ * hilos para juntarlos al final, aunque el hilo ya haya terminado.
+ */
+typedef struct __MetricasHilo {
+  struct __MetricasHilo *siguiente;
+  unsigned int id;
+  uint64_t contadores[METRICAS_N_CONTADORES];
+  MetricasCubetas histogramas[METRICAS_N_HISTOGRAMAS];
+  MetricasEvento *eventos;
+  size_t n_eventos;
+  size_t eventos_size;
+  uint64_t eventos_perdidos;
+} MetricasHilo;
+
+/* Cuánto tardó en cargarse una categoría. @nombre es una copia. */
+typedef struct __MetricasCarga {
+  struct __MetricasCarga *siguiente;
+  char *nombre;
+  uint64_t duracion;
+} MetricasCarga;
+
+bool metricas_activas = false;
+
+/*
+ * Lo que comparten todos los hilos; solo se toca con @metricas_candado, al
+ * registrar un hilo o una carga y al finalizar
+ */
+pthread_mutex_t metricas_candado = PTHREAD_MUTEX_INITIALIZER;
+char *metricas_archivo_json;
+char *metricas_archivo_traza;
+uint64_t metricas_inicio;
+MetricasHilo *metricas_hilos;
+unsigned int metricas_n_hilos;
+MetricasCarga *metricas_cargas;
+MetricasCarga **metricas_cargas_fin = &metricas_cargas;
+
+__thread MetricasHilo *metricas_hilo;
+
+uint64_t metricas_reloj(void);
+MetricasHilo *metricas_hilo_actual(void);
+void metricas_cubetas_agregar(MetricasCubetas *, uint64_t);
+void metricas_cubetas_juntar(MetricasCubetas *, const MetricasCubetas *);
+uint64_t metricas_cubetas_percentil(const MetricasCubetas *, double);
+void metricas_escribir_cadena(FILE *, const char *);
+void metricas_escribir_cubetas(FILE *, const char *, const MetricasCubetas *);
+void metricas_escribir_json(FILE *, const uint64_t *, const MetricasCubetas *,
+                            uint64_t, uint64_t);
+void metricas_escribir_traza(FILE *);
+const char *metricas_contador_to_string(MetricasContador);
+const char *metricas_histograma_to_string(MetricasHistograma);
+
+/**
+ * Enciende las métricas
+ *
+ * @json Dónde escribir las métricas al finalizar, o NULL para usar
+ * ADIVINADOR_METRICAS
+ * @traza Dónde escribir la traza al finalizar, o NULL para usar
+ * ADIVINADOR_TRAZA
+ *
+ * Returns: true si quedaron encendidas, es decir, si hay dónde escribir
+ * alguna de las dos
+ */
+bool metricas_iniciar(const char *json,
+                      const char *traza)
+{
+  if (json == NULL) {
+    json = getenv("ADIVINADOR_METRICAS");
+  }
+  if (traza == NULL) {
+    traza = getenv("ADIVINADOR_TRAZA");
+  }
+  if ((json == NULL || *json == '\0') && (traza == NULL || *traza == '\0')) {
+    return false;
+  }
+
+  metricas_archivo_json = json != NULL && *json != '\0' ? strdup(json) : NULL;
+  metricas_archivo_traza = traza != NULL && *traza != '\0' ? strdup(traza)
+                                                           : NULL;
+  metricas_inicio = metricas_reloj();
+  metricas_activas = true;
+
+  return true;
+}
+
+uint64_t metricas_reloj(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Returns: El tiempo en nanosegundos, para medir duraciones, o 0 si las
+ * métricas están apagadas
+ */
+uint64_t metricas_ahora(void)
+{
+  if (!metricas_activas) {
+    return 0;
+  }
+  return metricas_reloj();
+}
+
+/**
+ * Returns: (transfer: none) Lo que lleva el hilo actual; la primera vez se
+ * crea y se registra
+ */
+MetricasHilo *metricas_hilo_actual(void)
+{
+  MetricasHilo *hilo = metricas_hilo;
+
+  if (hilo != NULL) {
+    return hilo;
+  }
+
+  hilo = calloc(1, sizeof(MetricasHilo));
+  if (hilo == NULL) {
+    return NULL;
+  }
+  for (MetricasHistograma h = 0; h < METRICAS_N_HISTOGRAMAS; h++) {
+    hilo->histogramas[h].min = UINT64_MAX;
+  }
+
+  pthread_mutex_lock(&metricas_candado);
+  hilo->id = ++metricas_n_hilos;
+  hilo->siguiente = metricas_hilos;
+  metricas_hilos = hilo;
+  pthread_mutex_unlock(&metricas_candado);
+
+  metricas_hilo = hilo;
+  return hilo;
+}
+
+/**
+ * Le suma @n a @contador
+ */
+void metricas_contar(MetricasContador contador,
+                     uint64_t         n)
+{
+  MetricasHilo *hilo;
+
+  if (!metricas_activas || contador >= METRICAS_N_CONTADORES) {
+    return;
+  }
+  hilo = metricas_hilo_actual();
+  if (hilo != NULL) {
+    hilo->contadores[contador] += n;
+  }
+}
+
+/**
+ * Agrega @valor a @histograma
+ */
+void metricas_registrar(MetricasHistograma histograma,
+                        uint64_t           valor)
+{
+  MetricasHilo *hilo;
+
+  if (!metricas_activas || histograma >= METRICAS_N_HISTOGRAMAS) {
+    return;
+  }
+  hilo = metricas_hilo_actual();
+  if (hilo != NULL) {
+    metricas_cubetas_agregar(&hilo->histogramas[histograma], valor);
+  }
+}
+
+void metricas_cubetas_agregar(MetricasCubetas *self,
+                              uint64_t         valor)
+{
+  self->n++;
+  self->suma += valor;
+  if (valor < self->min) {
+    self->min = valor;
+  }
+  if (valor > self->max) {
+    self->max = valor;
+  }
+  self->cubetas[valor == 0 ? 0 : 64 - __builtin_clzll(valor)]++;
+}
+
+/**
+ * Guarda un evento para la traza. Si no se pidió traza no hace nada.
+ *
+ * @nombre (transfer: none) El nombre del evento; tiene que vivir hasta
+ * metricas_finalizar(), así que normalmente es una literal
+ * @inicio Cuándo empezó, según metricas_ahora()
+ * @fin Cuándo terminó, según metricas_ahora()
+ */
+void metricas_evento(const char *nombre,
+                     uint64_t    inicio,
+                     uint64_t    fin)
+{
+  MetricasHilo *hilo;
+  MetricasEvento *evento;
+
+  if (!metricas_activas || metricas_archivo_traza == NULL) {
+    return;
+  }
+  hilo = metricas_hilo_actual();
+  if (hilo == NULL) {
+    return;
+  }
+
+  if (hilo->n_eventos == hilo->eventos_size) {
+    size_t size = hilo->eventos_size > 0 ? hilo->eventos_size * 2 : 1024;
+    MetricasEvento *eventos;
+
+    if (size > METRICAS_MAX_EVENTOS
+        || (eventos = realloc(hilo->eventos,
+                              size * sizeof(MetricasEvento))) == NULL) {
+      hilo->eventos_perdidos++;
+      return;
+    }
+    hilo->eventos = eventos;
+    hilo->eventos_size = size;
+  }
+
+  evento = &hilo->eventos[hilo->n_eventos++];
+  evento->nombre = nombre;
+  evento->inicio = inicio - metricas_inicio;
+  evento->duracion = fin - inicio;
+}
+
+/**
+ * Registra cuánto tardó en cargarse la categoría @nombre, que además sale
+ * en la traza como un evento con su nombre
+ *
+ * @inicio Cuándo empezó, según metricas_ahora()
+ * @fin Cuándo terminó, según metricas_ahora()
+ */
+void metricas_cargar_categoria(const char *nombre,
+                               uint64_t    inicio,
+                               uint64_t    fin)
+{
+  MetricasCarga *carga;
+
+  if (!metricas_activas || nombre == NULL) {
+    return;
+  }
+
+  carga = malloc(sizeof(MetricasCarga));
+  if (carga == NULL) {
+    return;
+  }
+  carga->siguiente = NULL;
+  carga->nombre = strdup(nombre);
+  carga->duracion = fin - inicio;
+
+  pthread_mutex_lock(&metricas_candado);
+  *metricas_cargas_fin = carga;
+  metricas_cargas_fin = &carga->siguiente;
+  pthread_mutex_unlock(&metricas_candado);
+
+  // La copia vive hasta el final, así que sirve como nombre del evento
+  metricas_evento(carga->nombre, inicio, fin);
+}
+
+void metricas_cubetas_juntar(MetricasCubetas       *self,
+                             const MetricasCubetas *otras)
+{
+  self->n += otras->n;
+  self->suma += otras->suma;
+  if (otras->min < self->min) {
+    self->min = otras->min;
+  }
+  if (otras->max > self->max) {
+    self->max = otras->max;
+  }
+  for (size_t b = 0; b < METRICAS_CUBETAS; b++) {
+    self->cubetas[b] += otras->cubetas[b];
+  }
+}
+
+/**
+ * Estima el percentil @p (de 0 a 1) con el límite superior de la cubeta en
+ * la que cae, así que se pasa a lo más por el doble
+ */
+uint64_t metricas_cubetas_percentil(const MetricasCubetas *self,
+                                    double                 p)
+{
+  uint64_t objetivo, acumulado = 0;
+
+  if (self->n == 0) {
+    return 0;
+  }
+  objetivo = (uint64_t) (p * self->n);
+  if (objetivo < 1) {
+    objetivo = 1;
+  }
+  for (size_t b = 0; b < METRICAS_CUBETAS; b++) {
+    acumulado += self->cubetas[b];
+    if (acumulado >= objetivo) {
+      uint64_t limite = b == 0 ? 0 : b == 64 ? UINT64_MAX
+                                             : (UINT64_C(1) << b) - 1;
+      return limite < self->max ? limite : self->max;
+    }
+  }
+  return self->max;
+}
+
+/* Escribe @cadena entre comillas, escapando lo que JSON no deja pasar */
+void metricas_escribir_cadena(FILE       *archivo,
+                              const char *cadena)
+{
+  fputc('"', archivo);
+  for (const unsigned char *c = (const unsigned char *) cadena; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(archivo, "\\%c", *c);
+    } else if (*c < 0x20) {
+      fprintf(archivo, "\\u%04x", *c);
+    } else {
+      fputc(*c, archivo);
+    }
+  }
+  fputc('"', archivo);
+}
+
+void metricas_escribir_cubetas(FILE                  *archivo,
+                               const char            *nombre,
+                               const MetricasCubetas *self)
+{
+  size_t ultima = 0;
+
+  for (size_t b = 0; b < METRICAS_CUBETAS; b++) {
+    if (self->cubetas[b] > 0) {
+      ultima = b;
+    }
+  }
+
+  fprintf(archivo,
+          "    \"%s\": {\"n\": %llu, \"suma\": %llu, \"min\": %llu, "
+          "\"max\": %llu, \"media\": %.1f, \"p50\": %llu, \"p90\": %llu, "
+          "\"p99\": %llu, \"cubetas\": [",
+          nombre, (unsigned long long) self->n,
+          (unsigned long long) self->suma,
+          (unsigned long long) (self->n > 0 ? self->min : 0),
+          (unsigned long long) self->max,
+          self->n > 0 ? (double) self->suma / self->n : 0.0,
+          (unsigned long long) metricas_cubetas_percentil(self, 0.5),
+          (unsigned long long) metricas_cubetas_percentil(self, 0.9),
+          (unsigned long long) metricas_cubetas_percentil(self, 0.99));
+  for (size_t b = 0; self->n > 0 && b <= ultima; b++) {
+    fprintf(archivo, "%s%llu", b > 0 ? ", " : "",
+            (unsigned long long) self->cubetas[b]);
+  }
+  fprintf(archivo, "]}");
+}
+
+/**
+ * Escribe las métricas ya juntadas de todos los hilos
+ *
+ * @duracion Nanosegundos desde metricas_iniciar()
+ * @perdidos Cuántos eventos no cupieron en la traza
+ */
+void metricas_escribir_json(FILE                  *archivo,
+                            const uint64_t        *contadores,
+                            const MetricasCubetas *histogramas,
+                            uint64_t               duracion,
+                            uint64_t               perdidos)
+{
+  double segundos = duracion / 1e9;
+
+  fprintf(archivo, "{\n  \"duracion_s\": %.6f,\n  \"hilos\": %u,\n",
+          segundos, metricas_n_hilos);
+  fprintf(archivo, "  \"intentos_por_segundo\": %.1f,\n",
+          segundos > 0 ? contadores[METRICAS_INTENTOS] / segundos : 0.0);
+
+  fprintf(archivo, "  \"contadores\": {\n");
+  for (MetricasContador c = 0; c < METRICAS_N_CONTADORES; c++) {
+    fprintf(archivo, "    \"%s\": %llu%s\n", metricas_contador_to_string(c),
+            (unsigned long long) contadores[c],
+            c + 1 < METRICAS_N_CONTADORES ? "," : "");
+  }
+  fprintf(archivo, "  },\n  \"histogramas\": {\n");
+  for (MetricasHistograma h = 0; h < METRICAS_N_HISTOGRAMAS; h++) {
+    metricas_escribir_cubetas(archivo, metricas_histograma_to_string(h),
+                              &histogramas[h]);
+    fprintf(archivo, "%s\n", h + 1 < METRICAS_N_HISTOGRAMAS ? "," : "");
+  }
+  fprintf(archivo, "  },\n  \"carga_categorias_ns\": {");
+  for (MetricasCarga *carga = metricas_cargas; carga != NULL;
+       carga = carga->siguiente) {
+    fprintf(archivo, "%s\n    ", carga == metricas_cargas ? "" : ",");
+    metricas_escribir_cadena(archivo, carga->nombre);
+    fprintf(archivo, ": %llu", (unsigned long long) carga->duracion);
+  }
+  fprintf(archivo, "%s},\n  \"eventos_perdidos\": %llu\n}\n",
+          metricas_cargas != NULL ? "\n  " : "",
+          (unsigned long long) perdidos);
+}
+
+/**
+ * Escribe los eventos de todos los hilos en el formato de trace events de
+ * Chrome, con tiempos en microsegundos
+ */
+void metricas_escribir_traza(FILE *archivo)
+{
+  bool primero = true;
+
+  fprintf(archivo, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  for (MetricasHilo *hilo = metricas_hilos; hilo != NULL;
+       hilo = hilo->siguiente) {
+    for (size_t e = 0; e < hilo->n_eventos; e++) {
+      MetricasEvento *evento = &hilo->eventos[e];
+
+      fprintf(archivo, "%s\n{\"name\": ", primero ? "" : ",");
+      metricas_escribir_cadena(archivo, evento->nombre);
+      fprintf(archivo, ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+              "\"pid\": 1, \"tid\": %u}",
+              evento->inicio / 1e3, evento->duracion / 1e3, hilo->id);
+      primero = false;
+    }
+  }
+  fprintf(archivo, "\n]}\n");
+}
+
+/**
+ * Junta lo de todos los hilos, lo escribe en los archivos que se pidieron y
+ * apaga las métricas. Se llama al salir, cuando ya terminaron los demás
+ * hilos que las usaron.
+ */
+void metricas_finalizar(void)
+{
+  uint64_t contadores[METRICAS_N_CONTADORES] = { 0 };
+  MetricasCubetas histogramas[METRICAS_N_HISTOGRAMAS] = { 0 };
+  uint64_t duracion, perdidos = 0;
+  FILE *archivo;
+
+  if (!metricas_activas) {
+    return;
+  }
+  duracion = metricas_reloj() - metricas_inicio;
+  metricas_activas = false;
+
+  pthread_mutex_lock(&metricas_candado);
+
+  for (MetricasHistograma h = 0; h < METRICAS_N_HISTOGRAMAS; h++) {
+    histogramas[h].min = UINT64_MAX;
+  }
+  for (MetricasHilo *hilo = metricas_hilos; hilo != NULL;
+       hilo = hilo->siguiente) {
+    for (MetricasContador c = 0; c < METRICAS_N_CONTADORES; c++) {
+      contadores[c] += hilo->contadores[c];
+    }
+    for (MetricasHistograma h = 0; h < METRICAS_N_HISTOGRAMAS; h++) {
+      metricas_cubetas_juntar(&histogramas[h], &hilo->histogramas[h]);
+    }
+    perdidos += hilo->eventos_perdidos;
+  }
+
+  if (metricas_archivo_json != NULL) {
+    archivo = fopen(metricas_archivo_json, "w");
+    if (archivo != NULL) {
+      metricas_escribir_json(archivo, contadores, histogramas, duracion,
+                             perdidos);
+      fclose(archivo);
+    } else {
+      perror(metricas_archivo_json);
+    }
+  }
+  if (metricas_archivo_traza != NULL) {
+    archivo = fopen(metricas_archivo_traza, "w");
+    if (archivo != NULL) {
+      metricas_escribir_traza(archivo);
+      fclose(archivo);
+    } else {
+      perror(metricas_archivo_traza);
+    }
+  }
+
+  while (metricas_hilos != NULL) {
+    MetricasHilo *siguiente = metricas_hilos->siguiente;
+    free(metricas_hilos->eventos);
+    free(metricas_hilos);
+    metricas_hilos = siguiente;
+  }
+  metricas_n_hilos = 0;
+  while (metricas_cargas != NULL) {
+    MetricasCarga *siguiente = metricas_cargas->siguiente;
+    free(metricas_cargas->nombre);
+    free(metricas_cargas);
+    metricas_cargas = siguiente;
+  }
+  metricas_cargas_fin = &metricas_cargas;
+  free(metricas_archivo_json);
+  metricas_archivo_json = NULL;
+  free(metricas_archivo_traza);
+  metricas_archivo_traza = NULL;
+
+  pthread_mutex_unlock(&metricas_candado);
+
+  /*
+   * Lo de cada hilo ya se liberó; el hilo actual vuelve a registrarse si se
+   * encienden otra vez
+   */
+  metricas_hilo = NULL;
+}
+
+const char *metricas_contador_to_string(MetricasContador contador)
+{
+  switch (contador) {
+  case METRICAS_INTENTOS:
+    return "intentos";
+  case METRICAS_RONDAS:
+    return "rondas";
+  case METRICAS_CUADROS:
+    return "cuadros";
+  case METRICAS_BYTES_ESCRITOS:
+    return "bytes_escritos";
+  case METRICAS_N_CONTADORES:
+  default:
+    return NULL;
+  }
+}
+
+const char *metricas_histograma_to_string(MetricasHistograma histograma)
+{
+  switch (histograma) {
+  case METRICAS_LATENCIA_INTENTO:
+    return "latencia_intento_ns";
+  case METRICAS_ALOJAMIENTOS_RONDA:
+    return "alojamientos_por_ronda";
+  case METRICAS_BYTES_RONDA:
+    return "bytes_por_ronda";
+  case METRICAS_BYTES_CUADRO:
+    return "bytes_por_cuadro";
+  case METRICAS_N_HISTOGRAMAS:
+  default:
+    return NULL;
+  }
+}
@@ -0,0 +1,55 @@
+/* metricas.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Métricas del juego: contadores e histogramas que cada hilo lleva por su
+ * cuenta, sin candados ni atómicos, y que se juntan al final en un JSON. Si
+ * además se pide una traza, cada evento se guarda para abrirla en
+ * chrome://tracing o en Perfetto.
+ *
+ * Están apagadas a menos que se llame a metricas_iniciar() con algún
+ * archivo, o que exista ADIVINADOR_METRICAS o ADIVINADOR_TRAZA. Apagadas,
+ * cada llamada solo revisa @metricas_activas y regresa.
+ */
+
+/* Lo que solo se cuenta */
+typedef enum {
+  METRICAS_INTENTOS,
+  METRICAS_RONDAS,
+  METRICAS_CUADROS,
+  METRICAS_BYTES_ESCRITOS,
+  METRICAS_N_CONTADORES
+} MetricasContador;
+
+/*
+ * Lo que se cuenta por cubetas de potencias de dos: la cubeta b tiene los
+ * valores de 2^(b-1) a 2^b - 1, y la 0 solo al 0
+ */
+typedef enum {
+  METRICAS_LATENCIA_INTENTO,
+  METRICAS_ALOJAMIENTOS_RONDA,
+  METRICAS_BYTES_RONDA,
+  METRICAS_BYTES_CUADRO,
+  METRICAS_N_HISTOGRAMAS
+} MetricasHistograma;
+
+extern bool metricas_activas;
+
+bool metricas_iniciar(const char *, const char *);
+uint64_t metricas_ahora(void);
+void metricas_contar(MetricasContador, uint64_t);
+void metricas_registrar(MetricasHistograma, uint64_t);
+void metricas_evento(const char *, uint64_t, uint64_t);
+void metricas_cargar_categoria(const char *, uint64_t, uint64_t);
+void metricas_finalizar(void);
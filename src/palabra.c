@@ -0,0 +1,425 @@
+/* palabra.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include "marco.h"
+#include "palabra.h"
+#include "u8.h"
+
+/**
+ * Una letra distinta de la palabra: su llave plegada y cuáles de los
+ * caracteres de la palabra la tienen, que son los @n que empiezan en
+ * @inicio dentro de las posiciones de la palabra
+ */
+typedef struct {
+  uint32_t clave;
+  uint32_t inicio;
+  uint32_t n;
+} PalabraLetra;
+
+/**
+ * @texto es la palabra tal cual y @adivinada lo que el usuario ha revelado,
+ * con guiones bajos en lo que falta; ambas miden @len bytes.
+ *
+ * Por cada uno de los @n_caracteres guardamos su código, su llave plegada y
+ * en qué byte empieza (@offsets tiene uno más, con @len). @posiciones tiene
+ * los caracteres agrupados por letra, y @tabla es una tabla hash de
+ * direccionamiento abierto que lleva de una llave a su letra (guardamos el
+ * índice de la letra más uno; 0 es una casilla vacía).
+ *
+ * @adivinadas tiene un bit por letra, y @ocultos cuántos caracteres faltan
+ * por revelar.
+ */
+struct __Palabra {
+  char *texto;
+  char *adivinada;
+  size_t len;
+
+  uint32_t *codigos;
+  uint32_t *claves;
+  uint32_t *offsets;
+  size_t n_caracteres;
+
+  PalabraLetra *letras;
+  size_t n_letras;
+  uint32_t *posiciones;
+  uint32_t *tabla;
+  size_t tabla_mascara;
+
+  uint64_t *adivinadas;
+  size_t ocultos;
+};
+
+uint32_t *palabra_buscar_casilla(Palabra *, uint32_t);
+PalabraLetra *palabra_buscar_letra(Palabra *, uint32_t);
+
+/**
+ * Crea una palabra nueva a partir de @len bytes de @texto, que se copian, y
+ * arma su índice de letras
+ *
+ * @texto La palabra, en UTF-8
+ * @len Cuántos bytes mide @texto
+ * @ascii Si @texto es puramente ASCII, en cuyo caso no hace falta
+ * decodificarlo: cada byte es un caracter
+ * @arena La arena en la que vive la palabra, normalmente la de la ronda
+ *
+ * Returns: (transfer: none) La palabra nueva, que vive en @arena
+ */
+Palabra *palabra_nueva(const char *texto,
+                       size_t      len,
+                       bool        ascii,
+                       Arena      *arena)
+{
+  Palabra *self;
+  size_t tabla_size = 8;
+
+  if (texto == NULL || arena == NULL) {
+    return NULL;
+  }
+
+  self = arena_alojar0(arena, sizeof(Palabra));
+  self->texto = arena_strndup(arena, texto, len);
+  self->len = len;
+
+  /*
+   * Todo empieza oculto con un guión bajo, hasta ver qué caracteres son
+   * letras. Los caracteres de varios bytes quedan con un guión por byte; al
+   * imprimirlos solo se toma en cuenta el primero.
+   */
+  self->adivinada = arena_alojar0(arena, len + 1);
+  memset(self->adivinada, '_', len);
+
+  // Una palabra nunca tiene más caracteres que bytes
+  self->codigos = arena_alojar(arena, len * sizeof(uint32_t));
+  self->claves = arena_alojar(arena, len * sizeof(uint32_t));
+  self->offsets = arena_alojar(arena, (len + 1) * sizeof(uint32_t));
+  if (ascii) {
+    for (size_t i = 0; i < len; i++) {
+      self->codigos[i] = (unsigned char) texto[i];
+      self->claves[i] = char_minuscula(texto[i]);
+      self->offsets[i] = i;
+    }
+    self->offsets[len] = len;
+    self->n_caracteres = len;
+  } else {
+    self->n_caracteres = u8_decodificar_cadena(self->texto, len, self->codigos,
+                                               self->offsets);
+    for (size_t i = 0; i < self->n_caracteres; i++) {
+      self->claves[i] = u8_plegar(self->codigos[i]);
+    }
+  }
+
+  /*
+   * Solo se adivinan letras (ver u8_es_letra()), así que los espacios, los
+   * guiones, los apóstrofos y las letras de otros alfabetos se muestran
+   * desde el principio
+   */
+  for (size_t i = 0; i < self->n_caracteres; i++) {
+    if (!u8_es_letra(self->codigos[i])) {
+      memcpy(&self->adivinada[self->offsets[i]], &self->texto[self->offsets[i]],
+             self->offsets[i + 1] - self->offsets[i]);
+    }
+  }
+
+  // Dejamos la tabla a lo más medio llena, para que las búsquedas sean cortas
+  while (tabla_size < 2 * self->n_caracteres) {
+    tabla_size *= 2;
+  }
+  self->tabla = arena_alojar0(arena, tabla_size * sizeof(uint32_t));
+  self->tabla_mascara = tabla_size - 1;
+  self->letras = arena_alojar(arena, self->n_caracteres * sizeof(PalabraLetra));
+  self->posiciones = arena_alojar(arena, self->n_caracteres * sizeof(uint32_t));
+
+  // Primero contamos cuántas veces aparece cada letra...
+  for (size_t i = 0; i < self->n_caracteres; i++) {
+    uint32_t *casilla;
+
+    if (!u8_es_letra(self->codigos[i])) {
+      continue;
+    }
+    casilla = palabra_buscar_casilla(self, self->claves[i]);
+    if (*casilla == 0) {
+      PalabraLetra *letra = &self->letras[self->n_letras++];
+      letra->clave = self->claves[i];
+      letra->n = 0;
+      *casilla = self->n_letras;
+    }
+    self->letras[*casilla - 1].n++;
+    self->ocultos++;
+  }
+
+  // ...y luego acomodamos sus posiciones una detrás de otra
+  for (size_t i = 0, inicio = 0; i < self->n_letras; i++) {
+    self->letras[i].inicio = inicio;
+    inicio += self->letras[i].n;
+    self->letras[i].n = 0;
+  }
+  for (size_t i = 0; i < self->n_caracteres; i++) {
+    PalabraLetra *letra;
+
+    if (!u8_es_letra(self->codigos[i])) {
+      continue;
+    }
+    letra = palabra_buscar_letra(self, self->claves[i]);
+    self->posiciones[letra->inicio + letra->n++] = i;
+  }
+
+  self->adivinadas = arena_alojar0(arena, ((self->n_letras + 63) / 64)
+                                          * sizeof(uint64_t));
+
+  return self;
+}
+
+/**
+ * Busca la casilla de @clave en la tabla de @self: la que ya tiene a @clave,
+ * o la casilla vacía donde iría
+ */
+uint32_t *palabra_buscar_casilla(Palabra  *self,
+                                 uint32_t  clave)
+{
+  size_t i = ((clave * 2654435761u) >> 8) & self->tabla_mascara;
+
+  while (self->tabla[i] != 0 && self->letras[self->tabla[i] - 1].clave != clave) {
+    i = (i + 1) & self->tabla_mascara;
+  }
+  return &self->tabla[i];
+}
+
+/**
+ * Returns: (transfer: none) La letra de @self con llave @clave, o NULL si
+ * @clave no está en la palabra
+ */
+PalabraLetra *palabra_buscar_letra(Palabra  *self,
+                                   uint32_t  clave)
+{
+  uint32_t casilla = *palabra_buscar_casilla(self, clave);
+
+  if (casilla == 0) {
+    return NULL;
+  }
+  return &self->letras[casilla - 1];
+}
+
+/**
+ * Returns: (transfer: none) La palabra tal cual, terminada en NUL
+ */
+const char *palabra_get_texto(Palabra *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->texto;
+}
+
+/**
+ * Returns: (transfer: none) Lo que se ha revelado de la palabra, con un
+ * guión bajo por cada byte que falta, terminado en NUL
+ */
+const char *palabra_get_adivinada(Palabra *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->adivinada;
+}
+
+size_t palabra_get_len(Palabra *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->len;
+}
+
+size_t palabra_get_n_caracteres(Palabra *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->n_caracteres;
+}
+
+/**
+ * Returns: Cuántos caracteres de @self faltan por revelar
+ */
+size_t palabra_get_ocultos(Palabra *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->ocultos;
+}
+
+/**
+ * Lo que el jugador ve del caracter @caracter de @self: su llave plegada si
+ * ya se reveló (o no es una letra), o 0 si todavía es un guión bajo
+ *
+ * @caracter El índice del caracter, no del byte
+ *
+ * Returns: La llave del caracter, o 0 si sigue oculto o no existe
+ */
+uint32_t palabra_get_clave_visible(Palabra *self,
+                                   size_t   caracter)
+{
+  uint32_t clave;
+
+  if (self == NULL || caracter >= self->n_caracteres) {
+    return 0;
+  }
+  clave = self->claves[caracter];
+  if (!u8_es_letra(self->codigos[caracter])
+      || palabra_letra_adivinada(self, clave)) {
+    return clave;
+  }
+  return 0;
+}
+
+/**
+ * Returns: true si la letra con llave @clave está en @self y ya se reveló
+ */
+bool palabra_letra_adivinada(Palabra  *self,
+                             uint32_t  clave)
+{
+  PalabraLetra *letra;
+  size_t indice;
+
+  if (self == NULL) {
+    return false;
+  }
+  letra = palabra_buscar_letra(self, clave);
+  if (letra == NULL) {
+    return false;
+  }
+  indice = letra - self->letras;
+  return (self->adivinadas[indice / 64] >> (indice % 64)) & 1;
+}
+
+/**
+ * Revela todos los caracteres de @self cuya llave plegada es @clave. Como
+ * las mayúsculas y las letras con acento tienen la misma llave que su letra
+ * base, se revelan todas juntas.
+ *
+ * @clave La llave plegada del caracter que adivinó el usuario
+ *
+ * Returns: Cuántos caracteres se revelaron; 0 si la letra no está en la
+ * palabra o ya se había revelado
+ */
+size_t palabra_revelar(Palabra  *self,
+                       uint32_t  clave)
+{
+  PalabraLetra *letra;
+  size_t indice;
+
+  if (self == NULL) {
+    return 0;
+  }
+  letra = palabra_buscar_letra(self, clave);
+  if (letra == NULL) {
+    return 0;
+  }
+
+  indice = letra - self->letras;
+  if ((self->adivinadas[indice / 64] >> (indice % 64)) & 1) {
+    return 0;
+  }
+  self->adivinadas[indice / 64] |= (uint64_t) 1 << (indice % 64);
+
+  for (size_t i = 0; i < letra->n; i++) {
+    uint32_t caracter = self->posiciones[letra->inicio + i];
+    uint32_t inicio = self->offsets[caracter];
+
+    memcpy(&self->adivinada[inicio], &self->texto[inicio],
+           self->offsets[caracter + 1] - inicio);
+  }
+  self->ocultos -= letra->n;
+
+  return letra->n;
+}
+
+/**
+ * Compara @intento con @self usando las llaves plegadas, así que "mexico" es
+ * igual a "México"
+ *
+ * @intento La palabra que escribió el usuario
+ *
+ * Returns: true si @intento es la palabra
+ */
+bool palabra_comparar(Palabra    *self,
+                      const char *intento)
+{
+  size_t len, i = 0, caracter = 0;
+
+  if (self == NULL || intento == NULL) {
+    return false;
+  }
+
+  len = strlen(intento);
+  while (i < len) {
+    size_t consumidos;
+    uint32_t codigo = u8_decodificar(&intento[i], len - i, &consumidos);
+
+    if (caracter >= self->n_caracteres
+        || u8_plegar(codigo) != self->claves[caracter]) {
+      return false;
+    }
+    i += consumidos;
+    caracter++;
+  }
+
+  return caracter == self->n_caracteres;
+}
+
+/**
+ * Returns: true si ya no queda nada por revelar en @self
+ */
+bool palabra_completa(Palabra *self)
+{
+  if (self == NULL) {
+    return false;
+  }
+  return self->ocultos == 0;
+}
+
+/**
+ * Dibuja en @marco lo que se ha revelado de @self, seguido de un salto de
+ * línea.
+ *
+ * Por la codificación de las cadenas en C no podemos solo imprimir los
+ * guiones que sustituyen a las letras pendientes, ya que estas pueden estar
+ * codificadas en UTF-8 y por tanto ocupar más de un byte. Cada caracter
+ * oculto se dibuja con un solo guión: el de su primer byte.
+ *
+ * @marco El marco en el que se dibuja
+ */
+void palabra_dibujar(Palabra *self,
+                     Marco   *marco)
+{
+  if (self == NULL || marco == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < self->len; i++) {
+    char c_adivinado = self->adivinada[i];
+    char c_actual = self->texto[i];
+    /*
+     * Solo vamos a imprimir el byte si cumple con alguna de las siguientes
+     * condiciones:
+     *
+     * 1. Si el caracter de la palabra actual es el primer byte de una
+     * cadena UTF-8
+     * 2. Si el caracter de la palabra actual es un caracter ASCII
+     * 3. Si el caracter de la cadena a adivinar ya fue revelado
+     */
+    if ((PRIMER_U8 (c_actual) || ES_ASCII(c_actual)) || PARTE_U8 (c_adivinado)) {
+      marco_agregar (marco, &c_adivinado, 1);
+    }
+  }
+  marco_agregar (marco, "\n", 1);
+}
@@ -0,0 +1,45 @@
+/* palabra.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "marco.h"
+
+/*
+ * La palabra que se está adivinando en una ronda, junto con el progreso del
+ * usuario.
+ *
+ * Al crearla se decodifica una sola vez y se arma un índice de cada letra
+ * (ya plegada, sin mayúsculas ni acentos) a las posiciones donde aparece.
+ * También se lleva la cuenta de cuántos caracteres siguen ocultos y de qué
+ * letras ya se adivinaron, así que revelar una letra solo toca sus
+ * posiciones y saber si se ganó no tiene que recorrer la palabra.
+ *
+ * Todo vive en la arena con la que se crea, así que no hay que destruirla.
+ */
+struct __Palabra;
+typedef struct __Palabra Palabra;
+
+Palabra *palabra_nueva(const char *, size_t, bool, Arena *);
+const char *palabra_get_texto(Palabra *);
+const char *palabra_get_adivinada(Palabra *);
+size_t palabra_get_len(Palabra *);
+size_t palabra_get_n_caracteres(Palabra *);
+size_t palabra_get_ocultos(Palabra *);
+uint32_t palabra_get_clave_visible(Palabra *, size_t);
+bool palabra_letra_adivinada(Palabra *, uint32_t);
+size_t palabra_revelar(Palabra *, uint32_t);
+bool palabra_comparar(Palabra *, const char *);
+bool palabra_completa(Palabra *);
+void palabra_dibujar(Palabra *, Marco *);
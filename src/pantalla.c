@@ -0,0 +1,283 @@
+/* pantalla.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "metricas.h"
+#include "pantalla.h"
+#include "u8.h"
+
+#define ANSI_LIMPIAR "\x1b[H\x1b[2J"
+#define ANSI_BORRAR_LINEA "\x1b[K"
+#define ANSI_BORRAR_ABAJO "\x1b[J"
+#define ANSI_OCULTAR_CURSOR "\x1b[?25l"
+#define ANSI_MOSTRAR_CURSOR "\x1b[?25h"
+
+/**
+ * Cada cuadro es el texto completo de la pantalla, con sus lineas separadas
+ * por saltos de linea: @actual es el que se está armando y @anterior el que
+ * ya está en la terminal. En @salida se juntan las secuencias de escape y el
+ * texto que hay que mandar, para escribirlos con un solo write(2).
+ *
+ * Todo se escribe en @fd. Si @terminal es false, la salida no es una
+ * terminal y no tiene caso mandarle secuencias de escape: se escribe cada
+ * cuadro completo.
+ */
+struct __Pantalla {
+  Marco *actual;
+  Marco *anterior;
+  Marco *salida;
+  int fd;
+  bool terminal;
+};
+
+size_t pantalla_contar_celdas(const char *, size_t);
+void pantalla_mover_cursor(Pantalla *, size_t, size_t);
+void pantalla_presentar_linea(Pantalla *, size_t, const char *, size_t,
+                              const char *, size_t);
+void pantalla_volcar(Pantalla *, Marco *);
+
+/**
+ * Crea una pantalla que dibuja en la salida estándar
+ *
+ * Returns: (transfer: full) La pantalla nueva
+ */
+Pantalla *pantalla_nueva(void)
+{
+  return pantalla_nueva_en(STDOUT_FILENO, isatty(STDOUT_FILENO));
+}
+
+/**
+ * Crea una pantalla que dibuja en @fd, por ejemplo, para medir cuánto
+ * cuesta dibujar sin una terminal de por medio
+ *
+ * @fd Dónde se escriben los cuadros
+ * @terminal Si @fd se trata como terminal, es decir, si solo se mandan las
+ * celdas que cambian
+ *
+ * Returns: (transfer: full) La pantalla nueva
+ */
+Pantalla *pantalla_nueva_en(int  fd,
+                            bool terminal)
+{
+  Pantalla *self;
+
+  self = malloc(sizeof(Pantalla));
+  self->actual = marco_nuevo();
+  self->anterior = marco_nuevo();
+  self->salida = marco_nuevo();
+  self->fd = fd;
+  self->terminal = terminal;
+
+  return self;
+}
+
+/**
+ * Manda @marco a la terminal. Antes vaciamos stdout, para que lo que se haya
+ * escrito con printf salga primero.
+ */
+void pantalla_volcar(Pantalla *self,
+                     Marco    *marco)
+{
+  size_t len = marco_get_len(marco);
+
+  fflush(stdout);
+  marco_volcar(marco, self->fd);
+
+  metricas_contar(METRICAS_CUADROS, 1);
+  metricas_contar(METRICAS_BYTES_ESCRITOS, len);
+  metricas_registrar(METRICAS_BYTES_CUADRO, len);
+}
+
+/**
+ * Borra la terminal completa. Como ya no sabemos qué hay en ella, el
+ * siguiente cuadro se dibuja completo.
+ */
+void pantalla_limpiar(Pantalla *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  marco_vaciar(self->anterior);
+  marco_vaciar(self->actual);
+  if (self->terminal) {
+    marco_agregar_cadena(self->salida, ANSI_LIMPIAR);
+    pantalla_volcar(self, self->salida);
+  }
+}
+
+/**
+ * Returns: (transfer: none) El marco en el que se arma el siguiente cuadro
+ */
+Marco *pantalla_get_cuadro(Pantalla *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->actual;
+}
+
+/**
+ * Cuenta cuántas celdas de la terminal ocupan @len bytes de @texto. Cada
+ * caracter UTF-8 ocupa una celda, así que solo no contamos los bytes que son
+ * continuación de un caracter.
+ */
+size_t pantalla_contar_celdas(const char *texto,
+                              size_t      len)
+{
+  size_t celdas = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (!PARTE_U8(texto[i])) {
+      celdas++;
+    }
+  }
+  return celdas;
+}
+
+void pantalla_mover_cursor(Pantalla *self,
+                           size_t    fila,
+                           size_t    columna)
+{
+  marco_printf(self->salida, "\x1b[%zu;%zuH", fila + 1, columna + 1);
+}
+
+/**
+ * Actualiza la fila @fila de la terminal, que tenía @anterior y ahora debe
+ * tener @nueva. Nos saltamos lo que ambas lineas tienen igual al principio y
+ * al final, y solo escribimos lo de en medio.
+ */
+void pantalla_presentar_linea(Pantalla   *self,
+                              size_t      fila,
+                              const char *nueva,
+                              size_t      nueva_len,
+                              const char *anterior,
+                              size_t      anterior_len)
+{
+  size_t prefijo = 0, sufijo = 0, minimo;
+
+  if (nueva_len == anterior_len && memcmp(nueva, anterior, nueva_len) == 0) {
+    return;
+  }
+
+  minimo = nueva_len < anterior_len ? nueva_len : anterior_len;
+  while (prefijo < minimo && nueva[prefijo] == anterior[prefijo]) {
+    prefijo++;
+  }
+  // No podemos empezar a escribir a la mitad de un caracter UTF-8
+  while (prefijo > 0 && ((prefijo < nueva_len && PARTE_U8(nueva[prefijo]))
+                         || (prefijo < anterior_len
+                             && PARTE_U8(anterior[prefijo])))) {
+    prefijo--;
+  }
+
+  while (sufijo < minimo - prefijo
+         && nueva[nueva_len - sufijo - 1] == anterior[anterior_len - sufijo - 1]) {
+    sufijo++;
+  }
+  while (sufijo > 0 && PARTE_U8(nueva[nueva_len - sufijo])) {
+    sufijo--;
+  }
+
+  /*
+   * Solo podemos dejar el final como está si lo de en medio ocupa las mismas
+   * celdas en ambas lineas; si no, el final se recorre y hay que reescribirlo
+   */
+  if (pantalla_contar_celdas(&nueva[prefijo], nueva_len - sufijo - prefijo)
+      != pantalla_contar_celdas(&anterior[prefijo],
+                                anterior_len - sufijo - prefijo)) {
+    sufijo = 0;
+  }
+
+  pantalla_mover_cursor(self, fila, pantalla_contar_celdas(nueva, prefijo));
+  marco_agregar(self->salida, &nueva[prefijo], nueva_len - sufijo - prefijo);
+  if (sufijo == 0 && pantalla_contar_celdas(anterior, anterior_len)
+                     > pantalla_contar_celdas(nueva, nueva_len)) {
+    marco_agregar_cadena(self->salida, ANSI_BORRAR_LINEA);
+  }
+}
+
+/**
+ * Manda a la terminal el cuadro que se armó desde la última vez que se
+ * presentó, dibujando solo las diferencias con el cuadro anterior. Todo lo
+ * que se haya escrito abajo del cuadro (por ejemplo, las preguntas al
+ * usuario) se borra.
+ */
+void pantalla_presentar(Pantalla *self)
+{
+  const char *nueva, *anterior, *nueva_fin, *anterior_fin;
+  size_t fila = 0, filas_nuevas = 0;
+  Marco *temporal;
+
+  if (self == NULL) {
+    return;
+  }
+
+  if (!self->terminal) {
+    pantalla_volcar(self, self->actual);
+    return;
+  }
+
+  nueva = marco_get_datos(self->actual);
+  nueva_fin = nueva + marco_get_len(self->actual);
+  anterior = marco_get_datos(self->anterior);
+  anterior_fin = anterior + marco_get_len(self->anterior);
+
+  marco_agregar_cadena(self->salida, ANSI_OCULTAR_CURSOR);
+  while (nueva < nueva_fin || anterior < anterior_fin) {
+    const char *nueva_salto, *anterior_salto;
+
+    if (nueva < nueva_fin) {
+      filas_nuevas++;
+    }
+    nueva_salto = memchr(nueva, '\n', nueva_fin - nueva);
+    if (nueva_salto == NULL) {
+      nueva_salto = nueva_fin;
+    }
+    anterior_salto = memchr(anterior, '\n', anterior_fin - anterior);
+    if (anterior_salto == NULL) {
+      anterior_salto = anterior_fin;
+    }
+
+    pantalla_presentar_linea(self, fila, nueva, nueva_salto - nueva,
+                             anterior, anterior_salto - anterior);
+
+    nueva = nueva_salto < nueva_fin ? nueva_salto + 1 : nueva_fin;
+    anterior = anterior_salto < anterior_fin ? anterior_salto + 1 : anterior_fin;
+    fila++;
+  }
+
+  /*
+   * Dejamos el cursor justo abajo del cuadro, como si lo hubieramos impreso
+   * completo, y borramos lo que haya quedado del cuadro anterior
+   */
+  pantalla_mover_cursor(self, filas_nuevas, 0);
+  marco_agregar_cadena(self->salida, ANSI_BORRAR_ABAJO);
+  marco_agregar_cadena(self->salida, ANSI_MOSTRAR_CURSOR);
+  pantalla_volcar(self, self->salida);
+
+  temporal = self->anterior;
+  self->anterior = self->actual;
+  self->actual = temporal;
+  marco_vaciar(self->actual);
+}
+
+void pantalla_destruir(Pantalla *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  marco_destruir(self->actual);
+  marco_destruir(self->anterior);
+  marco_destruir(self->salida);
+  free(self);
+}
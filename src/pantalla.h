@@ -0,0 +1,31 @@
+/* pantalla.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "marco.h"
+
+/*
+ * Una pantalla recuerda el último cuadro que se dibujó en la terminal. Cada
+ * cuadro nuevo se arma en el marco de pantalla_get_cuadro() y al presentarlo
+ * solo se mandan las celdas que cambiaron, con secuencias de escape ANSI para
+ * mover el cursor, en lugar de borrar y volver a dibujar todo.
+ */
+struct __Pantalla;
+typedef struct __Pantalla Pantalla;
+
+Pantalla *pantalla_nueva(void);
+Pantalla *pantalla_nueva_en(int, bool);
+void pantalla_limpiar(Pantalla *);
+Marco *pantalla_get_cuadro(Pantalla *);
+void pantalla_presentar(Pantalla *);
+void pantalla_destruir(Pantalla *);
@@ -0,0 +1,291 @@
+/* paquete.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "paquete.h"
+
+struct __Paquete {
+  const char *datos;
+  size_t size;
+  bool mapeado;
+  const PaqueteCabecera *cabecera;
+  const PaqueteEntrada *entradas;
+};
+
+bool paquete_validar(Paquete *);
+const PaqueteEntrada *paquete_get_entrada(Paquete *, size_t);
+
+/**
+ * Abre el paquete de recursos en @camino. El archivo se mapea completo en
+ * memoria y las categorías y texturas que se creen a partir de él apuntan
+ * directamente al mapeo, así que deben destruirse antes de cerrar el paquete.
+ *
+ * @camino El camino al archivo .pak
+ *
+ * Returns: El paquete, o NULL si no existe o no es válido
+ */
+Paquete *paquete_abrir(const char *camino)
+{
+  Paquete *self = NULL;
+  struct stat info;
+  void *mapa;
+  int fd;
+
+  if (camino == NULL) {
+    return NULL;
+  }
+
+  fd = open(camino, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return NULL;
+  }
+  if (fstat(fd, &info) == -1 || info.st_size < sizeof(PaqueteCabecera)) {
+    close(fd);
+    return NULL;
+  }
+
+  mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return NULL;
+  }
+
+  self = paquete_nuevo_desde_memoria(mapa, info.st_size);
+  if (self == NULL) {
+    fprintf (stderr, "El paquete %s no es válido\n", camino);
+    munmap(mapa, info.st_size);
+    return NULL;
+  }
+  self->mapeado = true;
+
+  return self;
+}
+
+/**
+ * Crea un paquete sobre @size bytes que ya están en memoria, como los que se
+ * meten dentro del ejecutable al compilar. @datos debe estar alineado a 8
+ * bytes y vivir más que el paquete.
+ *
+ * @datos El contenido de un archivo .pak
+ * @size La longitud de @datos
+ *
+ * Returns: El paquete, o NULL si @datos no es un paquete válido
+ */
+Paquete *paquete_nuevo_desde_memoria(const void *datos,
+                                     size_t      size)
+{
+  Paquete *self = NULL;
+
+  if (datos == NULL || size < sizeof(PaqueteCabecera)) {
+    return NULL;
+  }
+
+  self = malloc(sizeof(Paquete));
+  self->datos = datos;
+  self->size = size;
+  self->mapeado = false;
+  self->cabecera = datos;
+  self->entradas = NULL;
+
+  if (!paquete_validar(self)) {
+    free(self);
+    return NULL;
+  }
+  self->entradas = (const PaqueteEntrada *)
+    &self->datos[self->cabecera->entradas_offset];
+
+  return self;
+}
+
+/**
+ * Revisa que la cabecera y el directorio de @self no se salgan del archivo,
+ * y que cada línea de las texturas quede dentro de sus datos. Las palabras
+ * de las categorías se revisan hasta que se carga cada una (ver
+ * categoria_validar_datos()), para que abrir un paquete cueste lo mismo sin
+ * importar cuántas palabras tenga.
+ */
+bool paquete_validar(Paquete *self)
+{
+  const PaqueteCabecera *cabecera = self->cabecera;
+  const PaqueteEntrada *entradas;
+
+  if (memcmp(cabecera->magia, PAQUETE_MAGIA, sizeof(cabecera->magia)) != 0) {
+    return false;
+  }
+  if (cabecera->version != PAQUETE_VERSION || cabecera->size != self->size) {
+    return false;
+  }
+  if (cabecera->entradas_offset % sizeof(uint32_t) != 0
+      || cabecera->entradas_offset > self->size
+      || cabecera->n_entradas > (self->size - cabecera->entradas_offset)
+                                / sizeof(PaqueteEntrada)) {
+    return false;
+  }
+  if (cabecera->nombres_len == 0
+      || (uint64_t) cabecera->nombres_offset + cabecera->nombres_len > self->size
+      || self->datos[cabecera->nombres_offset + cabecera->nombres_len - 1] != 0) {
+    return false;
+  }
+
+  entradas = (const PaqueteEntrada *) &self->datos[cabecera->entradas_offset];
+  for (size_t i = 0; i < cabecera->n_entradas; i++) {
+    const PaqueteEntrada *entrada = &entradas[i];
+    if (entrada->nombre >= cabecera->nombres_len) {
+      return false;
+    }
+    if (entrada->palabras_offset % sizeof(uint32_t) != 0
+        || (uint64_t) entrada->palabras_offset
+           + (uint64_t) entrada->n_palabras * sizeof(CategoriaPalabra)
+           > self->size) {
+      return false;
+    }
+    if ((uint64_t) entrada->datos_offset + entrada->datos_len > self->size) {
+      return false;
+    }
+    // Las texturas son pocas líneas; paquete_crear_textura() las usa tal cual
+    if (entrada->tipo == PAQUETE_TEXTURA
+        && !categoria_validar_palabras(&self->datos[entrada->datos_offset],
+                                       entrada->datos_len,
+                                       (const CategoriaPalabra *)
+                                       &self->datos[entrada->palabras_offset],
+                                       entrada->n_palabras)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const PaqueteEntrada *paquete_get_entrada(Paquete *self, size_t indice)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  if (indice >= self->cabecera->n_entradas) {
+    return NULL;
+  }
+  return &self->entradas[indice];
+}
+
+/**
+ * Retorna el número de entradas (categorías y texturas) de @self
+ */
+size_t paquete_get_n_entradas(Paquete *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->cabecera->n_entradas;
+}
+
+/**
+ * Retorna el tipo de la entrada @indice de @self, o PAQUETE_NINGUNO si
+ * @indice no es válido
+ */
+PaqueteTipo paquete_get_tipo(Paquete *self, size_t indice)
+{
+  const PaqueteEntrada *entrada = paquete_get_entrada(self, indice);
+  if (entrada == NULL) {
+    return PAQUETE_NINGUNO;
+  }
+  return entrada->tipo;
+}
+
+/**
+ * Retorna el nombre de la entrada @indice de @self
+ *
+ * Returns: (transfer: none) El nombre, o NULL si @indice no es válido
+ */
+const char *paquete_get_nombre(Paquete *self, size_t indice)
+{
+  const PaqueteEntrada *entrada = paquete_get_entrada(self, indice);
+  if (entrada == NULL) {
+    return NULL;
+  }
+  return &self->datos[self->cabecera->nombres_offset + entrada->nombre];
+}
+
+/**
+ * Crea una categoría a partir de la entrada @indice de @self. No se copia
+ * ninguna palabra: la categoría lee directamente del paquete.
+ *
+ * @arena (nullable) Donde alojar la categoría, o NULL para usar malloc
+ *
+ * Returns: La categoría, o NULL si la entrada no es una categoría
+ */
+Categoria *paquete_crear_categoria(Paquete *self,
+                                   size_t   indice,
+                                   Arena   *arena)
+{
+  const PaqueteEntrada *entrada = paquete_get_entrada(self, indice);
+  if (entrada == NULL || entrada->tipo != PAQUETE_CATEGORIA) {
+    return NULL;
+  }
+  return categoria_nueva_desde_memoria(paquete_get_nombre(self, indice),
+                                       &self->datos[entrada->datos_offset],
+                                       entrada->datos_len,
+                                       (const CategoriaPalabra *)
+                                       &self->datos[entrada->palabras_offset],
+                                       entrada->n_palabras,
+                                       arena);
+}
+
+/**
+ * Crea una textura a partir de la entrada @indice de @self. Las lineas de la
+ * textura se copian del paquete, rellenadas, a un solo bloque.
+ *
+ * @arena (nullable) Donde alojar la textura, o NULL para usar malloc
+ *
+ * Returns: La textura, o NULL si la entrada no es una textura
+ */
+Textura *paquete_crear_textura(Paquete *self,
+                               size_t   indice,
+                               Arena   *arena)
+{
+  const PaqueteEntrada *entrada = paquete_get_entrada(self, indice);
+  const CategoriaPalabra *filas;
+  const char **lineas;
+  Textura *textura;
+
+  if (entrada == NULL || entrada->tipo != PAQUETE_TEXTURA) {
+    return NULL;
+  }
+
+  filas = (const CategoriaPalabra *) &self->datos[entrada->palabras_offset];
+  lineas = calloc(entrada->n_palabras, sizeof(char *));
+  for (size_t i = 0; i < entrada->n_palabras; i++) {
+    lineas[i] = &self->datos[entrada->datos_offset + filas[i].offset];
+  }
+  textura = textura_nueva_desde_memoria(lineas, entrada->n_palabras, arena);
+  free(lineas);
+
+  return textura;
+}
+
+/**
+ * Cierra @self. Las categorías y texturas creadas a partir de él ya deben
+ * haberse destruido.
+ */
+void paquete_cerrar(Paquete *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  if (self->mapeado) {
+    munmap((void *) self->datos, self->size);
+  }
+  free(self);
+}
@@ -0,0 +1,73 @@
+/* paquete.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "categoria.h"
+#include "textura.h"
+
+/*
+ * Un paquete (.pak) junta todas las categorías y texturas del juego en un solo
+ * archivo que se genera al compilar con adivinador-empaquetar. Está pensado
+ * para cargarse con un solo mmap y sin leer nada línea por línea:
+ *
+ *   PaqueteCabecera
+ *   PaqueteEntrada[n_entradas]
+ *   tabla de nombres (cadenas terminadas en NUL)
+ *   por cada entrada: CategoriaPalabra[n_palabras] y después sus palabras,
+ *   cada una terminada en NUL
+ *
+ * Todos los offsets son desde el inicio del archivo, menos los de la tabla de
+ * palabras, que son desde el inicio de los datos de su entrada (igual que en
+ * una Categoria). Los enteros se guardan en el orden de bytes de la máquina
+ * que compila, que es la misma que va a jugar.
+ */
+#define PAQUETE_MAGIA "ADVNPAK"
+#define PAQUETE_VERSION 2
+
+typedef enum {
+  PAQUETE_NINGUNO = 0,
+  PAQUETE_CATEGORIA = 1,
+  PAQUETE_TEXTURA = 2,
+} PaqueteTipo;
+
+typedef struct {
+  char     magia[8];
+  uint32_t version;
+  uint32_t n_entradas;
+  uint32_t entradas_offset;
+  uint32_t nombres_offset;
+  uint32_t nombres_len;
+  uint32_t reservado;
+  uint64_t size;
+} PaqueteCabecera;
+
+typedef struct {
+  uint32_t tipo;
+  uint32_t nombre;
+  uint32_t n_palabras;
+  uint32_t palabras_offset;
+  uint32_t datos_offset;
+  uint32_t datos_len;
+} PaqueteEntrada;
+
+struct __Paquete;
+typedef struct __Paquete Paquete;
+
+Paquete *paquete_abrir(const char *);
+Paquete *paquete_nuevo_desde_memoria(const void *, size_t);
+size_t paquete_get_n_entradas(Paquete *);
+PaqueteTipo paquete_get_tipo(Paquete *, size_t);
+const char *paquete_get_nombre(Paquete *, size_t);
+Categoria *paquete_crear_categoria(Paquete *, size_t, Arena *);
+Textura *paquete_crear_textura(Paquete *, size_t, Arena *);
+void paquete_cerrar(Paquete *);
@@ -0,0 +1,502 @@
+/* partida.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "azar.h"
+#include "bitacora.h"
+#include "metricas.h"
+#include "partida.h"
+#include "u8.h"
+
+/**
+ * Todo lo que vive lo mismo que una ronda (la palabra, su progreso y cada
+ * intento) se aloja en @arena, que se reinicia al elegir la siguiente
+ * palabra. Cada partida tiene su propio generador, @azar, así que no pisa
+ * los números de las demás; @semilla es con la que se sembró, para poder
+ * repetir la partida.
+ *
+ * @dificultad es la de la última palabra, o PARTIDA_CUALQUIER_DIFICULTAD si
+ * se eligió entre todas, y la que partida_elegir_palabra_adaptativa() ajusta
+ * según cómo le fue al jugador.
+ *
+ * Si tiene @bitacora, cada palabra y cada intento se anotan ahí como la
+ * sesión número @sesion.
+ */
+struct __Partida {
+  int vidas;
+  PartidaEstado estado;
+  Categoria *categoria;
+  Palabra *palabra;
+  Arena *arena;
+  Azar azar;
+  uint64_t semilla;
+  CategoriaDificultad dificultad;
+  Bitacora *bitacora;
+  uint64_t sesion;
+};
+
+void partida_empezar_ronda(Partida *, const char *, size_t, bool);
+void partida_anotar_intento(Partida *, char, const char *, PartidaIntento);
+PartidaIntento partida_restar_vida(Partida *, PartidaIntento);
+PartidaIntento partida_probar_caracter(Partida *, const char *);
+PartidaIntento partida_probar_palabra(Partida *, const char *);
+void partida_medir_intento(const char *, uint64_t);
+void partida_medir_ronda(Partida *);
+
+/**
+ * Crea una partida nueva, todavía sin palabra
+ *
+ * Returns: La partida nueva
+ */
+Partida *partida_nueva(void)
+{
+  Partida *self;
+
+  self = malloc(sizeof(Partida));
+  self->vidas = PARTIDA_VIDAS;
+  self->estado = PARTIDA_SIN_PALABRA;
+  self->categoria = NULL;
+  self->palabra = NULL;
+  self->arena = arena_nueva(1024);
+  self->dificultad = CATEGORIA_MEDIA;
+  self->bitacora = NULL;
+  self->sesion = 0;
+  partida_sembrar(self, azar_semilla_nueva());
+
+  return self;
+}
+
+/**
+ * Siembra el generador de @self, para que las palabras que elija
+ * partida_elegir_palabra() de aquí en adelante salgan siempre en el mismo
+ * orden con la misma @semilla
+ */
+void partida_sembrar(Partida  *self,
+                     uint64_t  semilla)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->semilla = semilla;
+  azar_sembrar(&self->azar, semilla);
+  bitacora_sesion(self->bitacora, self->sesion, semilla);
+}
+
+/**
+ * Anota en @bitacora todo lo que pase en @self de aquí en adelante, como la
+ * sesión @sesion, empezando por su semilla
+ *
+ * @bitacora (nullable) La bitácora, o NULL para dejar de anotar
+ * @sesion El número de la sesión dentro de @bitacora
+ */
+void partida_set_bitacora(Partida  *self,
+                          Bitacora *bitacora,
+                          uint64_t  sesion)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->bitacora = bitacora;
+  self->sesion = sesion;
+  bitacora_sesion(self->bitacora, self->sesion, self->semilla);
+}
+
+/**
+ * Returns: La semilla con la que se sembró @self por última vez
+ */
+uint64_t partida_get_semilla(Partida *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->semilla;
+}
+
+/**
+ * Elige una palabra aleatoria de @categoria y empieza una ronda nueva con
+ * todas las vidas
+ *
+ * @categoria La categoría de la que se elige la palabra
+ */
+void partida_elegir_palabra(Partida   *self,
+                            Categoria *categoria)
+{
+  int n_palabras;
+  uint64_t inicio;
+
+  if (self == NULL || categoria == NULL) {
+    return;
+  }
+
+  n_palabras = categoria_get_n_palabras(categoria);
+  if (n_palabras <= 0) {
+    return;
+  }
+  inicio = metricas_ahora();
+  self->dificultad = PARTIDA_CUALQUIER_DIFICULTAD;
+  partida_elegir_palabra_indice(self, categoria,
+                                azar_acotado(&self->azar, n_palabras));
+  metricas_evento("partida_elegir_palabra", inicio, metricas_ahora());
+}
+
+/**
+ * Elige una palabra aleatoria de dificultad @dificultad de @categoria y
+ * empieza una ronda nueva con todas las vidas. Si @categoria no tiene
+ * palabras de esa dificultad (por ejemplo, si está indexada), la elige entre
+ * todas, y la dificultad de la ronda queda como PARTIDA_CUALQUIER_DIFICULTAD.
+ *
+ * @categoria La categoría de la que se elige la palabra
+ * @dificultad La dificultad de la palabra
+ */
+void partida_elegir_palabra_dificultad(Partida             *self,
+                                       Categoria           *categoria,
+                                       CategoriaDificultad  dificultad)
+{
+  int n_palabras, indice;
+  uint64_t inicio;
+
+  if (self == NULL || categoria == NULL) {
+    return;
+  }
+
+  n_palabras = categoria_get_n_palabras_dificultad(categoria, dificultad);
+  if (n_palabras <= 0) {
+    partida_elegir_palabra(self, categoria);
+    return;
+  }
+  inicio = metricas_ahora();
+  indice = categoria_get_palabra_dificultad(categoria, dificultad,
+                                            azar_acotado(&self->azar, n_palabras));
+  self->dificultad = dificultad;
+  partida_elegir_palabra_indice(self, categoria, indice);
+  metricas_evento("partida_elegir_palabra", inicio, metricas_ahora());
+}
+
+/**
+ * Como partida_elegir_palabra_dificultad(), pero la dificultad sube un
+ * nivel si el jugador ganó la ronda anterior y baja uno si la perdió. La
+ * primera ronda, y la que sigue a una palabra elegida entre todas, es de
+ * dificultad media.
+ *
+ * @categoria La categoría de la que se elige la palabra
+ */
+void partida_elegir_palabra_adaptativa(Partida   *self,
+                                       Categoria *categoria)
+{
+  CategoriaDificultad dificultad;
+
+  if (self == NULL) {
+    return;
+  }
+
+  dificultad = self->dificultad;
+  if (dificultad >= CATEGORIA_N_DIFICULTADES) {
+    dificultad = CATEGORIA_MEDIA;
+  } else if (self->estado == PARTIDA_GANADA && dificultad + 1 < CATEGORIA_N_DIFICULTADES) {
+    dificultad++;
+  } else if (self->estado == PARTIDA_PERDIDA && dificultad > CATEGORIA_FACIL) {
+    dificultad--;
+  }
+  partida_elegir_palabra_dificultad(self, categoria, dificultad);
+}
+
+/**
+ * Returns: La dificultad de la palabra que se está adivinando, o
+ * PARTIDA_CUALQUIER_DIFICULTAD si se eligió entre todas
+ */
+CategoriaDificultad partida_get_dificultad(Partida *self)
+{
+  if (self == NULL) {
+    return CATEGORIA_MEDIA;
+  }
+  return self->dificultad;
+}
+
+/**
+ * Empieza una ronda nueva con todas las vidas y la palabra @indice de
+ * @categoria
+ *
+ * @categoria La categoría de la que se elige la palabra
+ * @indice El índice de la palabra dentro de @categoria
+ */
+void partida_elegir_palabra_indice(Partida   *self,
+                                   Categoria *categoria,
+                                   size_t     indice)
+{
+  const char *palabra;
+  int longitud;
+
+  if (self == NULL || categoria == NULL) {
+    return;
+  }
+  longitud = categoria_get_longitud_palabra(categoria, indice);
+  if (longitud < 0) {
+    self->palabra = NULL;
+    self->estado = PARTIDA_SIN_PALABRA;
+    return;
+  }
+
+  /*
+   * Vamos a hacer copias de las palabras que seleccionemos. Todo lo de la
+   * ronda anterior vive en la arena, así que la reiniciamos para liberarlo
+   * de golpe y reutilizar su memoria. Si la categoría está indexada, la
+   * palabra se lee del archivo directo a la arena.
+   *
+   * Al crear la palabra se arma su índice de letras, así que cada intento
+   * solo toca las posiciones de la letra adivinada.
+   */
+  partida_medir_ronda(self);
+  arena_reiniciar(self->arena);
+  palabra = categoria_leer_palabra(categoria, indice, self->arena);
+  if (palabra == NULL) {
+    self->palabra = NULL;
+    self->estado = PARTIDA_SIN_PALABRA;
+    return;
+  }
+  partida_empezar_ronda(self, palabra, longitud,
+                        categoria_palabra_es_ascii(categoria, indice));
+  self->categoria = categoria;
+  bitacora_ronda(self->bitacora, self->sesion, categoria_get_nombre(categoria),
+                 indice, self->dificultad, palabra, longitud);
+}
+
+/**
+ * Empieza una ronda nueva con todas las vidas y la palabra @texto, que no
+ * sale de ninguna categoría. Sirve para repetir una ronda de la bitácora.
+ *
+ * @texto La palabra, en UTF-8
+ * @len Cuántos bytes mide @texto
+ */
+void partida_elegir_palabra_texto(Partida    *self,
+                                  const char *texto,
+                                  size_t      len)
+{
+  if (self == NULL || texto == NULL) {
+    return;
+  }
+  partida_medir_ronda(self);
+  arena_reiniciar(self->arena);
+  partida_empezar_ronda(self, texto, len, u8_es_ascii(texto, len));
+  self->categoria = NULL;
+}
+
+/**
+ * Empieza la ronda con @palabra, que ya debe vivir lo mismo que la ronda o
+ * más
+ */
+void partida_empezar_ronda(Partida    *self,
+                           const char *palabra,
+                           size_t      len,
+                           bool        ascii)
+{
+  self->palabra = palabra_nueva(palabra, len, ascii, self->arena);
+  self->vidas = PARTIDA_VIDAS;
+  self->estado = palabra_completa(self->palabra) ? PARTIDA_GANADA
+                                                 : PARTIDA_EN_CURSO;
+  metricas_contar(METRICAS_RONDAS, 1);
+}
+
+/**
+ * Registra cuánto se alojó en la ronda que está por terminar, si la hubo
+ */
+void partida_medir_ronda(Partida *self)
+{
+  if (!metricas_activas || self->palabra == NULL) {
+    return;
+  }
+  metricas_registrar(METRICAS_ALOJAMIENTOS_RONDA,
+                     arena_get_n_alojamientos(self->arena));
+  metricas_registrar(METRICAS_BYTES_RONDA, arena_get_alojado(self->arena));
+}
+
+/**
+ * Registra la latencia de un intento que empezó en @inicio, y lo agrega a
+ * la traza como @nombre
+ */
+void partida_medir_intento(const char *nombre,
+                           uint64_t    inicio)
+{
+  uint64_t fin;
+
+  if (!metricas_activas) {
+    return;
+  }
+  fin = metricas_ahora();
+  metricas_contar(METRICAS_INTENTOS, 1);
+  metricas_registrar(METRICAS_LATENCIA_INTENTO, fin - inicio);
+  metricas_evento(nombre, inicio, fin);
+}
+
+/**
+ * Anota en la bitácora de @self, si tiene, el intento @intento de tipo
+ * @tipo y cómo quedó la partida
+ */
+void partida_anotar_intento(Partida        *self,
+                            char            tipo,
+                            const char     *intento,
+                            PartidaIntento  resultado)
+{
+  if (self == NULL || self->bitacora == NULL || intento == NULL) {
+    return;
+  }
+  bitacora_intento(self->bitacora, self->sesion, tipo, intento, resultado,
+                   self->vidas, self->estado);
+}
+
+/**
+ * Le quita una vida a @self por el intento @intento, y la da por perdida si
+ * ya no le quedan
+ *
+ * Returns: @intento
+ */
+PartidaIntento partida_restar_vida(Partida        *self,
+                                   PartidaIntento  intento)
+{
+  self->vidas--;
+  if (self->vidas <= 0) {
+    self->estado = PARTIDA_PERDIDA;
+  }
+  return intento;
+}
+
+/**
+ * Intenta revelar en la palabra el primer caracter de @intento.
+ *
+ * Desafortunadamente, no podemos utilizar caracteres ASCII para español, ya
+ * que palabras con acento y la ñ no se revelarán correctamente si es que el
+ * usuario la adivina. Decodificamos el primer caracter UTF-8 y lo plegamos
+ * una sola vez, igual que las letras de la palabra.
+ *
+ * https://dev.to/rdentato/utf-8-strings-in-c-1-3-42a4
+ *
+ * @intento Lo que escribió el jugador, en UTF-8
+ *
+ * Returns: Lo que pasó con el intento
+ */
+PartidaIntento partida_intentar_caracter(Partida    *self,
+                                         const char *intento)
+{
+  uint64_t inicio = metricas_ahora();
+  PartidaIntento retval = partida_probar_caracter(self, intento);
+
+  partida_medir_intento("partida_intentar_caracter", inicio);
+  partida_anotar_intento(self, 'c', intento, retval);
+  return retval;
+}
+
+PartidaIntento partida_probar_caracter(Partida    *self,
+                                       const char *intento)
+{
+  size_t c_len;
+  uint32_t clave;
+
+  if (self == NULL || intento == NULL || self->estado != PARTIDA_EN_CURSO) {
+    return PARTIDA_INTENTO_INVALIDO;
+  }
+
+  clave = u8_plegar(u8_decodificar(intento, strlen(intento), &c_len));
+  if (palabra_letra_adivinada(self->palabra, clave)) {
+    return partida_restar_vida(self, PARTIDA_INTENTO_REPETIDO);
+  }
+  if (palabra_revelar(self->palabra, clave) == 0) {
+    return partida_restar_vida(self, PARTIDA_INTENTO_FALLO);
+  }
+
+  if (palabra_completa(self->palabra)) {
+    self->estado = PARTIDA_GANADA;
+  }
+  return PARTIDA_INTENTO_ACIERTO;
+}
+
+/**
+ * Intenta adivinar la palabra completa. Se compara sin importar mayúsculas
+ * ni acentos, así que "mexico" adivina "México".
+ *
+ * @intento La palabra que escribió el jugador, en UTF-8
+ *
+ * Returns: Lo que pasó con el intento
+ */
+PartidaIntento partida_intentar_palabra(Partida    *self,
+                                        const char *intento)
+{
+  uint64_t inicio = metricas_ahora();
+  PartidaIntento retval = partida_probar_palabra(self, intento);
+
+  partida_medir_intento("partida_intentar_palabra", inicio);
+  partida_anotar_intento(self, 'p', intento, retval);
+  return retval;
+}
+
+PartidaIntento partida_probar_palabra(Partida    *self,
+                                      const char *intento)
+{
+  if (self == NULL || intento == NULL || self->estado != PARTIDA_EN_CURSO) {
+    return PARTIDA_INTENTO_INVALIDO;
+  }
+
+  if (!palabra_comparar(self->palabra, intento)) {
+    return partida_restar_vida(self, PARTIDA_INTENTO_FALLO);
+  }
+  self->estado = PARTIDA_GANADA;
+  return PARTIDA_INTENTO_ACIERTO;
+}
+
+PartidaEstado partida_get_estado(Partida *self)
+{
+  if (self == NULL) {
+    return PARTIDA_SIN_PALABRA;
+  }
+  return self->estado;
+}
+
+int partida_get_vidas(Partida *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->vidas;
+}
+
+/**
+ * Returns: (transfer: none) La categoría de la ronda actual, o NULL
+ */
+Categoria *partida_get_categoria(Partida *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->categoria;
+}
+
+/**
+ * Returns: (transfer: none) La palabra de la ronda actual, o NULL. Vive hasta
+ * que se elige la siguiente palabra.
+ */
+Palabra *partida_get_palabra(Partida *self)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  return self->palabra;
+}
+
+void partida_destruir(Partida *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  partida_medir_ronda(self);
+  bitacora_fin(self->bitacora, self->sesion);
+  arena_destruir(self->arena);
+  free(self);
+}
@@ -0,0 +1,77 @@
+/* partida.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bitacora.h"
+#include "categoria.h"
+#include "palabra.h"
+
+#define PARTIDA_VIDAS 5
+
+/*
+ * La dificultad de una palabra que se eligió entre todas las de su
+ * categoría, sin ver de cuál tercio era
+ */
+#define PARTIDA_CUALQUIER_DIFICULTAD CATEGORIA_N_DIFICULTADES
+
+/**
+ * En qué va una partida: todavía se está adivinando la palabra, o ya se
+ * ganó o se perdió
+ */
+typedef enum {
+  PARTIDA_SIN_PALABRA,
+  PARTIDA_EN_CURSO,
+  PARTIDA_GANADA,
+  PARTIDA_PERDIDA
+} PartidaEstado;
+
+/**
+ * Lo que pasó con un intento. Tanto fallar como repetir una letra cuestan
+ * una vida; un intento inválido (por ejemplo, cuando la partida ya terminó)
+ * no cuesta nada.
+ */
+typedef enum {
+  PARTIDA_INTENTO_ACIERTO,
+  PARTIDA_INTENTO_FALLO,
+  PARTIDA_INTENTO_REPETIDO,
+  PARTIDA_INTENTO_INVALIDO
+} PartidaIntento;
+
+/*
+ * Una partida es el estado de un jugador: sus vidas, la categoría que eligió
+ * y la palabra que está adivinando. No comparte nada con las demás partidas
+ * más que las categorías, que solo lee, así que un mismo proceso puede
+ * llevar tantas partidas como quiera.
+ */
+struct __Partida;
+typedef struct __Partida Partida;
+
+Partida *partida_nueva(void);
+void partida_sembrar(Partida *, uint64_t);
+uint64_t partida_get_semilla(Partida *);
+void partida_set_bitacora(Partida *, Bitacora *, uint64_t);
+void partida_elegir_palabra(Partida *, Categoria *);
+void partida_elegir_palabra_dificultad(Partida *, Categoria *,
+                                       CategoriaDificultad);
+void partida_elegir_palabra_adaptativa(Partida *, Categoria *);
+void partida_elegir_palabra_indice(Partida *, Categoria *, size_t);
+void partida_elegir_palabra_texto(Partida *, const char *, size_t);
+CategoriaDificultad partida_get_dificultad(Partida *);
+PartidaIntento partida_intentar_caracter(Partida *, const char *);
+PartidaIntento partida_intentar_palabra(Partida *, const char *);
+PartidaEstado partida_get_estado(Partida *);
+int partida_get_vidas(Partida *);
+Categoria *partida_get_categoria(Partida *);
+Palabra *partida_get_palabra(Partida *);
+void partida_destruir(Partida *);
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+#
+# probar-servidor.py
+#
+# Copyright 2023 Diego Iván M.E
+# Copyright 2023 Juan Pablo Alquicer
+# Copyright 2023 Mariana García
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""
+Levanta `adivinador --serve` en 127.0.0.1, conecta varios jugadores a la vez
+y cada uno juega una ronda completa: elige la categoría por su nombre,
+pierde con cinco palabras equivocadas, revisa que la palabra que le
+muestran al final sea de la lista, y se despide. Sale con 1 si alguna
+conversación no fue la esperada.
+
+Uso: probar-servidor.py [--repetir REPETIR] [--puntajes PUNTAJES]
+                         ADIVINADOR LISTA [N_JUGADORES]
+
+LISTA es el archivo de la categoría que se juega; la categoría se llama
+como el archivo. Con --repetir, el servidor escribe una bitácora y al
+terminar se repite con REPETIR (adivinador-repetir), que debe encontrar
+una sesión, una ronda y cinco intentos por jugador, y ninguna diferencia.
+Con --puntajes, el servidor lleva un marcador y al terminar PUNTAJES
+(adivinador-puntajes) debe contar una partida perdida por jugador.
+"""
+
+import codecs
+import os
+import re
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+
+ESPERA = 10
+INTENTOS = 5
+
+
+def puerto_libre():
+    with socket.socket() as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+class Jugador:
+    def __init__(self, puerto):
+        self.socket = socket.create_connection(('127.0.0.1', puerto), ESPERA)
+        self.socket.settimeout(ESPERA)
+        self.transcripcion = ''
+        self.pendiente = ''
+        # Un carácter de UTF-8 puede llegar partido entre dos recv()
+        self.decodificador = codecs.getincrementaldecoder('utf-8')()
+
+    def esperar(self, texto):
+        """Lee hasta que llegue @texto y regresa lo que llegó antes"""
+        while texto not in self.pendiente:
+            datos = self.socket.recv(65536)
+            if not datos:
+                raise EOFError('se cerró esperando %r' % texto)
+            recibido = self.decodificador.decode(datos)
+            self.transcripcion += recibido
+            self.pendiente += recibido
+        antes, _, self.pendiente = self.pendiente.partition(texto)
+        return antes
+
+    def mandar(self, linea):
+        self.socket.sendall((linea + '\n').encode())
+
+    def jugar(self, categoria, palabras):
+        self.esperar('PRESIONE ENTER PARA COMENZAR')
+        self.mandar('')
+        self.esperar('Seleccione la categoría')
+        self.mandar(categoria)
+        for i in range(INTENTOS):
+            self.esperar('Ingrese el tipo de intento')
+            self.mandar('2')
+            self.esperar('Ingrese la palabra: ')
+            self.mandar('zzqzz')
+        self.esperar('La palabra era: ')
+        palabra = self.esperar('\n')
+        if palabra not in palabras:
+            raise ValueError('la palabra %r no es de %s' % (palabra, categoria))
+        self.esperar('¿Desea iniciar una nueva partida? (s/n): ')
+        self.mandar('n')
+        self.esperar('¡Hasta luego!')
+        # El servidor cierra la conexión al despedirse
+        while self.socket.recv(65536):
+            pass
+        self.socket.close()
+
+
+def repetir(programa, bitacora, n_jugadores):
+    """Repite @bitacora y regresa los errores que encontró"""
+    resultado = subprocess.run([programa, bitacora], stdout=subprocess.PIPE,
+                               text=True)
+    esperado = '(%d sesiones, %d rondas, %d intentos)' % (
+        n_jugadores, n_jugadores, n_jugadores * INTENTOS)
+    if (resultado.returncode != 0 or esperado not in resultado.stdout
+            or not re.search(r'^0 diferencias$', resultado.stdout, re.M)):
+        return ['la bitácora no se repitió igual, se esperaba %s:\n%s' % (
+            esperado, resultado.stdout)]
+    return []
+
+
+def puntajes(programa, marcador, n_jugadores):
+    """Lee @marcador y regresa los errores que encontró"""
+    resultado = subprocess.run([programa, marcador], stdout=subprocess.PIPE,
+                               text=True)
+    esperado = 'Total: %d partidas, 0 ganadas' % n_jugadores
+    if resultado.returncode != 0 or esperado not in resultado.stdout:
+        return ['el marcador no tiene lo que se jugó, se esperaba %s:\n%s' % (
+            esperado, resultado.stdout)]
+    return []
+
+
+def main():
+    argumentos = sys.argv[1:]
+    programas = {'--repetir': None, '--puntajes': None}
+    while argumentos[:1] and argumentos[0] in programas and len(argumentos) > 1:
+        programas[argumentos[0]] = argumentos[1]
+        argumentos = argumentos[2:]
+    if len(argumentos) < 2:
+        print(__doc__.strip().split('\n\n')[1], file=sys.stderr)
+        return 1
+    adivinador, lista = argumentos[0], argumentos[1]
+    n_jugadores = int(argumentos[2]) if len(argumentos) > 2 else 8
+
+    with tempfile.TemporaryDirectory(prefix='probar-servidor-') as directorio:
+        opciones = []
+        bitacora = os.path.join(directorio, 'bitacora')
+        marcador = os.path.join(directorio, 'marcador')
+        if programas['--repetir']:
+            opciones += ['--journal', bitacora]
+        if programas['--puntajes']:
+            opciones += ['--scores', marcador]
+        errores = probar(adivinador, lista, n_jugadores, opciones)
+        if programas['--repetir'] and not errores:
+            errores += repetir(programas['--repetir'], bitacora, n_jugadores)
+        if programas['--puntajes'] and not errores:
+            errores += puntajes(programas['--puntajes'], marcador, n_jugadores)
+
+    for error in errores:
+        print(error, file=sys.stderr)
+    if not errores:
+        print('%d jugadores terminaron su ronda' % n_jugadores)
+    return 1 if errores else 0
+
+
+def probar(adivinador, lista, n_jugadores, opciones):
+    """Juega con @n_jugadores contra el servidor y regresa los errores"""
+    categoria = os.path.splitext(os.path.basename(lista))[0]
+    with open(lista, encoding='utf-8') as archivo:
+        palabras = set(linea.strip() for linea in archivo if linea.strip())
+
+    puerto = puerto_libre()
+    servidor = subprocess.Popen([adivinador, '--serve', '127.0.0.1:%d' % puerto,
+                                 '--threads', '2'] + opciones,
+                                stdout=subprocess.PIPE, text=True)
+    errores = []
+    try:
+        # Hasta que imprime esto ya está escuchando
+        if 'Escuchando' not in servidor.stdout.readline():
+            return ['el servidor no empezó']
+
+        def jugar(n):
+            jugador = None
+            try:
+                jugador = Jugador(puerto)
+                jugador.jugar(categoria, palabras)
+            except (OSError, EOFError, ValueError) as e:
+                # El final de la conversación basta para ver dónde se atoró
+                errores.append('jugador %d: %s\n%s' % (
+                    n, e, jugador.transcripcion[-500:] if jugador else ''))
+
+        hilos = [threading.Thread(target=jugar, args=(n,))
+                 for n in range(n_jugadores)]
+        for hilo in hilos:
+            hilo.start()
+        for hilo in hilos:
+            hilo.join()
+    finally:
+        servidor.send_signal(signal.SIGINT)
+        try:
+            servidor.wait(ESPERA)
+        except subprocess.TimeoutExpired:
+            servidor.kill()
+            errores.append('el servidor no terminó con SIGINT')
+
+    if servidor.returncode not in (0, -signal.SIGKILL):
+        errores.append('el servidor salió con %d' % servidor.returncode)
+    return errores
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,870 @@
+/* pruebas.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * adivinador-pruebas: revisa las partes del motor que tienen más de una
+ * implementación, o cuyos errores no se notan jugando. Cada prueba imprime
+ * lo que falló y sale con 1; meson test las corre todas.
+ *
+ * Uso:
+ *   adivinador-pruebas u8
+ *   adivinador-pruebas palabra
+ *   adivinador-pruebas indice
+ *   adivinador-pruebas pantalla
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "azar.h"
+#include "categoria.h"
+#include "indice.h"
+#include "marco.h"
+#include "palabra.h"
+#include "pantalla.h"
+#include "u8.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+/* Cuántos textos al azar se validan en "u8", y qué tan largos */
+#define PRUEBA_U8_CASOS 200000
+#define PRUEBA_U8_LONGITUD 200
+
+/* Cuántas palabras al azar se juegan en "palabra", y cuántos caracteres
+ * tienen a lo más */
+#define PRUEBA_PALABRAS 20000
+#define PRUEBA_PALABRA_CARACTERES 30
+
+/* Cuántas líneas tiene la lista que se indexa en "indice" */
+#define PRUEBA_INDICE_LINEAS 5000
+
+/* Cuántos cuadros se presentan en "pantalla", y el tamaño de la terminal que
+ * los recibe */
+#define PRUEBA_PANTALLA_CUADROS 20000
+#define PRUEBA_PANTALLA_FILAS 12
+#define PRUEBA_PANTALLA_COLUMNAS 256
+#define PRUEBA_PANTALLA_PIEZAS 16
+
+/**
+ * Una terminal de mentira que entiende las secuencias de escape que usa
+ * pantalla.c. Cada celda guarda los bytes de un caracter UTF-8; las vacías
+ * tienen @len en 0.
+ */
+typedef struct {
+  struct {
+    char bytes[4];
+    size_t len;
+  } celdas[PRUEBA_PANTALLA_FILAS][PRUEBA_PANTALLA_COLUMNAS];
+  size_t fila;
+  size_t columna;
+} PruebaTerminal;
+
+/* Las variantes de u8_validar() que u8.c no exporta */
+size_t u8_validar_escalar(const unsigned char *, size_t, size_t, size_t, bool *);
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) bool u8_validar_avx2(const unsigned char *,
+                                                     size_t, bool *);
+bool u8_validar_sse2(const unsigned char *, size_t, bool *);
+#endif
+
+int probar_u8(void);
+bool probar_u8_texto(const unsigned char *, size_t);
+size_t probar_u8_generar(Azar *, unsigned char *);
+int probar_palabra(void);
+bool probar_palabra_revisar(Palabra *, const uint32_t *, const bool *, size_t,
+                            const char *);
+int probar_indice(void);
+bool probar_indice_comparar(Categoria *, const char *, const char *, size_t);
+int probar_pantalla(void);
+size_t probar_pantalla_armar(Azar *, size_t[][PRUEBA_PANTALLA_PIEZAS],
+                             size_t *, size_t *, char *);
+bool probar_terminal_escribir(PruebaTerminal *, const char *, size_t);
+void probar_terminal_borrar(PruebaTerminal *, size_t, size_t, size_t);
+bool probar_terminal_comparar(PruebaTerminal *, const char *, size_t);
+void probar_imprimir_bytes(const unsigned char *, size_t);
+
+int main(int argc,
+         char **argv)
+{
+  if (argc >= 2 && strcmp(argv[1], "u8") == 0) {
+    return probar_u8();
+  }
+  if (argc >= 2 && strcmp(argv[1], "palabra") == 0) {
+    return probar_palabra();
+  }
+  if (argc >= 2 && strcmp(argv[1], "indice") == 0) {
+    return probar_indice();
+  }
+  if (argc >= 2 && strcmp(argv[1], "pantalla") == 0) {
+    return probar_pantalla();
+  }
+
+  fprintf(stderr,
+          "Uso: %s u8\n"
+          "     %s palabra\n"
+          "     %s indice\n"
+          "     %s pantalla\n",
+          argv[0], argv[0], argv[0], argv[0]);
+  return EXIT_FAILURE;
+}
+
+/**
+ * Valida con cada variante de u8_validar() casos conocidos, rodeados de
+ * ASCII para que caigan en cualquier posición de los bloques de 16 y 32
+ * bytes, y luego textos al azar, y revisa que todas den lo mismo que la
+ * versión escalar
+ */
+int probar_u8(void)
+{
+  static const struct {
+    const char *bytes;
+    bool valido;
+  } casos[] = {
+    { "\xC3\xB1", true },
+    { "\xC0\x80", false },             // Demasiado largo
+    { "\xC1\xBF", false },
+    { "\xE0\xA0\x80", true },
+    { "\xE0\x9F\xBF", false },
+    { "\xED\x9F\xBF", true },
+    { "\xED\xA0\x80", false },         // Sustituto
+    { "\xEF\xBF\xBF", true },
+    { "\xF0\x90\x80\x80", true },
+    { "\xF0\x8F\xBF\xBF", false },
+    { "\xF4\x8F\xBF\xBF", true },
+    { "\xF4\x90\x80\x80", false },     // Más allá de U+10FFFF
+    { "\xF5\x80\x80\x80", false },
+    { "\x80", false },                 // Continuación suelta
+    { "\xC3", false },                 // A medias
+    { "\xE2\x82", false },
+    { "\xC3\xB1\xB1", false },
+    { "\xFF", false },
+  };
+  unsigned char texto[PRUEBA_U8_LONGITUD + 64];
+  Azar azar;
+  int fallas = 0;
+
+  for (size_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+    size_t len = strlen(casos[i].bytes);
+
+    for (size_t antes = 0; antes <= 40; antes++) {
+      bool ascii = true;
+
+      memset(texto, 'a', antes);
+      memcpy(&texto[antes], casos[i].bytes, len);
+      memset(&texto[antes + len], 'a', 8);
+      if ((u8_validar_escalar(texto, antes + len + 8, 0, antes + len + 8,
+                              &ascii) != (size_t) -1) != casos[i].valido) {
+        printf("La versión escalar se equivoca con ");
+        probar_imprimir_bytes(texto, antes + len + 8);
+        fallas++;
+      }
+      // Al final del texto, sin nada después
+      if (!probar_u8_texto(texto, antes + len + 8)
+          || !probar_u8_texto(texto, antes + len)) {
+        fallas++;
+      }
+    }
+  }
+
+  azar_sembrar(&azar, 11);
+  for (size_t i = 0; i < PRUEBA_U8_CASOS && fallas < 10; i++) {
+    size_t len = probar_u8_generar(&azar, texto);
+    // Probamos también sin alinear
+    size_t desfase = azar_acotado(&azar, 32);
+
+    memmove(&texto[desfase], texto, len);
+    if (!probar_u8_texto(&texto[desfase], len)) {
+      fallas++;
+    }
+  }
+
+  if (fallas > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("u8: las variantes coinciden en %d textos\n", PRUEBA_U8_CASOS);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Compara u8_validar(), u8_es_ascii() y las variantes de este procesador
+ * con la versión escalar
+ *
+ * Returns: true si todas coinciden
+ */
+bool probar_u8_texto(const unsigned char *texto,
+                     size_t               len)
+{
+  bool ascii = true, valido, ascii_otra;
+  bool correcto = true, es_ascii = true;
+
+  valido = u8_validar_escalar(texto, len, 0, len, &ascii) != (size_t) -1;
+  ascii = valido && ascii;
+  for (size_t i = 0; i < len; i++) {
+    es_ascii = es_ascii && texto[i] < 0x80;
+  }
+
+  if (u8_validar((const char *) texto, len, &ascii_otra) != valido
+      || ascii_otra != ascii) {
+    printf("u8_validar() no coincide con ");
+    correcto = false;
+  } else if (u8_es_ascii((const char *) texto, len) != es_ascii) {
+    printf("u8_es_ascii() se equivoca con ");
+    correcto = false;
+  }
+#if defined(__x86_64__)
+  ascii_otra = true;
+  if (correcto && (u8_validar_sse2(texto, len, &ascii_otra) != valido
+                   || (valido && ascii_otra != ascii))) {
+    printf("u8_validar_sse2() no coincide con ");
+    correcto = false;
+  }
+  ascii_otra = true;
+  if (correcto && __builtin_cpu_supports("avx2")
+      && (u8_validar_avx2(texto, len, &ascii_otra) != valido
+          || (valido && ascii_otra != ascii))) {
+    printf("u8_validar_avx2() no coincide con ");
+    correcto = false;
+  }
+#endif
+
+  if (!correcto) {
+    probar_imprimir_bytes(texto, len);
+  }
+  return correcto;
+}
+
+/**
+ * Llena @texto con caracteres al azar: casi todos ASCII o UTF-8 válido de
+ * uno a cuatro bytes, y de vez en cuando un byte cualquiera, que casi
+ * siempre lo hace inválido
+ *
+ * Returns: Cuántos bytes se escribieron, hasta PRUEBA_U8_LONGITUD
+ */
+size_t probar_u8_generar(Azar          *azar,
+                         unsigned char *texto)
+{
+  size_t len = 0, objetivo = azar_acotado(azar, PRUEBA_U8_LONGITUD - 3);
+
+  while (len < objetivo) {
+    uint32_t tipo = azar_acotado(azar, 100);
+    uint32_t codigo;
+
+    if (tipo < 2) {
+      texto[len++] = azar_acotado(azar, 256);
+      continue;
+    }
+    if (tipo < 50) {
+      codigo = azar_acotado(azar, 0x80);
+    } else if (tipo < 75) {
+      codigo = 0x80 + azar_acotado(azar, 0x800 - 0x80);
+    } else if (tipo < 95) {
+      codigo = 0x800 + azar_acotado(azar, 0x10000 - 0x800);
+      if (codigo >= 0xD800 && codigo <= 0xDFFF) {
+        codigo = 0xFFFD;
+      }
+    } else {
+      codigo = 0x10000 + azar_acotado(azar, 0x110000 - 0x10000);
+    }
+    len += u8_codificar(codigo, (char *) &texto[len]);
+  }
+  return len;
+}
+
+/**
+ * Juega palabras al azar, con mayúsculas, acentos y caracteres que no son
+ * letras, intentando letras en desorden. Después de cada intento compara
+ * lo que da el índice de letras de la palabra con lo que sale de recorrerla
+ * completa.
+ */
+int probar_palabra(void)
+{
+  static const uint32_t caracteres[] = {
+    'a', 'b', 'c', 'd', 'e', 'l', 'n', 'o', 's', 'u', 'z',
+    'A', 'E', 'N', 'O', 'Z',
+    0xE1, 0xE9, 0xF3, 0xFA, 0xFC, 0xF1, 0xC1, 0xD1, 0xDC, 0xE7, 0x142,
+    ' ', '-', '\'', 0xDF, 0xF8,
+  };
+  const size_t n_caracteres = sizeof(caracteres) / sizeof(caracteres[0]);
+  uint32_t codigos[PRUEBA_PALABRA_CARACTERES];
+  bool revelados[PRUEBA_PALABRA_CARACTERES];
+  char texto[PRUEBA_PALABRA_CARACTERES * 4 + 1];
+  Arena *arena = arena_nueva(4096);
+  Azar azar;
+  int fallas = 0;
+
+  azar_sembrar(&azar, 9);
+  for (size_t i = 0; i < PRUEBA_PALABRAS && fallas == 0; i++) {
+    size_t n = 1 + azar_acotado(&azar, PRUEBA_PALABRA_CARACTERES);
+    size_t len = 0;
+    bool ascii = true;
+    Palabra *palabra;
+
+    for (size_t j = 0; j < n; j++) {
+      codigos[j] = caracteres[azar_acotado(&azar, n_caracteres)];
+      revelados[j] = !u8_es_letra(codigos[j]);
+      ascii = ascii && codigos[j] < 0x80;
+      len += u8_codificar(codigos[j], &texto[len]);
+    }
+    texto[len] = '\0';
+
+    arena_reiniciar(arena);
+    palabra = palabra_nueva(texto, len, ascii, arena);
+    if (!probar_palabra_revisar(palabra, codigos, revelados, n, texto)) {
+      fallas++;
+    }
+
+    // Cada letra del alfabeto, en desorden, y algunas dos veces
+    for (size_t j = 0; j < n_caracteres + 5 && fallas == 0; j++) {
+      uint32_t clave = u8_plegar(caracteres[azar_acotado(&azar, n_caracteres)]);
+      size_t esperados = 0, revelados_ahora;
+
+      for (size_t k = 0; k < n; k++) {
+        if (!revelados[k] && u8_plegar(codigos[k]) == clave) {
+          revelados[k] = true;
+          esperados++;
+        }
+      }
+      revelados_ahora = palabra_revelar(palabra, clave);
+      if (revelados_ahora != esperados) {
+        printf("En \"%s\", revelar U+%04X mostró %zu caracteres y no %zu\n",
+               texto, clave, revelados_ahora, esperados);
+        fallas++;
+      } else if (!probar_palabra_revisar(palabra, codigos, revelados, n,
+                                         texto)) {
+        fallas++;
+      }
+    }
+  }
+  arena_destruir(arena);
+
+  if (fallas > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("palabra: el índice de letras coincide en %d palabras\n",
+         PRUEBA_PALABRAS);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Compara lo que muestra @palabra con @revelados, que dice cuáles de sus
+ * @n caracteres (@codigos) deberían verse
+ *
+ * Returns: true si coinciden
+ */
+bool probar_palabra_revisar(Palabra        *palabra,
+                            const uint32_t *codigos,
+                            const bool     *revelados,
+                            size_t          n,
+                            const char     *texto)
+{
+  char esperada[PRUEBA_PALABRA_CARACTERES * 4 + 1];
+  size_t len = 0, ocultos = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    size_t bytes = u8_codificar(codigos[i], &esperada[len]);
+    uint32_t visible = palabra_get_clave_visible(palabra, i);
+
+    if (!revelados[i]) {
+      memset(&esperada[len], '_', bytes);
+      ocultos++;
+    }
+    len += bytes;
+    if (visible != (revelados[i] ? u8_plegar(codigos[i]) : 0)) {
+      printf("En \"%s\", el caracter %zu se ve como U+%04X\n", texto, i,
+             visible);
+      return false;
+    }
+  }
+  esperada[len] = '\0';
+
+  if (strcmp(palabra_get_adivinada(palabra), esperada) != 0) {
+    printf("En \"%s\" se ve \"%s\" y no \"%s\"\n", texto,
+           palabra_get_adivinada(palabra), esperada);
+    return false;
+  }
+  if (palabra_get_ocultos(palabra) != ocultos
+      || palabra_completa(palabra) != (ocultos == 0)) {
+    printf("En \"%s\" quedan %zu ocultos y no %zu\n", texto,
+           palabra_get_ocultos(palabra), ocultos);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Escribe una lista con saltos de línea de Unix y de Windows, líneas vacías,
+ * líneas que no son UTF-8 y una última línea sin salto, le genera su .idx y
+ * revisa que la categoría leída a través del índice tenga las mismas
+ * palabras que la que mapea el archivo completo, y que ambas tengan las que
+ * salen de partir el archivo a mano.
+ */
+int probar_indice(void)
+{
+  static const char *palabras[] = {
+    "manzana", "Árbol", "ñandú", "Guinea-Bissau", "Costa de Marfil", "uva",
+    "pingüino", "x", "\xC3\xB1\xC3", "\xFF", "", "\r",
+  };
+  const size_t n_palabras = sizeof(palabras) / sizeof(palabras[0]);
+  const char *directorio = getenv("TMPDIR");
+  Categoria *indexada = NULL, *mapeada = NULL;
+  char *lista, *idx, *datos;
+  size_t datos_len = 0;
+  int fallas = 0, fd;
+  Azar azar;
+  FILE *archivo;
+
+  if (directorio == NULL) {
+    directorio = "/tmp";
+  }
+  lista = malloc(strlen(directorio) + 64);
+  sprintf(lista, "%s/adivinador-pruebas-XXXXXX", directorio);
+  fd = mkstemp(lista);
+  if (fd == -1) {
+    printf("No se pudo crear la lista %s\n", lista);
+    free(lista);
+    return EXIT_FAILURE;
+  }
+  idx = malloc(strlen(lista) + 5);
+  sprintf(idx, "%s.idx", lista);
+
+  // Guardamos también lo que escribimos, para partirlo a mano
+  datos = malloc(PRUEBA_INDICE_LINEAS * 32);
+  azar_sembrar(&azar, 5);
+  for (size_t i = 0; i < PRUEBA_INDICE_LINEAS; i++) {
+    const char *palabra = palabras[azar_acotado(&azar, n_palabras)];
+    size_t len = strlen(palabra);
+
+    memcpy(&datos[datos_len], palabra, len);
+    datos_len += len;
+    if (i + 1 < PRUEBA_INDICE_LINEAS) {
+      if (azar_acotado(&azar, 4) == 0) {
+        datos[datos_len++] = '\r';
+      }
+      datos[datos_len++] = '\n';
+    }
+  }
+  // Que la última línea sea una palabra, para ver que no se pierde
+  memcpy(&datos[datos_len], "fin", 3);
+  datos_len += 3;
+
+  archivo = fdopen(fd, "wb");
+  if (archivo == NULL || fwrite(datos, 1, datos_len, archivo) != datos_len
+      || fclose(archivo) != 0) {
+    printf("No se pudo escribir la lista %s\n", lista);
+    fallas++;
+  } else if (!indice_generar(lista)) {
+    printf("No se pudo generar el índice de %s\n", lista);
+    fallas++;
+  }
+
+  if (fallas == 0) {
+    indexada = categoria_nueva_perezosa("Indexada", lista);
+    mapeada = categoria_nueva_desde_archivo("Mapeada", lista);
+    if (!categoria_cargar(indexada) || mapeada == NULL) {
+      printf("No se pudo cargar %s\n", lista);
+      fallas++;
+    } else if (categoria_get_palabra(indexada, 0) != NULL) {
+      // Solo las categorías indexadas no tienen sus palabras en memoria
+      printf("%s se cargó sin usar su índice\n", lista);
+      fallas++;
+    } else if (!probar_indice_comparar(indexada, "indexada", datos, datos_len)
+               || !probar_indice_comparar(mapeada, "mapeada", datos,
+                                          datos_len)) {
+      fallas++;
+    }
+  }
+
+  // Si la lista cambia, el índice ya no sirve
+  if (fallas == 0) {
+    Indice *viejo;
+
+    archivo = fopen(lista, "ab");
+    if (archivo != NULL) {
+      fputs("\notra", archivo);
+      fclose(archivo);
+    }
+    viejo = indice_abrir(lista);
+    if (viejo != NULL) {
+      printf("El índice de %s sigue abriéndose después de cambiarla\n", lista);
+      indice_cerrar(viejo);
+      fallas++;
+    }
+  }
+
+  categoria_destruir(indexada);
+  categoria_destruir(mapeada);
+  unlink(idx);
+  unlink(lista);
+  free(datos);
+  free(idx);
+  free(lista);
+
+  if (fallas > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("indice: la lista indexada coincide en %d líneas\n",
+         PRUEBA_INDICE_LINEAS);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Parte @datos en líneas, sin su \r, y se queda con las que no están vacías
+ * y son UTF-8 válido; revisa que sean, en orden, las palabras de @categoria
+ *
+ * Returns: true si coinciden
+ */
+bool probar_indice_comparar(Categoria  *categoria,
+                            const char *descripcion,
+                            const char *datos,
+                            size_t      datos_len)
+{
+  Arena *arena = arena_nueva(4096);
+  size_t inicio = 0, n = 0;
+  bool correcto = true;
+
+  while (inicio <= datos_len && correcto) {
+    const char *salto = memchr(&datos[inicio], '\n', datos_len - inicio);
+    size_t fin = salto != NULL ? (size_t) (salto - datos) : datos_len;
+    size_t len = fin - inicio;
+    const char *leida;
+    bool ascii;
+
+    if (len > 0 && datos[inicio + len - 1] == '\r') {
+      len--;
+    }
+    if (len > 0 && u8_validar(&datos[inicio], len, &ascii)) {
+      arena_reiniciar(arena);
+      leida = categoria_leer_palabra(categoria, n, arena);
+      if (leida == NULL
+          || categoria_get_longitud_palabra(categoria, n) != (int) len
+          || memcmp(leida, &datos[inicio], len) != 0) {
+        printf("La palabra %zu de la lista %s no es \"%.*s\"\n", n,
+               descripcion, (int) len, &datos[inicio]);
+        correcto = false;
+      } else if (categoria_palabra_es_ascii(categoria, n) != ascii) {
+        printf("La palabra %zu de la lista %s no dice bien si es ASCII\n", n,
+               descripcion);
+        correcto = false;
+      }
+      n++;
+    }
+    inicio = fin + 1;
+  }
+
+  if (correcto && (size_t) categoria_get_n_palabras(categoria) != n) {
+    printf("La lista %s tiene %d palabras y no %zu\n", descripcion,
+           categoria_get_n_palabras(categoria), n);
+    correcto = false;
+  }
+  arena_destruir(arena);
+  return correcto;
+}
+
+/**
+ * Presenta cuadros al azar, cada uno un poco distinto del anterior y con
+ * caracteres de más de un byte, y de vez en cuando limpia la pantalla. Lo
+ * que pantalla_presentar() escribe se le pasa a una terminal de mentira,
+ * que después de cada cuadro debe mostrar exactamente ese cuadro.
+ */
+int probar_pantalla(void)
+{
+  static PruebaTerminal terminal;
+  size_t piezas[PRUEBA_PANTALLA_FILAS][PRUEBA_PANTALLA_PIEZAS] = { { 0 } };
+  size_t n_piezas[PRUEBA_PANTALLA_FILAS] = { 0 };
+  size_t n_filas = 0;
+  char cuadro[PRUEBA_PANTALLA_FILAS * PRUEBA_PANTALLA_COLUMNAS];
+  char *salida = malloc(1 << 16);
+  FILE *archivo = tmpfile();
+  Pantalla *pantalla;
+  int fallas = 0;
+  Azar azar;
+
+  if (archivo == NULL) {
+    printf("No se pudo crear un archivo temporal\n");
+    free(salida);
+    return EXIT_FAILURE;
+  }
+  // Lo que se escribe en el archivo es lo que le llegaría a la terminal
+  pantalla = pantalla_nueva_en(fileno(archivo), true);
+
+  azar_sembrar(&azar, 7);
+  for (size_t i = 0; i < PRUEBA_PANTALLA_CUADROS && fallas == 0; i++) {
+    size_t len = probar_pantalla_armar(&azar, piezas, n_piezas, &n_filas,
+                                       cuadro);
+    off_t escrito;
+
+    if (azar_acotado(&azar, 50) == 0) {
+      pantalla_limpiar(pantalla);
+    }
+    marco_agregar(pantalla_get_cuadro(pantalla), cuadro, len);
+    pantalla_presentar(pantalla);
+
+    escrito = lseek(fileno(archivo), 0, SEEK_CUR);
+    if (escrito < 0 || escrito > 1 << 16
+        || pread(fileno(archivo), salida, escrito, 0) != escrito
+        || ftruncate(fileno(archivo), 0) != 0
+        || lseek(fileno(archivo), 0, SEEK_SET) != 0) {
+      printf("No se pudo leer lo que escribió la pantalla\n");
+      fallas++;
+    } else if (!probar_terminal_escribir(&terminal, salida, escrito)) {
+      printf("Para el cuadro %zu la pantalla escribió ", i);
+      probar_imprimir_bytes((const unsigned char *) salida, escrito);
+      fallas++;
+    } else if (!probar_terminal_comparar(&terminal, cuadro, len)) {
+      printf("El cuadro %zu no se ve como se armó:\n%.*s", i, (int) len,
+             cuadro);
+      fallas++;
+    }
+  }
+
+  pantalla_destruir(pantalla);
+  fclose(archivo);
+  free(salida);
+
+  if (fallas > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("pantalla: la terminal muestra los %d cuadros\n",
+         PRUEBA_PANTALLA_CUADROS);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Cambia un poco el cuadro anterior, que son @n_filas filas de @n_piezas
+ * piezas cada una, y lo escribe en @cuadro, con un salto al final de cada
+ * fila
+ *
+ * Returns: La longitud de @cuadro
+ */
+size_t probar_pantalla_armar(Azar   *azar,
+                             size_t  piezas[][PRUEBA_PANTALLA_PIEZAS],
+                             size_t *n_piezas,
+                             size_t *n_filas,
+                             char   *cuadro)
+{
+  static const char *textos[] = {
+    "a", "b", " ", "_", "ñ", "á", "Ü", "─", "█", "♥", "Guinea-Bissau",
+  };
+  const size_t n_textos = sizeof(textos) / sizeof(textos[0]);
+  size_t cambios = 1 + azar_acotado(azar, 3), len = 0;
+
+  for (size_t i = 0; i < cambios; i++) {
+    size_t fila = azar_acotado(azar, PRUEBA_PANTALLA_FILAS);
+    size_t n = n_piezas[fila], donde = azar_acotado(azar, n + 1);
+
+    if (fila >= *n_filas) {
+      // Filas nuevas, que pueden quedar vacías
+      for (size_t j = *n_filas; j <= fila; j++) {
+        n_piezas[j] = 0;
+      }
+      *n_filas = fila + 1;
+      n = 0;
+      donde = 0;
+    }
+    switch (azar_acotado(azar, 4)) {
+    case 0:
+      if (n < PRUEBA_PANTALLA_PIEZAS) {
+        memmove(&piezas[fila][donde + 1], &piezas[fila][donde],
+                (n - donde) * sizeof(size_t));
+        piezas[fila][donde] = azar_acotado(azar, n_textos);
+        n_piezas[fila]++;
+      }
+      break;
+    case 1:
+      if (donde < n) {
+        memmove(&piezas[fila][donde], &piezas[fila][donde + 1],
+                (n - donde - 1) * sizeof(size_t));
+        n_piezas[fila]--;
+      }
+      break;
+    case 2:
+      if (donde < n) {
+        piezas[fila][donde] = azar_acotado(azar, n_textos);
+      }
+      break;
+    default:
+      // Quitamos filas del final
+      *n_filas = azar_acotado(azar, *n_filas + 1);
+      break;
+    }
+  }
+
+  for (size_t fila = 0; fila < *n_filas; fila++) {
+    for (size_t i = 0; i < n_piezas[fila]; i++) {
+      size_t pieza_len = strlen(textos[piezas[fila][i]]);
+
+      memcpy(&cuadro[len], textos[piezas[fila][i]], pieza_len);
+      len += pieza_len;
+    }
+    cuadro[len++] = '\n';
+  }
+  return len;
+}
+
+/**
+ * Aplica a @self los @len bytes de @salida: texto, que no puede tener saltos
+ * de línea, y las secuencias para mover el cursor, borrar y mostrar u
+ * ocultar el cursor
+ *
+ * Returns: false si hay algo que la terminal no entiende o que se sale de
+ * ella
+ */
+bool probar_terminal_escribir(PruebaTerminal *self,
+                              const char     *salida,
+                              size_t          len)
+{
+  size_t i = 0;
+
+  while (i < len) {
+    size_t parametros[2] = { 0, 0 }, n_parametros = 0;
+    bool privada = false;
+
+    if (salida[i] != '\x1b') {
+      if (salida[i] == '\n' || self->fila >= PRUEBA_PANTALLA_FILAS) {
+        return false;
+      }
+      if (PARTE_U8(salida[i])) {
+        // Continuación del caracter de la celda anterior
+        if (self->columna == 0
+            || self->celdas[self->fila][self->columna - 1].len >= 4) {
+          return false;
+        }
+        self->celdas[self->fila][self->columna - 1].bytes[
+          self->celdas[self->fila][self->columna - 1].len++] = salida[i];
+      } else {
+        if (self->columna >= PRUEBA_PANTALLA_COLUMNAS) {
+          return false;
+        }
+        self->celdas[self->fila][self->columna].bytes[0] = salida[i];
+        self->celdas[self->fila][self->columna].len = 1;
+        self->columna++;
+      }
+      i++;
+      continue;
+    }
+
+    if (i + 1 >= len || salida[i + 1] != '[') {
+      return false;
+    }
+    i += 2;
+    if (i < len && salida[i] == '?') {
+      privada = true;
+      i++;
+    }
+    while (i < len && (salida[i] == ';'
+                       || (salida[i] >= '0' && salida[i] <= '9'))) {
+      if (salida[i] == ';') {
+        if (++n_parametros >= 2) {
+          return false;
+        }
+      } else {
+        parametros[n_parametros] = parametros[n_parametros] * 10
+                                   + salida[i] - '0';
+      }
+      i++;
+    }
+    if (i >= len) {
+      return false;
+    }
+
+    if (privada) {
+      if (parametros[0] != 25 || (salida[i] != 'h' && salida[i] != 'l')) {
+        return false;
+      }
+    } else if (salida[i] == 'H') {
+      self->fila = parametros[0] > 0 ? parametros[0] - 1 : 0;
+      self->columna = parametros[1] > 0 ? parametros[1] - 1 : 0;
+    } else if (salida[i] == 'K' && parametros[0] == 0) {
+      probar_terminal_borrar(self, self->fila, self->fila + 1, self->columna);
+    } else if (salida[i] == 'J' && parametros[0] == 0) {
+      probar_terminal_borrar(self, self->fila, self->fila + 1, self->columna);
+      probar_terminal_borrar(self, self->fila + 1, PRUEBA_PANTALLA_FILAS, 0);
+    } else if (salida[i] == 'J' && parametros[0] == 2) {
+      probar_terminal_borrar(self, 0, PRUEBA_PANTALLA_FILAS, 0);
+    } else {
+      return false;
+    }
+    i++;
+  }
+  return true;
+}
+
+/**
+ * Vacía las filas de @desde a @hasta de @self, a partir de la columna
+ * @columna
+ */
+void probar_terminal_borrar(PruebaTerminal *self,
+                            size_t          desde,
+                            size_t          hasta,
+                            size_t          columna)
+{
+  for (size_t fila = desde; fila < hasta && fila < PRUEBA_PANTALLA_FILAS;
+       fila++) {
+    for (size_t i = columna; i < PRUEBA_PANTALLA_COLUMNAS; i++) {
+      self->celdas[fila][i].len = 0;
+    }
+  }
+}
+
+/**
+ * Revisa que @self muestre @cuadro: cada fila con su línea desde la primera
+ * columna, sin huecos, y nada más
+ *
+ * Returns: true si se ven iguales
+ */
+bool probar_terminal_comparar(PruebaTerminal *self,
+                              const char     *cuadro,
+                              size_t          len)
+{
+  const char *fin = cuadro + len;
+
+  for (size_t fila = 0; fila < PRUEBA_PANTALLA_FILAS; fila++) {
+    const char *salto = cuadro < fin ? memchr(cuadro, '\n', fin - cuadro)
+                                     : NULL;
+    size_t linea_len = salto != NULL ? (size_t) (salto - cuadro) : 0;
+    size_t i = 0, leido = 0;
+
+    for (; i < PRUEBA_PANTALLA_COLUMNAS && self->celdas[fila][i].len > 0; i++) {
+      if (leido + self->celdas[fila][i].len > linea_len
+          || memcmp(&cuadro[leido], self->celdas[fila][i].bytes,
+                    self->celdas[fila][i].len) != 0) {
+        return false;
+      }
+      leido += self->celdas[fila][i].len;
+    }
+    if (leido != linea_len) {
+      return false;
+    }
+    // Después de la línea no debe quedar nada
+    for (; i < PRUEBA_PANTALLA_COLUMNAS; i++) {
+      if (self->celdas[fila][i].len > 0) {
+        return false;
+      }
+    }
+    if (salto != NULL) {
+      cuadro = salto + 1;
+    }
+  }
+  return true;
+}
+
+void probar_imprimir_bytes(const unsigned char *texto,
+                           size_t               len)
+{
+  for (size_t i = 0; i < len; i++) {
+    printf("%02X", texto[i]);
+  }
+  putchar('\n');
+}
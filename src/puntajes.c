@@ -0,0 +1,112 @@
+/* puntajes.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * adivinador-puntajes: muestra lo que lleva cada jugador y cada categoría
+ * en un marcador (adivinador --scores). Se puede correr mientras otros
+ * procesos siguen anotando.
+ *
+ * Uso: adivinador-puntajes MARCADOR
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "marcador.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+/* El ancho de la columna de nombres, en caracteres */
+#define PUNTAJES_ANCHO 40
+
+void puntajes_imprimir(const MarcadorFila *);
+void puntajes_imprimir_nombre(const char *);
+
+int main(int argc,
+         char **argv)
+{
+  MarcadorFila *filas;
+  MarcadorFila total = { 0 };
+  size_t n_filas;
+
+  if (argc != 2) {
+    fprintf(stderr, "Uso: %s MARCADOR\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  filas = marcador_leer(argv[1], &n_filas);
+  if (filas == NULL) {
+    fprintf(stderr, "No se pudo leer el marcador %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  for (size_t i = 0; i < n_filas; i++) {
+    if (i == 0 || filas[i].tipo != filas[i - 1].tipo) {
+      if (i > 0) {
+        putchar('\n');
+      }
+      puntajes_imprimir_nombre(filas[i].tipo == MARCADOR_JUGADOR ? "Jugador"
+                                                                 : "Categoría");
+      printf(" %8s %8s %6s %6s %6s %6s\n",
+             "Ganadas", "Perdidas", "%", "Racha", "Mejor", "Vidas");
+    }
+    puntajes_imprimir(&filas[i]);
+
+    // Cada partida se anota una vez en su categoría
+    if (filas[i].tipo == MARCADOR_CATEGORIA) {
+      total.ganadas += filas[i].ganadas;
+      total.perdidas += filas[i].perdidas;
+      total.vidas += filas[i].vidas;
+    }
+  }
+  printf("\nTotal: %llu partidas, %llu ganadas\n",
+         (unsigned long long) (total.ganadas + total.perdidas),
+         (unsigned long long) total.ganadas);
+
+  free(filas);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Imprime @fila, con el porcentaje de partidas ganadas y cuántas vidas
+ * sobraron en promedio al ganar
+ */
+void puntajes_imprimir(const MarcadorFila *fila)
+{
+  uint64_t partidas = fila->ganadas + fila->perdidas;
+
+  puntajes_imprimir_nombre(fila->nombre);
+  printf(" %8llu %8llu %6.1f %6llu %6llu %6.2f\n",
+         (unsigned long long) fila->ganadas,
+         (unsigned long long) fila->perdidas,
+         partidas > 0 ? 100.0 * fila->ganadas / partidas : 0,
+         (unsigned long long) fila->racha,
+         (unsigned long long) fila->mejor_racha,
+         fila->ganadas > 0 ? (double) fila->vidas / fila->ganadas : 0);
+}
+
+/**
+ * Imprime @nombre rellenado con espacios hasta PUNTAJES_ANCHO caracteres.
+ * printf("%-40s") cuenta bytes, y los nombres con acentos quedarían cortos.
+ */
+void puntajes_imprimir_nombre(const char *nombre)
+{
+  size_t caracteres = 0;
+
+  for (size_t i = 0; nombre[i] != '\0'; i++) {
+    // Solo contamos el primer byte de cada carácter
+    if (((unsigned char) nombre[i] & 0xC0) != 0x80) {
+      caracteres++;
+    }
+  }
+  printf("%s%*s", nombre,
+         caracteres < PUNTAJES_ANCHO ? (int) (PUNTAJES_ANCHO - caracteres) : 0,
+         "");
+}
@@ -0,0 +1,583 @@
+/* recursos.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+
+#include "arena.h"
+#include "paquete.h"
+#include "partida.h"
+#include "recursos.h"
+
+/*
+ * Dónde se buscan más categorías, además de las del paquete: cada .txt es una
+ * categoría que se llama como el archivo. ADIVINADOR_CATEGORIAS cambia el
+ * directorio.
+ */
+#define RECURSOS_CATEGORIAS "recursos/categorias"
+
+/* Las categorías se leen en disco, así que no vale la pena usar más hilos */
+#define RECURSOS_MAX_HILOS 8
+
+#if EMBEBER_RECURSOS
+/* Generados al compilar por adivinador-empaquetar --c */
+extern const unsigned char recursos_embebidos[];
+extern const size_t recursos_embebidos_size;
+#endif
+
+/**
+ * Todo lo que vive lo mismo que el programa (categorías y texturas del
+ * paquete) se aloja en @arena. Si los recursos salieron de un paquete,
+ * @paquete es ese paquete, que se cierra al final porque las categorías lo
+ * usan.
+ *
+ * @categorias está en el orden del menú, y @tabla es una tabla hash de
+ * direccionamiento abierto que lleva del nombre de una categoría a ella, a
+ * lo más medio llena.
+ *
+ * Las vidas se dibujan en cada intento, así que al cargar la textura del
+ * corazón armamos de una vez la tira con N corazones para cada N posible;
+ * @vidas[n] ya es la linea completa.
+ *
+ * Al terminar de cargar, @hilos leen las palabras de todas las categorías
+ * en segundo plano: cada uno toma la categoría @siguiente hasta acabar o
+ * hasta que @detener les pida parar.
+ */
+struct __Recursos {
+  Categoria **categorias;
+  size_t n_categorias;
+  size_t categorias_size;
+  Categoria **tabla;
+  size_t tabla_mascara;
+  Textura *texturas[RECURSOS_N_TEXTURAS];
+  Textura *vidas[PARTIDA_VIDAS + 1];
+  Paquete *paquete;
+  Arena *arena;
+
+  pthread_t *hilos;
+  size_t n_hilos;
+  atomic_size_t siguiente;
+  atomic_bool detener;
+};
+
+bool recursos_cargar_paquete(Recursos *, Paquete *, const char *);
+void recursos_cargar_archivos(Recursos *);
+void recursos_buscar_categorias(Recursos *, const char *);
+int recursos_comparar_nombres(const void *, const void *);
+void recursos_agregar_categoria(Recursos *, Categoria *);
+Categoria **recursos_buscar_casilla(Recursos *, const char *);
+uint64_t recursos_hash(const char *);
+void *recursos_precargar_hilo(void *);
+void recursos_detener(Recursos *);
+void recursos_liberar(Recursos *);
+
+/**
+ * Busca los recursos del juego, en orden de preferencia, y carga los primeros
+ * que encuentre
+ *
+ * Returns: (transfer: full) Los recursos del juego
+ */
+Recursos *recursos_cargar(void)
+{
+  Recursos *self;
+  const char *directorio = getenv("ADIVINADOR_CATEGORIAS");
+  bool cargados = false;
+  bool embebidos = false;
+
+  self = calloc(1, sizeof(Recursos));
+  self->arena = arena_nueva(4096);
+
+#if EMBEBER_RECURSOS
+  /*
+   * Si los recursos vienen dentro del ejecutable no hace falta abrir ningún
+   * archivo, ni depende de desde qué directorio nos ejecuten
+   */
+  cargados = recursos_cargar_paquete(self,
+                                     paquete_nuevo_desde_memoria(recursos_embebidos,
+                                                                 recursos_embebidos_size),
+                                     "embebido");
+  embebidos = cargados;
+#endif
+
+  /*
+   * Preferimos el paquete que se genera al compilar, porque se carga con un
+   * solo mmap sin importar el tamaño de las listas. Si no lo encontramos (por
+   * ejemplo, si no se instaló), leemos los archivos de texto.
+   */
+  if (!cargados) {
+    cargados = recursos_cargar_paquete(self,
+                                       paquete_abrir(PKGDATADIR "/recursos.pak"),
+                                       PKGDATADIR "/recursos.pak")
+               || recursos_cargar_paquete(self, paquete_abrir("recursos.pak"),
+                                          "recursos.pak");
+  }
+  if (!cargados) {
+    recursos_cargar_archivos(self);
+  }
+
+  /*
+   * Las categorías que se agregaron sin recompilar. Si alguna se llama igual
+   * que una del paquete, se queda la del paquete. Con los recursos embebidos
+   * solo se buscan si se pidió un directorio, para no tocar el disco.
+   */
+  if (directorio != NULL) {
+    recursos_buscar_categorias(self, directorio);
+  } else if (!embebidos) {
+    recursos_buscar_categorias(self, PKGDATADIR "/categorias");
+    recursos_buscar_categorias(self, RECURSOS_CATEGORIAS);
+  }
+
+  for (size_t i = 0; i <= PARTIDA_VIDAS; i++) {
+    self->vidas[i] = textura_nueva_repetida(self->texturas[RECURSOS_CORAZON],
+                                            i, self->arena);
+  }
+
+  return self;
+}
+
+/**
+ * Carga las categorías y texturas de @paquete. Si no tiene todo lo que el
+ * juego necesita, se cierra.
+ *
+ * @paquete (transfer: full) Un paquete de recursos, o NULL
+ * @nombre_paquete El nombre del paquete, para los mensajes de error
+ *
+ * Returns: true si el paquete existe y tiene todas las texturas del juego
+ */
+bool recursos_cargar_paquete(Recursos   *self,
+                             Paquete    *paquete,
+                             const char *nombre_paquete)
+{
+  size_t n_entradas;
+
+  if (paquete == NULL) {
+    return false;
+  }
+
+  n_entradas = paquete_get_n_entradas(paquete);
+  for (size_t i = 0; i < n_entradas; i++) {
+    const char *nombre = paquete_get_nombre(paquete, i);
+
+    switch (paquete_get_tipo(paquete, i))
+    {
+    case PAQUETE_CATEGORIA:
+      recursos_agregar_categoria(self,
+                                 paquete_crear_categoria(paquete, i,
+                                                         self->arena));
+      break;
+    case PAQUETE_TEXTURA:
+      for (RecursosTextura t = 0; t < RECURSOS_N_TEXTURAS; t++) {
+        if (strcmp(nombre, recursos_textura_to_string(t)) == 0
+            && self->texturas[t] == NULL) {
+          self->texturas[t] = paquete_crear_textura(paquete, i, self->arena);
+        }
+      }
+      break;
+    case PAQUETE_NINGUNO:
+    default:
+      break;
+    }
+  }
+  self->paquete = paquete;
+
+  for (RecursosTextura t = 0; t < RECURSOS_N_TEXTURAS; t++) {
+    if (self->texturas[t] == NULL) {
+      fprintf(stderr, "Al paquete %s le faltan texturas\n", nombre_paquete);
+      recursos_liberar(self);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Carga las texturas desde los archivos de texto en recursos/. Las
+ * categorías salen de recursos/categorias, como las que no vienen en el
+ * paquete.
+ */
+void recursos_cargar_archivos(Recursos *self)
+{
+  for (RecursosTextura t = 0; t < RECURSOS_N_TEXTURAS; t++) {
+    char camino[64];
+
+    snprintf(camino, sizeof(camino), "recursos/%s.txt",
+             recursos_textura_to_string(t));
+    self->texturas[t] = textura_nueva_desde_archivo(camino);
+  }
+}
+
+/**
+ * Registra una categoría por cada .txt en @directorio, en orden alfabético
+ * para que el menú (y lo que sale con cada semilla) no dependa del orden en
+ * que el sistema de archivos los regrese. Sus palabras se leen hasta
+ * después, así que aquí solo se ven los nombres.
+ *
+ * @directorio El directorio; si no existe no se agrega nada
+ */
+void recursos_buscar_categorias(Recursos   *self,
+                                const char *directorio)
+{
+  DIR *dir;
+  struct dirent *entrada;
+  char **nombres = NULL;
+  size_t n_nombres = 0, nombres_size = 0;
+
+  dir = opendir(directorio);
+  if (dir == NULL) {
+    return;
+  }
+
+  while ((entrada = readdir(dir)) != NULL) {
+    size_t len = strlen(entrada->d_name);
+
+    if (entrada->d_name[0] == '.' || len <= strlen(".txt")
+        || strcmp(&entrada->d_name[len - strlen(".txt")], ".txt") != 0) {
+      continue;
+    }
+    if (n_nombres == nombres_size) {
+      nombres_size = nombres_size > 0 ? 2 * nombres_size : 16;
+      nombres = realloc(nombres, nombres_size * sizeof(char *));
+    }
+    nombres[n_nombres++] = strdup(entrada->d_name);
+  }
+  closedir(dir);
+
+  if (n_nombres > 0) {
+    qsort(nombres, n_nombres, sizeof(char *), recursos_comparar_nombres);
+  }
+
+  for (size_t i = 0; i < n_nombres; i++) {
+    size_t len = strlen(nombres[i]) - strlen(".txt");
+    char *camino = malloc(strlen(directorio) + strlen(nombres[i]) + 2);
+
+    sprintf(camino, "%s/%s", directorio, nombres[i]);
+    nombres[i][len] = '\0';
+
+    // categoria_nueva_perezosa() ya explica por qué no pudo
+    if (recursos_buscar_categoria(self, nombres[i]) == NULL) {
+      Categoria *categoria = categoria_nueva_perezosa(nombres[i], camino);
+      if (categoria != NULL) {
+        recursos_agregar_categoria(self, categoria);
+      }
+    }
+    free(camino);
+    free(nombres[i]);
+  }
+  free(nombres);
+}
+
+int recursos_comparar_nombres(const void *a,
+                              const void *b)
+{
+  return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/**
+ * Agrega @nueva_categoria al final del menú. Si ya hay una categoría con
+ * su nombre, se destruye y se queda la que había.
+ *
+ * @nueva_categoria (transfer: full) (nullable) La categoría
+ */
+void recursos_agregar_categoria(Recursos  *self,
+                                Categoria *nueva_categoria)
+{
+  Categoria **casilla;
+
+  if (nueva_categoria == NULL)
+    {
+      fprintf (stderr, "No se puede agregar categoria.\n");
+      return;
+    }
+
+  casilla = recursos_buscar_casilla(self, categoria_get_nombre(nueva_categoria));
+  if (casilla != NULL && *casilla != NULL) {
+    categoria_destruir(nueva_categoria);
+    return;
+  }
+
+  if (self->n_categorias == self->categorias_size) {
+    self->categorias_size = self->categorias_size > 0
+                            ? 2 * self->categorias_size : 16;
+    self->categorias = realloc(self->categorias,
+                               self->categorias_size * sizeof(Categoria *));
+  }
+  self->categorias[self->n_categorias++] = nueva_categoria;
+
+  // Dejamos la tabla a lo más medio llena, para que las búsquedas sean cortas
+  if (casilla == NULL || 2 * self->n_categorias > self->tabla_mascara + 1) {
+    size_t tabla_size = self->tabla_mascara > 0 ? self->tabla_mascara + 1 : 16;
+
+    while (tabla_size < 2 * self->n_categorias) {
+      tabla_size *= 2;
+    }
+    free(self->tabla);
+    self->tabla = calloc(tabla_size, sizeof(Categoria *));
+    self->tabla_mascara = tabla_size - 1;
+    for (size_t i = 0; i < self->n_categorias; i++) {
+      Categoria *categoria = self->categorias[i];
+      *recursos_buscar_casilla(self, categoria_get_nombre(categoria)) = categoria;
+    }
+  } else {
+    *casilla = nueva_categoria;
+  }
+}
+
+/**
+ * Busca la casilla de @nombre en la tabla de @self: la que ya tiene a la
+ * categoría @nombre, o la vacía donde iría
+ *
+ * Returns: (transfer: none) La casilla, o NULL si todavía no hay tabla
+ */
+Categoria **recursos_buscar_casilla(Recursos   *self,
+                                    const char *nombre)
+{
+  size_t i;
+
+  if (self->tabla == NULL) {
+    return NULL;
+  }
+
+  i = recursos_hash(nombre) & self->tabla_mascara;
+  while (self->tabla[i] != NULL
+         && strcmp(categoria_get_nombre(self->tabla[i]), nombre) != 0) {
+    i = (i + 1) & self->tabla_mascara;
+  }
+  return &self->tabla[i];
+}
+
+/**
+ * Returns: El hash FNV-1a de @nombre
+ */
+uint64_t recursos_hash(const char *nombre)
+{
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  for (const unsigned char *c = (const unsigned char *) nombre; *c != '\0'; c++) {
+    hash = (hash ^ *c) * UINT64_C(1099511628211);
+  }
+  return hash;
+}
+
+/**
+ * Returns: (transfer: none) La categoría que se llama @nombre, o NULL si no
+ * hay ninguna
+ */
+Categoria *recursos_buscar_categoria(Recursos   *self,
+                                     const char *nombre)
+{
+  Categoria **casilla;
+
+  if (self == NULL || nombre == NULL) {
+    return NULL;
+  }
+  casilla = recursos_buscar_casilla(self, nombre);
+  return casilla != NULL ? *casilla : NULL;
+}
+
+/**
+ * Empieza a leer las palabras de todas las categorías con varios hilos, sin
+ * esperarlos. Si alguien elige una categoría antes de que le toque, la lee
+ * él mismo con categoria_cargar(), que también cuida que no se lea dos veces.
+ *
+ * recursos_cargar() no lo hace por su cuenta: quien juega en la terminal
+ * solo lee la categoría que elige, y no tiene por qué leer cientos de
+ * listas. Lo usa quien va a necesitarlas todas, como el servidor.
+ */
+void recursos_precargar(Recursos *self)
+{
+  long n_nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t n_hilos = n_nucleos > 0 ? n_nucleos : 1;
+
+  if (self == NULL || self->hilos != NULL) {
+    return;
+  }
+  if (n_hilos > RECURSOS_MAX_HILOS) {
+    n_hilos = RECURSOS_MAX_HILOS;
+  }
+  if (n_hilos > self->n_categorias) {
+    n_hilos = self->n_categorias;
+  }
+
+  atomic_store(&self->siguiente, 0);
+  atomic_store(&self->detener, false);
+  self->hilos = calloc(n_hilos > 0 ? n_hilos : 1, sizeof(pthread_t));
+  for (self->n_hilos = 0; self->n_hilos < n_hilos; self->n_hilos++) {
+    // Si no se puede crear un hilo, las categorías que falten se leen al usarse
+    if (pthread_create(&self->hilos[self->n_hilos], NULL,
+                       recursos_precargar_hilo, self) != 0) {
+      break;
+    }
+  }
+}
+
+void *recursos_precargar_hilo(void *datos)
+{
+  Recursos *self = datos;
+
+  while (!atomic_load_explicit(&self->detener, memory_order_relaxed)) {
+    size_t i = atomic_fetch_add(&self->siguiente, 1);
+
+    if (i >= self->n_categorias) {
+      break;
+    }
+    categoria_cargar(self->categorias[i]);
+  }
+  return NULL;
+}
+
+/**
+ * Espera a que los hilos de recursos_precargar() terminen de leer todas las
+ * categorías
+ */
+void recursos_esperar(Recursos *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < self->n_hilos; i++) {
+    pthread_join(self->hilos[i], NULL);
+  }
+  free(self->hilos);
+  self->hilos = NULL;
+  self->n_hilos = 0;
+}
+
+/**
+ * Detiene los hilos de recursos_precargar(). Las categorías que no
+ * alcanzaron a leer se quedan sin leer.
+ */
+void recursos_detener(Recursos *self)
+{
+  atomic_store(&self->detener, true);
+  recursos_esperar(self);
+}
+
+size_t recursos_get_n_categorias(Recursos *self)
+{
+  if (self == NULL) {
+    return 0;
+  }
+  return self->n_categorias;
+}
+
+/**
+ * Returns: (transfer: none) La categoría @indice, o NULL si no existe
+ */
+Categoria *recursos_get_categoria(Recursos *self,
+                                  size_t    indice)
+{
+  if (self == NULL || indice >= self->n_categorias) {
+    return NULL;
+  }
+  return self->categorias[indice];
+}
+
+/**
+ * Returns: (transfer: none) La textura @textura
+ */
+Textura *recursos_get_textura(Recursos        *self,
+                              RecursosTextura  textura)
+{
+  if (self == NULL || textura >= RECURSOS_N_TEXTURAS) {
+    return NULL;
+  }
+  return self->texturas[textura];
+}
+
+/**
+ * Returns: (transfer: none) La tira con @vidas corazones, o NULL si @vidas
+ * está fuera de 0 a PARTIDA_VIDAS
+ */
+Textura *recursos_get_vidas(Recursos *self,
+                            int       vidas)
+{
+  if (self == NULL || vidas < 0 || vidas > PARTIDA_VIDAS) {
+    return NULL;
+  }
+  return self->vidas[vidas];
+}
+
+/**
+ * Retorna la representación en cadena de caracteres de @textura
+ *
+ * Returns: (transfer: none) El nombre de @textura en el paquete de recursos
+ */
+const char *recursos_textura_to_string(RecursosTextura textura)
+{
+  switch (textura) {
+  case RECURSOS_SPLASH:
+    return "splash";
+  case RECURSOS_CORAZON:
+    return "corazon";
+  case RECURSOS_VICTORIA:
+    return "victoria";
+  case RECURSOS_DERROTA:
+    return "derrota";
+  case RECURSOS_N_TEXTURAS:
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * Libera las categorías, las texturas y el paquete del que salieron, pero
+ * deja a @self listo para cargar otros
+ */
+void recursos_liberar(Recursos *self)
+{
+  recursos_detener(self);
+
+  for (size_t i = 0; i < self->n_categorias; i++)
+  {
+    categoria_destruir(self->categorias[i]);
+  }
+  self->n_categorias = 0;
+  free(self->tabla);
+  self->tabla = NULL;
+  self->tabla_mascara = 0;
+
+  for (RecursosTextura t = 0; t < RECURSOS_N_TEXTURAS; t++) {
+    if (self->texturas[t] != NULL) {
+      textura_liberar(self->texturas[t]);
+    }
+    self->texturas[t] = NULL;
+  }
+  for (size_t i = 0; i <= PARTIDA_VIDAS; i++) {
+    self->vidas[i] = NULL;
+  }
+
+  // Lo que quedaba en la arena eran las categorías y texturas
+  arena_reiniciar(self->arena);
+
+  // El paquete se cierra al final, porque las categorías y texturas lo usan
+  if (self->paquete != NULL) {
+    paquete_cerrar(self->paquete);
+    self->paquete = NULL;
+  }
+}
+
+void recursos_destruir(Recursos *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  recursos_liberar(self);
+  free(self->categorias);
+  arena_destruir(self->arena);
+  free(self);
+}
@@ -0,0 +1,46 @@
+/* recursos.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "categoria.h"
+#include "textura.h"
+
+/**
+ * Las texturas que usa el juego. Su nombre en el paquete, y el de su archivo
+ * en recursos/, es el que da recursos_textura_to_string().
+ */
+typedef enum {
+  RECURSOS_SPLASH,
+  RECURSOS_CORAZON,
+  RECURSOS_VICTORIA,
+  RECURSOS_DERROTA,
+  RECURSOS_N_TEXTURAS
+} RecursosTextura;
+
+/*
+ * Los recursos son las categorías y texturas del juego. Se cargan una sola
+ * vez por proceso y después solo se leen, así que todas las partidas (y
+ * todos los hilos) los comparten.
+ */
+struct __Recursos;
+typedef struct __Recursos Recursos;
+
+Recursos *recursos_cargar(void);
+size_t recursos_get_n_categorias(Recursos *);
+Categoria *recursos_get_categoria(Recursos *, size_t);
+Categoria *recursos_buscar_categoria(Recursos *, const char *);
+void recursos_precargar(Recursos *);
+void recursos_esperar(Recursos *);
+Textura *recursos_get_textura(Recursos *, RecursosTextura);
+Textura *recursos_get_vidas(Recursos *, int);
+const char *recursos_textura_to_string(RecursosTextura);
+void recursos_destruir(Recursos *);
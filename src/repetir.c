@@ -0,0 +1,345 @@
+/* repetir.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * adivinador-repetir: vuelve a jugar las partidas de una o más bitácoras
+ * (adivinador --journal) con el motor de ahora, y revisa que cada intento
+ * dé el mismo resultado, deje las mismas vidas y la partida en el mismo
+ * estado que cuando se jugó. Sirve para reproducir lo que le pasó a un
+ * jugador y para revisar que un cambio al motor no cambie lo que ven.
+ *
+ * Las rondas se repiten con la palabra que quedó en la bitácora, así que no
+ * hacen falta las listas de palabras.
+ *
+ * Uso: adivinador-repetir [--verbose] BITACORA...
+ *
+ * Sale con 1 si algún intento no coincidió o alguna bitácora no se pudo
+ * leer completa.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bitacora.h"
+#include "partida.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+/* Cuántas diferencias se imprimen sin --verbose */
+#define REPETIR_MAX_DIFERENCIAS 10
+
+/**
+ * Una sesión de la bitácora. Al terminar, su partida regresa a @libres del
+ * Repeticion para la siguiente sesión, pero la casilla se queda con
+ * @partida en NULL hasta la siguiente ejecución de la bitácora.
+ */
+typedef struct {
+  uint64_t sesion;
+  Partida *partida;
+  bool ocupada;
+} RepetirSesion;
+
+/**
+ * @sesiones es una tabla hash de direccionamiento abierto por número de
+ * sesión, a lo más medio llena; se vacía en cada cabecera, porque los
+ * números solo son únicos dentro de una ejecución.
+ */
+typedef struct {
+  RepetirSesion *sesiones;
+  size_t sesiones_mascara;
+  size_t n_sesiones;
+
+  Partida **libres;
+  size_t n_libres;
+  size_t libres_size;
+
+  bool detallado;
+  uint64_t eventos;
+  uint64_t rondas;
+  uint64_t intentos;
+  uint64_t sesiones_totales;
+  uint64_t diferencias;
+} Repeticion;
+
+bool repetir_archivo(Repeticion *, const char *);
+void repetir_evento(Repeticion *, const char *, size_t, BitacoraEvento *);
+Partida *repetir_buscar_partida(Repeticion *, uint64_t);
+RepetirSesion *repetir_buscar_casilla(Repeticion *, uint64_t);
+void repetir_terminar_sesion(Repeticion *, uint64_t);
+void repetir_vaciar(Repeticion *);
+const char *repetir_intento_to_string(uint8_t);
+double repetir_ahora(void);
+
+int main(int argc,
+         char **argv)
+{
+  Repeticion repeticion = { 0 };
+  bool correcto = true;
+  double inicio, duracion;
+  int primero = 1;
+
+  if (argc > 1 && strcmp(argv[1], "--verbose") == 0) {
+    repeticion.detallado = true;
+    primero++;
+  }
+  if (argc <= primero) {
+    fprintf(stderr, "Uso: %s [--verbose] BITACORA...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  inicio = repetir_ahora();
+  for (int i = primero; i < argc; i++) {
+    correcto = repetir_archivo(&repeticion, argv[i]) && correcto;
+  }
+  duracion = repetir_ahora() - inicio;
+
+  printf("%llu eventos (%llu sesiones, %llu rondas, %llu intentos) en %.3f s: "
+         "%.0f eventos/s\n",
+         (unsigned long long) repeticion.eventos,
+         (unsigned long long) repeticion.sesiones_totales,
+         (unsigned long long) repeticion.rondas,
+         (unsigned long long) repeticion.intentos,
+         duracion, duracion > 0 ? repeticion.eventos / duracion : 0);
+  printf("%llu diferencias\n", (unsigned long long) repeticion.diferencias);
+
+  repetir_vaciar(&repeticion);
+  for (size_t i = 0; i < repeticion.n_libres; i++) {
+    partida_destruir(repeticion.libres[i]);
+  }
+  free(repeticion.libres);
+  free(repeticion.sesiones);
+
+  return correcto && repeticion.diferencias == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Repite todos los eventos de la bitácora @archivo
+ *
+ * Returns: true si se pudo leer completa
+ */
+bool repetir_archivo(Repeticion *self,
+                     const char *archivo)
+{
+  BitacoraLector *lector = bitacora_lector_abrir(archivo);
+  BitacoraEvento evento;
+  bool terminado;
+
+  if (lector == NULL) {
+    fprintf(stderr, "No se pudo leer la bitácora %s\n", archivo);
+    return false;
+  }
+
+  while (bitacora_lector_siguiente(lector, &evento)) {
+    repetir_evento(self, archivo, bitacora_lector_get_offset(lector), &evento);
+  }
+
+  terminado = bitacora_lector_terminado(lector);
+  if (!terminado) {
+    // Normalmente el proceso terminó a medias de escribir el último evento
+    fprintf(stderr, "%s: no se pudo leer desde el byte %zu\n", archivo,
+            bitacora_lector_get_offset(lector));
+  }
+  bitacora_lector_cerrar(lector);
+
+  // La siguiente bitácora puede repetir números de sesión
+  repetir_vaciar(self);
+  return terminado;
+}
+
+/**
+ * Repite @evento y lo compara con lo que se anotó
+ *
+ * @archivo La bitácora, para los mensajes
+ * @offset Dónde termina @evento en @archivo, para los mensajes
+ */
+void repetir_evento(Repeticion     *self,
+                    const char     *archivo,
+                    size_t          offset,
+                    BitacoraEvento *evento)
+{
+  Partida *partida;
+  PartidaIntento resultado;
+
+  self->eventos++;
+
+  switch (evento->tipo) {
+  case BITACORA_CABECERA:
+    repetir_vaciar(self);
+    break;
+
+  case BITACORA_SESION:
+    partida_sembrar(repetir_buscar_partida(self, evento->sesion),
+                    evento->semilla);
+    break;
+
+  case BITACORA_RONDA:
+    self->rondas++;
+    partida_elegir_palabra_texto(repetir_buscar_partida(self, evento->sesion),
+                                 evento->texto, evento->texto_len);
+    break;
+
+  case BITACORA_INTENTO:
+    self->intentos++;
+    partida = repetir_buscar_partida(self, evento->sesion);
+    if (evento->intento == 'c') {
+      resultado = partida_intentar_caracter(partida, evento->texto);
+    } else {
+      resultado = partida_intentar_palabra(partida, evento->texto);
+    }
+
+    if (resultado != evento->resultado
+        || partida_get_vidas(partida) != evento->vidas
+        || partida_get_estado(partida) != evento->estado) {
+      self->diferencias++;
+      if (self->detallado || self->diferencias <= REPETIR_MAX_DIFERENCIAS) {
+        printf("%s:%zu: sesión %llu, «%s» en «%s»: %s con %d vidas y estado "
+               "%d, pero se anotó %s con %d vidas y estado %d\n",
+               archivo, offset, (unsigned long long) evento->sesion,
+               evento->texto,
+               palabra_get_texto(partida_get_palabra(partida)),
+               repetir_intento_to_string(resultado),
+               partida_get_vidas(partida), partida_get_estado(partida),
+               repetir_intento_to_string(evento->resultado),
+               evento->vidas, evento->estado);
+      }
+    }
+    break;
+
+  case BITACORA_FIN:
+    repetir_terminar_sesion(self, evento->sesion);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * Returns: (transfer: none) La partida de la sesión @sesion, que se crea
+ * (o se toma de las libres) si es nueva
+ */
+Partida *repetir_buscar_partida(Repeticion *self,
+                                uint64_t    sesion)
+{
+  RepetirSesion *casilla;
+
+  // Dejamos la tabla a lo más medio llena, para que las búsquedas sean cortas
+  if (2 * (self->n_sesiones + 1) > self->sesiones_mascara + 1) {
+    RepetirSesion *anteriores = self->sesiones;
+    size_t n_anteriores = anteriores != NULL ? self->sesiones_mascara + 1 : 0;
+    size_t tabla_size = n_anteriores > 0 ? 2 * n_anteriores : 64;
+
+    self->sesiones = calloc(tabla_size, sizeof(RepetirSesion));
+    self->sesiones_mascara = tabla_size - 1;
+    for (size_t i = 0; i < n_anteriores; i++) {
+      if (anteriores[i].ocupada) {
+        *repetir_buscar_casilla(self, anteriores[i].sesion) = anteriores[i];
+      }
+    }
+    free(anteriores);
+  }
+
+  casilla = repetir_buscar_casilla(self, sesion);
+  if (!casilla->ocupada) {
+    casilla->ocupada = true;
+    casilla->sesion = sesion;
+    self->n_sesiones++;
+  }
+  if (casilla->partida == NULL) {
+    casilla->partida = self->n_libres > 0 ? self->libres[--self->n_libres]
+                                          : partida_nueva();
+    self->sesiones_totales++;
+  }
+  return casilla->partida;
+}
+
+/**
+ * Returns: La casilla de @sesion en la tabla: la que ya la tiene, o la
+ * vacía donde iría
+ */
+RepetirSesion *repetir_buscar_casilla(Repeticion *self,
+                                      uint64_t    sesion)
+{
+  size_t i = (sesion * UINT64_C(0x9E3779B97F4A7C15) >> 32) & self->sesiones_mascara;
+
+  while (self->sesiones[i].ocupada && self->sesiones[i].sesion != sesion) {
+    i = (i + 1) & self->sesiones_mascara;
+  }
+  return &self->sesiones[i];
+}
+
+/**
+ * Regresa la partida de la sesión @sesion a las libres
+ */
+void repetir_terminar_sesion(Repeticion *self,
+                             uint64_t    sesion)
+{
+  RepetirSesion *casilla;
+
+  if (self->sesiones == NULL) {
+    return;
+  }
+  casilla = repetir_buscar_casilla(self, sesion);
+  if (casilla->partida == NULL) {
+    return;
+  }
+
+  if (self->n_libres == self->libres_size) {
+    self->libres_size = self->libres_size > 0 ? 2 * self->libres_size : 16;
+    self->libres = realloc(self->libres, self->libres_size * sizeof(Partida *));
+  }
+  self->libres[self->n_libres++] = casilla->partida;
+  casilla->partida = NULL;
+}
+
+/**
+ * Termina todas las sesiones y vacía la tabla, para empezar otra ejecución
+ */
+void repetir_vaciar(Repeticion *self)
+{
+  if (self->sesiones == NULL) {
+    return;
+  }
+  for (size_t i = 0; i <= self->sesiones_mascara; i++) {
+    if (self->sesiones[i].ocupada) {
+      repetir_terminar_sesion(self, self->sesiones[i].sesion);
+    }
+  }
+  memset(self->sesiones, 0, (self->sesiones_mascara + 1) * sizeof(RepetirSesion));
+  self->n_sesiones = 0;
+}
+
+const char *repetir_intento_to_string(uint8_t intento)
+{
+  switch (intento) {
+  case PARTIDA_INTENTO_ACIERTO:
+    return "acierto";
+  case PARTIDA_INTENTO_FALLO:
+    return "fallo";
+  case PARTIDA_INTENTO_REPETIDO:
+    return "repetido";
+  case PARTIDA_INTENTO_INVALIDO:
+    return "inválido";
+  default:
+    return "desconocido";
+  }
+}
+
+double repetir_ahora(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
@@ -0,0 +1,1089 @@
+/* servidor.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Para accept4()
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "azar.h"
+#include "marco.h"
+#include "palabra.h"
+#include "partida.h"
+#include "servidor.h"
+#include "u8.h"
+
+#define SERVIDOR_EVENTOS 256
+#define SESION_LINEA_MAX 256
+
+/**
+ * En qué parte del juego va una conexión, es decir, qué espera que sea la
+ * siguiente línea que mande el jugador
+ */
+typedef enum {
+  SESION_INICIO,
+  SESION_CATEGORIA,
+  SESION_TIPO,
+  SESION_CARACTER,
+  SESION_PALABRA,
+  SESION_CONTINUAR,
+  SESION_CERRANDO
+} SesionEstado;
+
+typedef struct __Trabajador Trabajador;
+
+/**
+ * Una conexión y su partida. @entrada tiene lo que ha llegado del socket y
+ * todavía no forma una línea completa; @salida, lo que el socket no ha
+ * aceptado. Mientras quede salida pendiente no se lee más del socket, así
+ * que un cliente que no lee no puede hacernos acumular respuestas.
+ *
+ * La sesión pertenece al @trabajador que la aceptó: está en su epoll y en
+ * su lista de sesiones (@anterior y @siguiente). Cuando epoll la reporta,
+ * espera en la cola de listas de su trabajador (@listo_anterior y
+ * @listo_siguiente) con los @pendientes que se reportaron, hasta que su
+ * trabajador u otro que no tenga nada que hacer la atienda.
+ */
+typedef struct __Sesion Sesion;
+struct __Sesion {
+  int fd;
+  SesionEstado estado;
+  Partida *partida;
+  Marco *salida;
+  char entrada[SESION_LINEA_MAX];
+  size_t entrada_len;
+  uint32_t eventos;
+  uint32_t pendientes;
+  Trabajador *trabajador;
+  Sesion *anterior;
+  Sesion *siguiente;
+  Sesion *listo_anterior;
+  Sesion *listo_siguiente;
+};
+
+/**
+ * Un hilo del servidor y su parte de las sesiones.
+ *
+ * Las sesiones se registran con EPOLLONESHOT, así que después de que
+ * epoll_wait() reporta una no vuelve a reportarla hasta que se rearma. Eso
+ * garantiza que una sesión está a lo más en una cola y que solo un hilo la
+ * atiende a la vez, aunque no sea su dueño.
+ *
+ * La cola de listas es una deque: el dueño toma del frente y los demás
+ * roban del final. @candado protege la cola y la lista de sesiones; la
+ * lista solo cambia al aceptar y al cerrar una conexión.
+ */
+struct __Trabajador {
+  Servidor *servidor;
+  pthread_t hilo;
+  int epoll;
+  int reserva;
+  pthread_mutex_t candado;
+  Sesion *listos_primero;
+  Sesion *listos_ultimo;
+  Sesion *sesiones;
+};
+
+/**
+ * @escucha es el socket que acepta conexiones. Está en el epoll de todos los
+ * trabajadores con EPOLLEXCLUSIVE, así que cada conexión nueva despierta a
+ * uno solo, que se queda con ella.
+ *
+ * @despertar es un eventfd que también está en todos los epoll. Un
+ * trabajador escribe en él cuando le quedan sesiones en cola y hay
+ * trabajadores @ociosos, para que alguno despierte a robarlas; al detener
+ * el servidor ya nadie lo lee, y cada trabajador que despierta lo vuelve a
+ * escribir para despertar al siguiente.
+ *
+ * Los recursos (y con ellos las categorías) solo se leen, así que todos los
+ * hilos los usan sin candados.
+ *
+ * La partida de la sesión número @n_sesiones se siembra con @semilla
+ * revuelta con ese número, así que con la misma @semilla las sesiones
+ * reciben las mismas palabras en el orden en que se conectan. Si hay
+ * @bitacora, ese número es también el de la sesión en ella.
+ */
+struct __Servidor {
+  Recursos *recursos;
+  int escucha;
+  int despertar;
+  char *ruta_unix;
+  Trabajador *trabajadores;
+  unsigned int n_trabajadores;
+  atomic_uint ociosos;
+  atomic_bool detenido;
+  uint64_t semilla;
+  atomic_uint_least64_t n_sesiones;
+  Bitacora *bitacora;
+  Marcador *marcador;
+};
+
+int servidor_escuchar_unix(const char *);
+int servidor_escuchar_tcp(const char *);
+void *servidor_trabajar(void *);
+void servidor_despertar(Servidor *);
+Sesion *servidor_robar(Servidor *, Trabajador *);
+void trabajador_encolar(Trabajador *, Sesion *, uint32_t);
+Sesion *trabajador_tomar(Trabajador *);
+void trabajador_aceptar(Trabajador *);
+void trabajador_agregar_sesion(Trabajador *, int);
+void trabajador_destruir(Trabajador *);
+void servidor_atender(Servidor *, Sesion *, uint32_t);
+bool servidor_armar(Sesion *, int);
+void servidor_cerrar_sesion(Sesion *);
+bool sesion_leer(Servidor *, Sesion *);
+bool sesion_escribir(Sesion *);
+void sesion_procesar_linea(Servidor *, Sesion *, char *);
+void sesion_imprimir_categorias(Servidor *, Sesion *);
+void sesion_imprimir_tipos(Servidor *, Sesion *);
+void sesion_terminar_ronda(Servidor *, Sesion *);
+char *sesion_recortar(char *);
+long sesion_leer_opcion(const char *);
+
+/**
+ * Crea un servidor que escucha en @direccion y lee todas las categorías de
+ * @recursos. Todavía no atiende a nadie; para eso está servidor_ejecutar().
+ *
+ * @recursos Los recursos que comparten todas las partidas
+ * @direccion Un puerto, un host y puerto, o la ruta de un socket Unix
+ * @n_hilos Cuántos hilos atienden conexiones; 0 para uno por núcleo
+ *
+ * Returns: (transfer: full) El servidor, o NULL si no se pudo escuchar en
+ * @direccion
+ */
+Servidor *servidor_nuevo(Recursos     *recursos,
+                         const char   *direccion,
+                         unsigned int  n_hilos)
+{
+  Servidor *self;
+  struct rlimit limite;
+
+  if (recursos == NULL || direccion == NULL) {
+    return NULL;
+  }
+
+  if (n_hilos == 0) {
+    long n_nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    n_hilos = n_nucleos > 0 ? n_nucleos : 1;
+  }
+
+  self = calloc(1, sizeof(Servidor));
+  self->recursos = recursos;
+  self->despertar = -1;
+  self->semilla = azar_semilla_nueva();
+
+  if (strchr(direccion, '/') != NULL) {
+    self->escucha = servidor_escuchar_unix(direccion);
+    self->ruta_unix = strdup(direccion);
+  } else {
+    self->escucha = servidor_escuchar_tcp(direccion);
+  }
+  if (self->escucha < 0) {
+    fprintf(stderr, "No se pudo escuchar en %s\n", direccion);
+    servidor_destruir(self);
+    return NULL;
+  }
+
+  self->despertar = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (self->despertar < 0) {
+    fprintf(stderr, "No se pudo crear el eventfd: %s\n", strerror(errno));
+    servidor_destruir(self);
+    return NULL;
+  }
+
+  self->trabajadores = calloc(n_hilos, sizeof(Trabajador));
+  for (unsigned int i = 0; i < n_hilos; i++) {
+    Trabajador *trabajador = &self->trabajadores[i];
+    struct epoll_event escucha = {
+      .events = EPOLLIN | EPOLLEXCLUSIVE,
+      .data.ptr = NULL,
+    };
+    struct epoll_event despertar = {
+      .events = EPOLLIN | EPOLLEXCLUSIVE,
+      .data.ptr = self,
+    };
+
+    trabajador->servidor = self;
+    trabajador->reserva = -1;
+    pthread_mutex_init(&trabajador->candado, NULL);
+    self->n_trabajadores++;
+
+    trabajador->epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (trabajador->epoll < 0
+        || epoll_ctl(trabajador->epoll, EPOLL_CTL_ADD, self->escucha, &escucha) < 0
+        || epoll_ctl(trabajador->epoll, EPOLL_CTL_ADD, self->despertar,
+                     &despertar) < 0) {
+      fprintf(stderr, "No se pudo crear el epoll: %s\n", strerror(errno));
+      servidor_destruir(self);
+      return NULL;
+    }
+  }
+
+  // Cada conexión es un descriptor, así que pedimos todos los que se pueda
+  if (getrlimit(RLIMIT_NOFILE, &limite) == 0 && limite.rlim_cur < limite.rlim_max) {
+    limite.rlim_cur = limite.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limite);
+  }
+  for (unsigned int i = 0; i < n_hilos; i++) {
+    self->trabajadores[i].reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+
+  /*
+   * Leer una categoría puede tardar segundos si es grande o hay que
+   * indexarla, y si pasara en un trabajador detendría a todas las sesiones
+   * de su epoll. Por eso las leemos todas antes de empezar a atender.
+   */
+  recursos_precargar(recursos);
+  recursos_esperar(recursos);
+
+  printf("Escuchando en %s con %u hilos\n", direccion, n_hilos);
+  fflush(stdout);
+  return self;
+}
+
+/**
+ * Returns: El socket de escucha en @ruta, o -1 si no se pudo crear
+ */
+int servidor_escuchar_unix(const char *ruta)
+{
+  struct sockaddr_un direccion = { .sun_family = AF_UNIX };
+  struct stat info;
+  int fd;
+
+  if (strlen(ruta) >= sizeof(direccion.sun_path)) {
+    return -1;
+  }
+  strcpy(direccion.sun_path, ruta);
+
+  // Un socket que quedó de una ejecución anterior no deja hacer bind()
+  if (lstat(ruta, &info) == 0 && S_ISSOCK(info.st_mode)) {
+    unlink(ruta);
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (bind(fd, (struct sockaddr *) &direccion, sizeof(direccion)) < 0
+      || listen(fd, SOMAXCONN) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @direccion "PUERTO", "HOST:PUERTO" o "[HOST]:PUERTO". Sin host se escucha
+ * en todas las interfaces.
+ *
+ * Returns: El socket de escucha, o -1 si no se pudo crear
+ */
+int servidor_escuchar_tcp(const char *direccion)
+{
+  struct addrinfo pistas = {
+    .ai_family = AF_UNSPEC,
+    .ai_socktype = SOCK_STREAM,
+    .ai_flags = AI_PASSIVE,
+  };
+  struct addrinfo *resultados, *r;
+  char host[256];
+  const char *puerto = direccion;
+  const char *dos_puntos = strrchr(direccion, ':');
+  int fd = -1;
+
+  host[0] = '\0';
+  if (dos_puntos != NULL) {
+    size_t host_len = dos_puntos - direccion;
+
+    // Quitamos los corchetes de las direcciones IPv6
+    if (host_len >= 2 && direccion[0] == '[' && direccion[host_len - 1] == ']') {
+      direccion++;
+      host_len -= 2;
+    }
+    if (host_len >= sizeof(host)) {
+      return -1;
+    }
+    memcpy(host, direccion, host_len);
+    host[host_len] = '\0';
+    puerto = dos_puntos + 1;
+  }
+
+  if (getaddrinfo(host[0] != '\0' ? host : NULL, puerto, &pistas,
+                  &resultados) != 0) {
+    return -1;
+  }
+
+  for (r = resultados; r != NULL; r = r->ai_next) {
+    int si = 1;
+
+    fd = socket(r->ai_family, r->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                r->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &si, sizeof(si));
+    if (bind(fd, r->ai_addr, r->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(resultados);
+
+  return fd;
+}
+
+/**
+ * Atiende conexiones hasta que alguien llame a servidor_detener(). El hilo
+ * que llama es el primer trabajador; los demás se crean aquí con SIGINT y
+ * SIGTERM bloqueadas, para que esas señales siempre le lleguen a quien
+ * llamó.
+ *
+ * Returns: false si no se pudieron crear los hilos o epoll dejó de funcionar
+ */
+bool servidor_ejecutar(Servidor *self)
+{
+  sigset_t senales, anteriores;
+  unsigned int creados = 1;
+  bool correcto = true;
+
+  if (self == NULL) {
+    return false;
+  }
+
+  sigemptyset(&senales);
+  sigaddset(&senales, SIGINT);
+  sigaddset(&senales, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &senales, &anteriores);
+  for (; creados < self->n_trabajadores; creados++) {
+    Trabajador *trabajador = &self->trabajadores[creados];
+
+    if (pthread_create(&trabajador->hilo, NULL, servidor_trabajar,
+                       trabajador) != 0) {
+      fprintf(stderr, "No se pudo crear el hilo %u\n", creados);
+      servidor_detener(self);
+      correcto = false;
+      break;
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+
+  if (correcto && servidor_trabajar(&self->trabajadores[0]) != NULL) {
+    correcto = false;
+  }
+  for (unsigned int i = 1; i < creados; i++) {
+    void *resultado;
+
+    pthread_join(self->trabajadores[i].hilo, &resultado);
+    if (resultado != NULL) {
+      correcto = false;
+    }
+  }
+  return correcto;
+}
+
+/**
+ * Cambia la semilla de la que salen las de todas las sesiones. Se llama
+ * antes de servidor_ejecutar().
+ */
+void servidor_sembrar(Servidor *self,
+                      uint64_t  semilla)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->semilla = semilla;
+}
+
+/**
+ * Anota en @bitacora las partidas de todas las sesiones que se conecten de
+ * aquí en adelante. Se llama antes de servidor_ejecutar().
+ *
+ * @bitacora (nullable) La bitácora, que debe vivir más que @self
+ */
+void servidor_set_bitacora(Servidor *self,
+                           Bitacora *bitacora)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->bitacora = bitacora;
+}
+
+/**
+ * Anota en @marcador cada partida que termine. Las sesiones no tienen
+ * jugador, así que solo se anota la categoría. Se llama antes de
+ * servidor_ejecutar().
+ *
+ * @marcador (nullable) El marcador, que debe vivir más que @self
+ */
+void servidor_set_marcador(Servidor *self,
+                           Marcador *marcador)
+{
+  if (self == NULL) {
+    return;
+  }
+  self->marcador = marcador;
+}
+
+/**
+ * Pide a @self que deje de atender conexiones. Solo cambia una bandera y
+ * escribe en un eventfd, así que se puede llamar desde un manejador de
+ * señales.
+ */
+void servidor_detener(Servidor *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  atomic_store(&self->detenido, true);
+  servidor_despertar(self);
+}
+
+/**
+ * Despierta a algún trabajador que esté esperando en epoll_wait()
+ */
+void servidor_despertar(Servidor *self)
+{
+  eventfd_write(self->despertar, 1);
+}
+
+/**
+ * El ciclo de un trabajador. Primero atiende las sesiones de su cola; si no
+ * tiene, revisa su epoll sin esperar y, si tampoco hay nada, le roba una
+ * sesión a otro trabajador. Solo cuando nadie tiene trabajo se duerme en
+ * epoll_wait().
+ *
+ * @datos El Trabajador
+ *
+ * Returns: NULL, o algo distinto si epoll dejó de funcionar
+ */
+void *servidor_trabajar(void *datos)
+{
+  Trabajador *self = datos;
+  Servidor *servidor = self->servidor;
+  struct epoll_event eventos[SERVIDOR_EVENTOS];
+
+  for (;;) {
+    Sesion *sesion = trabajador_tomar(self);
+    size_t n_encoladas = 0;
+    int n;
+
+    if (sesion != NULL) {
+      servidor_atender(servidor, sesion, sesion->pendientes);
+      continue;
+    }
+    if (atomic_load(&servidor->detenido)) {
+      // Quien nos despertó ya no va a despertar a los demás
+      servidor_despertar(servidor);
+      return NULL;
+    }
+
+    n = epoll_wait(self->epoll, eventos, SERVIDOR_EVENTOS, 0);
+    if (n == 0) {
+      sesion = servidor_robar(servidor, self);
+      if (sesion != NULL) {
+        servidor_atender(servidor, sesion, sesion->pendientes);
+        continue;
+      }
+      atomic_fetch_add(&servidor->ociosos, 1);
+      n = epoll_wait(self->epoll, eventos, SERVIDOR_EVENTOS, -1);
+      atomic_fetch_sub(&servidor->ociosos, 1);
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "Error esperando conexiones: %s\n", strerror(errno));
+      servidor_detener(servidor);
+      return self;
+    }
+
+    for (int i = 0; i < n; i++) {
+      if (eventos[i].data.ptr == NULL) {
+        trabajador_aceptar(self);
+      } else if (eventos[i].data.ptr == servidor) {
+        eventfd_t valor;
+
+        // Al detener el servidor no se lee, para que despierte a todos
+        if (!atomic_load(&servidor->detenido)) {
+          eventfd_read(servidor->despertar, &valor);
+        }
+      } else {
+        trabajador_encolar(self, eventos[i].data.ptr, eventos[i].events);
+        n_encoladas++;
+      }
+    }
+
+    // Nosotros atendemos una; las demás las puede robar alguien sin trabajo
+    if (n_encoladas > 1 && atomic_load(&servidor->ociosos) > 0) {
+      servidor_despertar(servidor);
+    }
+  }
+}
+
+/**
+ * Pone a @sesion al final de la cola de @self, con los @eventos que reportó
+ * epoll
+ */
+void trabajador_encolar(Trabajador *self,
+                        Sesion     *sesion,
+                        uint32_t    eventos)
+{
+  pthread_mutex_lock(&self->candado);
+  sesion->pendientes = eventos;
+  sesion->listo_siguiente = NULL;
+  sesion->listo_anterior = self->listos_ultimo;
+  if (self->listos_ultimo != NULL) {
+    self->listos_ultimo->listo_siguiente = sesion;
+  } else {
+    self->listos_primero = sesion;
+  }
+  self->listos_ultimo = sesion;
+  pthread_mutex_unlock(&self->candado);
+}
+
+/**
+ * Returns: (transfer: none) La primera sesión de la cola de @self, que sale
+ * de la cola, o NULL si está vacía
+ */
+Sesion *trabajador_tomar(Trabajador *self)
+{
+  Sesion *sesion;
+
+  pthread_mutex_lock(&self->candado);
+  sesion = self->listos_primero;
+  if (sesion != NULL) {
+    self->listos_primero = sesion->listo_siguiente;
+    if (self->listos_primero != NULL) {
+      self->listos_primero->listo_anterior = NULL;
+    } else {
+      self->listos_ultimo = NULL;
+    }
+  }
+  pthread_mutex_unlock(&self->candado);
+
+  return sesion;
+}
+
+/**
+ * Busca, empezando por el trabajador que sigue de @ladron, alguna cola con
+ * sesiones y toma la última
+ *
+ * Returns: (transfer: none) La sesión robada, o NULL si nadie tiene sesiones
+ * en cola
+ */
+Sesion *servidor_robar(Servidor   *self,
+                       Trabajador *ladron)
+{
+  size_t inicio = ladron - self->trabajadores;
+
+  for (unsigned int i = 1; i < self->n_trabajadores; i++) {
+    Trabajador *victima = &self->trabajadores[(inicio + i) % self->n_trabajadores];
+    Sesion *sesion;
+
+    pthread_mutex_lock(&victima->candado);
+    sesion = victima->listos_ultimo;
+    if (sesion != NULL) {
+      victima->listos_ultimo = sesion->listo_anterior;
+      if (victima->listos_ultimo != NULL) {
+        victima->listos_ultimo->listo_siguiente = NULL;
+      } else {
+        victima->listos_primero = NULL;
+      }
+    }
+    pthread_mutex_unlock(&victima->candado);
+
+    if (sesion != NULL) {
+      return sesion;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Acepta todas las conexiones en espera. Las sesiones nuevas son de @self.
+ */
+void trabajador_aceptar(Trabajador *self)
+{
+  int escucha = self->servidor->escucha;
+
+  for (;;) {
+    int fd = accept4(escucha, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd >= 0) {
+      trabajador_agregar_sesion(self, fd);
+      continue;
+    }
+    if (errno == EINTR || errno == ECONNABORTED) {
+      continue;
+    }
+    if ((errno == EMFILE || errno == ENFILE) && self->reserva >= 0) {
+      // Sin descriptores: la aceptamos con el de reserva solo para cerrarla
+      close(self->reserva);
+      fd = accept(escucha, NULL, NULL);
+      if (fd >= 0) {
+        close(fd);
+      }
+      self->reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+      continue;
+    }
+    return;
+  }
+}
+
+/**
+ * Empieza una sesión de @self en la conexión @fd y le deja lista la
+ * pantalla de inicio, que se manda en cuanto epoll diga que se puede
+ */
+void trabajador_agregar_sesion(Trabajador *self,
+                               int         fd)
+{
+  Recursos *recursos = self->servidor->recursos;
+  Sesion *sesion;
+  uint64_t n;
+  int si = 1;
+
+  // Las respuestas son cortas y el jugador las espera; no hay que juntarlas
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &si, sizeof(si));
+
+  sesion = calloc(1, sizeof(Sesion));
+  sesion->fd = fd;
+  sesion->estado = SESION_INICIO;
+  sesion->partida = partida_nueva();
+  sesion->salida = marco_nuevo();
+  sesion->trabajador = self;
+  n = atomic_fetch_add(&self->servidor->n_sesiones, 1);
+  partida_sembrar(sesion->partida, azar_mezclar(self->servidor->semilla, n));
+  partida_set_bitacora(sesion->partida, self->servidor->bitacora, n);
+
+  textura_dibujar(recursos_get_textura(recursos, RECURSOS_SPLASH),
+                  sesion->salida);
+  marco_agregar_cadena(sesion->salida, "\n\n\nPRESIONE ENTER PARA COMENZAR\n\n\n");
+  // Con esta semilla, adivinador --seed repite las palabras de la sesión
+  marco_printf(sesion->salida, "Semilla: %llu\n\n",
+               (unsigned long long) partida_get_semilla(sesion->partida));
+
+  pthread_mutex_lock(&self->candado);
+  sesion->siguiente = self->sesiones;
+  if (self->sesiones != NULL) {
+    self->sesiones->anterior = sesion;
+  }
+  self->sesiones = sesion;
+  pthread_mutex_unlock(&self->candado);
+
+  // Una vez en el epoll, otro hilo la puede atender: ya no la tocamos
+  if (!servidor_armar(sesion, EPOLL_CTL_ADD)) {
+    servidor_cerrar_sesion(sesion);
+  }
+}
+
+/**
+ * Atiende los @eventos que epoll reportó para @sesion: manda lo que tenía
+ * pendiente, procesa las líneas que lleguen y la vuelve a armar en el epoll
+ * de su trabajador. Si la conexión se cerró o ya no hay nada que hacer con
+ * ella, cierra la sesión.
+ */
+void servidor_atender(Servidor *self,
+                      Sesion   *sesion,
+                      uint32_t  eventos)
+{
+  if (eventos & EPOLLERR) {
+    servidor_cerrar_sesion(sesion);
+    return;
+  }
+
+  if (!sesion_escribir(sesion)) {
+    servidor_cerrar_sesion(sesion);
+    return;
+  }
+  if (marco_get_len(sesion->salida) == 0 && (eventos & (EPOLLIN | EPOLLHUP))) {
+    if (!sesion_leer(self, sesion) || !sesion_escribir(sesion)) {
+      servidor_cerrar_sesion(sesion);
+      return;
+    }
+  }
+
+  if (sesion->estado == SESION_CERRANDO && marco_get_len(sesion->salida) == 0) {
+    servidor_cerrar_sesion(sesion);
+    return;
+  }
+
+  if (!servidor_armar(sesion, EPOLL_CTL_MOD)) {
+    servidor_cerrar_sesion(sesion);
+  }
+}
+
+/**
+ * Registra (@operacion EPOLL_CTL_ADD) o rearma (EPOLL_CTL_MOD) a @sesion en
+ * el epoll de su trabajador: si tiene salida pendiente espera a poder
+ * escribir y si no, a que llegue algo que leer. Después de esto otro hilo
+ * puede estar atendiéndola.
+ *
+ * Returns: false si epoll no la aceptó
+ */
+bool servidor_armar(Sesion *sesion,
+                    int     operacion)
+{
+  struct epoll_event evento;
+
+  evento.events = EPOLLONESHOT
+                  | (marco_get_len(sesion->salida) > 0 ? EPOLLOUT : EPOLLIN);
+  evento.data.ptr = sesion;
+  return epoll_ctl(sesion->trabajador->epoll, operacion, sesion->fd,
+                   &evento) == 0;
+}
+
+void servidor_cerrar_sesion(Sesion *sesion)
+{
+  Trabajador *trabajador = sesion->trabajador;
+
+  pthread_mutex_lock(&trabajador->candado);
+  if (sesion->anterior != NULL) {
+    sesion->anterior->siguiente = sesion->siguiente;
+  } else {
+    trabajador->sesiones = sesion->siguiente;
+  }
+  if (sesion->siguiente != NULL) {
+    sesion->siguiente->anterior = sesion->anterior;
+  }
+  pthread_mutex_unlock(&trabajador->candado);
+
+  // close() también lo saca del epoll
+  close(sesion->fd);
+  partida_destruir(sesion->partida);
+  marco_destruir(sesion->salida);
+  free(sesion);
+}
+
+/**
+ * Lee del socket de @self hasta que no haya más, procesando cada línea
+ * completa. Deja de leer en cuanto hay respuestas que el socket no aceptó.
+ *
+ * Returns: false si el cliente cerró la conexión o hubo un error
+ */
+bool sesion_leer(Servidor *servidor,
+                 Sesion   *self)
+{
+  for (;;) {
+    char *inicio = self->entrada, *fin;
+    ssize_t n = recv(self->fd, &self->entrada[self->entrada_len],
+                     SESION_LINEA_MAX - self->entrada_len, 0);
+
+    if (n == 0) {
+      return false;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN;
+    }
+    self->entrada_len += n;
+
+    while ((fin = memchr(inicio, '\n',
+                         self->entrada_len - (inicio - self->entrada))) != NULL) {
+      *fin = '\0';
+      if (self->estado != SESION_CERRANDO) {
+        sesion_procesar_linea(servidor, self, inicio);
+      }
+      inicio = fin + 1;
+    }
+    self->entrada_len -= inicio - self->entrada;
+    memmove(self->entrada, inicio, self->entrada_len);
+
+    if (self->entrada_len == SESION_LINEA_MAX) {
+      marco_agregar_cadena(self->salida, "Línea demasiado larga\n");
+      self->estado = SESION_CERRANDO;
+    }
+    if (self->estado == SESION_CERRANDO
+        || !sesion_escribir(self) || marco_get_len(self->salida) > 0) {
+      return true;
+    }
+  }
+}
+
+/**
+ * Manda al socket de @self todo lo que acepte de su salida pendiente
+ *
+ * Returns: false si hubo un error en el socket
+ */
+bool sesion_escribir(Sesion *self)
+{
+  while (marco_get_len(self->salida) > 0) {
+    ssize_t n = send(self->fd, marco_get_datos(self->salida),
+                     marco_get_len(self->salida), MSG_NOSIGNAL);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN;
+    }
+    marco_descartar(self->salida, n);
+  }
+  return true;
+}
+
+/**
+ * Avanza el juego de @self con una línea que escribió el jugador, igual que
+ * lo haría scanf() en el juego de la terminal, y deja en su salida la
+ * respuesta
+ *
+ * @linea La línea, sin el salto de línea
+ */
+void sesion_procesar_linea(Servidor *servidor,
+                           Sesion   *self,
+                           char     *linea)
+{
+  Categoria *categoria;
+  long opcion;
+  char seleccion;
+
+  linea = sesion_recortar(linea);
+
+  switch (self->estado) {
+  case SESION_INICIO:
+    sesion_imprimir_categorias(servidor, self);
+    break;
+
+  case SESION_CATEGORIA:
+    // Se puede elegir por número o escribiendo el nombre. servidor_nuevo()
+    // ya leyó todas las categorías, así que esto no toca el disco.
+    opcion = sesion_leer_opcion(linea);
+    categoria = opcion > 0 ? recursos_get_categoria(servidor->recursos, opcion - 1)
+                           : recursos_buscar_categoria(servidor->recursos, linea);
+    if (categoria == NULL || categoria_get_n_palabras(categoria) <= 0) {
+      marco_agregar_cadena(self->salida, "Opción inválida!\n");
+      sesion_imprimir_categorias(servidor, self);
+      break;
+    }
+    partida_elegir_palabra_adaptativa(self->partida, categoria);
+    if (partida_get_estado(self->partida) == PARTIDA_EN_CURSO) {
+      sesion_imprimir_tipos(servidor, self);
+    } else if (partida_get_estado(self->partida) == PARTIDA_SIN_PALABRA) {
+      // Solo pasa si no se pudo leer la palabra de una categoría indexada
+      marco_agregar_cadena(self->salida, "No se pudo leer la palabra\n");
+      sesion_imprimir_categorias(servidor, self);
+    } else {
+      sesion_terminar_ronda(servidor, self);
+    }
+    break;
+
+  case SESION_TIPO:
+    opcion = sesion_leer_opcion(linea);
+    if (opcion == 1) {
+      marco_agregar_cadena(self->salida, "Ingrese el caracter: ");
+      self->estado = SESION_CARACTER;
+    } else if (opcion == 2) {
+      marco_agregar_cadena(self->salida, "Ingrese la palabra: ");
+      self->estado = SESION_PALABRA;
+    } else {
+      marco_agregar_cadena(self->salida, "Opción Inválida!\n");
+      sesion_imprimir_tipos(servidor, self);
+    }
+    break;
+
+  case SESION_CARACTER:
+  case SESION_PALABRA:
+    // Como scanf(" %s"), una línea vacía solo hace que se siga esperando
+    if (linea[0] == '\0') {
+      break;
+    }
+    if (self->estado == SESION_CARACTER) {
+      partida_intentar_caracter(self->partida, linea);
+    } else {
+      partida_intentar_palabra(self->partida, linea);
+    }
+    if (partida_get_estado(self->partida) == PARTIDA_EN_CURSO) {
+      sesion_imprimir_tipos(servidor, self);
+    } else {
+      sesion_terminar_ronda(servidor, self);
+    }
+    break;
+
+  case SESION_CONTINUAR:
+    seleccion = char_minuscula(linea[0]);
+    if (seleccion == 's') {
+      sesion_imprimir_categorias(servidor, self);
+    } else if (seleccion == 'n') {
+      marco_agregar_cadena(self->salida, "¡Hasta luego!\n");
+      self->estado = SESION_CERRANDO;
+    } else {
+      marco_agregar_cadena(self->salida,
+                           "Opción inválida!\n"
+                           "¿Desea iniciar una nueva partida? (s/n): ");
+    }
+    break;
+
+  case SESION_CERRANDO:
+  default:
+    break;
+  }
+}
+
+void sesion_imprimir_categorias(Servidor *servidor,
+                                Sesion   *self)
+{
+  size_t n_categorias = recursos_get_n_categorias(servidor->recursos);
+
+  marco_agregar_cadena(self->salida,
+                       "Seleccione la categoría con la que quiera jugar:\n");
+  for (size_t i = 0; i < n_categorias; i++) {
+    Categoria *categoria = recursos_get_categoria(servidor->recursos, i);
+    marco_printf(self->salida, "%zu. %s\n", i + 1,
+                 categoria_get_nombre(categoria));
+  }
+  self->estado = SESION_CATEGORIA;
+}
+
+/**
+ * Manda las vidas y el progreso de la partida de @self, y pregunta qué tipo
+ * de intento sigue
+ */
+void sesion_imprimir_tipos(Servidor *servidor,
+                           Sesion   *self)
+{
+  CategoriaDificultad dificultad = partida_get_dificultad(self->partida);
+
+  // Las palabras que se eligieron entre todas no tienen dificultad
+  if (dificultad != PARTIDA_CUALQUIER_DIFICULTAD) {
+    marco_printf(self->salida, "Dificultad: %s\n\n",
+                 categoria_dificultad_to_string(dificultad));
+  }
+  marco_agregar_cadena(self->salida, "Tus vidas:\n\n");
+  textura_dibujar(recursos_get_vidas(servidor->recursos,
+                                     partida_get_vidas(self->partida)),
+                  self->salida);
+  marco_agregar_cadena(self->salida, "\n\n");
+  palabra_dibujar(partida_get_palabra(self->partida), self->salida);
+  marco_agregar_cadena(self->salida,
+                       "Ingrese el tipo de intento que quiere realizar:\n"
+                       "1. Adivinar Carácter\n"
+                       "2. Adivinar Palabra\n");
+  self->estado = SESION_TIPO;
+}
+
+void sesion_terminar_ronda(Servidor *servidor,
+                           Sesion   *self)
+{
+  marcador_anotar(servidor->marcador, NULL,
+                  categoria_get_nombre(partida_get_categoria(self->partida)),
+                  partida_get_estado(self->partida) == PARTIDA_GANADA,
+                  partida_get_vidas(self->partida));
+
+  if (partida_get_estado(self->partida) == PARTIDA_GANADA) {
+    textura_dibujar(recursos_get_textura(servidor->recursos, RECURSOS_VICTORIA),
+                    self->salida);
+  } else {
+    textura_dibujar(recursos_get_textura(servidor->recursos, RECURSOS_DERROTA),
+                    self->salida);
+    marco_printf(self->salida, "La palabra era: %s\n",
+                 palabra_get_texto(partida_get_palabra(self->partida)));
+  }
+  marco_agregar_cadena(self->salida, "¿Desea iniciar una nueva partida? (s/n): ");
+  self->estado = SESION_CONTINUAR;
+}
+
+/**
+ * Quita los espacios (y el '\r' de los clientes que mandan "\r\n") al
+ * inicio y al final de @linea
+ *
+ * Returns: (transfer: none) El inicio de la línea recortada, dentro de @linea
+ */
+char *sesion_recortar(char *linea)
+{
+  size_t len;
+
+  while (*linea == ' ' || *linea == '\t' || *linea == '\r') {
+    linea++;
+  }
+  len = strlen(linea);
+  while (len > 0 && (linea[len - 1] == ' ' || linea[len - 1] == '\t'
+                     || linea[len - 1] == '\r')) {
+    linea[--len] = '\0';
+  }
+  return linea;
+}
+
+/**
+ * Returns: El número en @linea, o -1 si no es un número
+ */
+long sesion_leer_opcion(const char *linea)
+{
+  char *fin;
+  long opcion;
+
+  errno = 0;
+  opcion = strtol(linea, &fin, 10);
+  if (fin == linea || *fin != '\0' || errno != 0) {
+    return -1;
+  }
+  return opcion;
+}
+
+/**
+ * Cierra las sesiones de @self y libera su epoll. Los hilos ya deben haber
+ * terminado.
+ */
+void trabajador_destruir(Trabajador *self)
+{
+  while (self->sesiones != NULL) {
+    servidor_cerrar_sesion(self->sesiones);
+  }
+  if (self->epoll >= 0) {
+    close(self->epoll);
+  }
+  if (self->reserva >= 0) {
+    close(self->reserva);
+  }
+  pthread_mutex_destroy(&self->candado);
+}
+
+void servidor_destruir(Servidor *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  for (unsigned int i = 0; i < self->n_trabajadores; i++) {
+    trabajador_destruir(&self->trabajadores[i]);
+  }
+  free(self->trabajadores);
+  if (self->despertar >= 0) {
+    close(self->despertar);
+  }
+  if (self->escucha >= 0) {
+    close(self->escucha);
+  }
+  if (self->ruta_unix != NULL) {
+    if (self->escucha >= 0) {
+      unlink(self->ruta_unix);
+    }
+    free(self->ruta_unix);
+  }
+  free(self);
+}
@@ -0,0 +1,41 @@
+/* servidor.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bitacora.h"
+#include "marcador.h"
+#include "recursos.h"
+
+/*
+ * Un servidor atiende muchas partidas a la vez, una por conexión, con varios
+ * hilos que esperan en epoll(7). Cada hilo se queda con las conexiones que
+ * acepta, pero el que no tiene nada que hacer les quita trabajo a los demás,
+ * así que se aprovechan todos los núcleos.
+ *
+ * Cada conexión sigue el mismo camino que el juego en la terminal (menú,
+ * categoría, tipo de intento, intento), pero en texto plano y por líneas,
+ * así que se puede jugar con nc(1) o telnet(1).
+ *
+ * La dirección es un puerto ("4000"), un host y puerto ("127.0.0.1:4000",
+ * "[::1]:4000") o la ruta de un socket Unix (cualquier cosa con una '/').
+ */
+struct __Servidor;
+typedef struct __Servidor Servidor;
+
+Servidor *servidor_nuevo(Recursos *, const char *, unsigned int);
+void servidor_sembrar(Servidor *, uint64_t);
+void servidor_set_bitacora(Servidor *, Bitacora *);
+void servidor_set_marcador(Servidor *, Marcador *);
+bool servidor_ejecutar(Servidor *);
+void servidor_detener(Servidor *);
+void servidor_destruir(Servidor *);
@@ -0,0 +1,713 @@
+/* simulador.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * adivinador-sim: juega sin pantalla muchísimas partidas contra todas las
+ * categorías, con distintas estrategias para adivinar, y reporta qué tan
+ * seguido gana cada una, cuántos intentos le toma y qué tan rápido juega.
+ *
+ * Sirve para medir qué tan difícil es cada lista de palabras y como carga
+ * realista del motor del juego: las partidas usan el mismo Partida que el
+ * juego en la terminal.
+ *
+ * Los resultados se pueden reproducir: cada partida usa una semilla que
+ * solo depende de --seed y de su número, así que no importa cuántos hilos
+ * haya ni en qué orden las jueguen.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "azar.h"
+#include "metricas.h"
+#include "partida.h"
+#include "recursos.h"
+#include "u8.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+#define SIM_PARTIDAS_POR_DEFECTO 100000
+#define SIM_SEMILLA_POR_DEFECTO 1
+
+/* Cuántas partidas toma un hilo cada vez que se le acaban */
+#define SIM_BLOQUE 256
+
+/*
+ * Las estrategias solo prueban letras con llave menor a esta; cubre ASCII,
+ * Latin-1 y Latin Extended-A, que es donde viven todas las letras de las
+ * listas
+ */
+#define SIM_CLAVES 0x180
+
+/**
+ * Las palabras de una categoría ya decodificadas y plegadas, para las
+ * estrategias que razonan sobre la lista completa. Se arma una vez antes de
+ * empezar y todos los hilos la leen sin candados.
+ *
+ * Las llaves de la palabra @i son las que van de @inicios[i] a
+ * @inicios[i + 1] en @claves.
+ */
+typedef struct {
+  Categoria *categoria;
+  size_t n_palabras;
+  uint32_t *claves;
+  size_t *inicios;
+  size_t max_len;
+} SimCategoria;
+
+/**
+ * Lo que lleva un hilo para jugar: su partida, que se reutiliza en todas
+ * las partidas que juega, y lo que cada estrategia necesita recordar dentro
+ * de una partida.
+ *
+ * @probada dice qué llaves ya se intentaron en la partida actual.
+ * @candidatas son los índices de las palabras de la categoría que todavía
+ * coinciden con lo que se ve; @conteo y @visto son espacio para contar
+ * letras entre ellas. @texto es espacio para escribir una palabra completa.
+ */
+typedef struct {
+  Partida *partida;
+  SimCategoria *categoria;
+  Azar azar;
+  size_t intentos;
+
+  bool probada[SIM_CLAVES];
+  uint32_t *candidatas;
+  size_t n_candidatas;
+  uint32_t conteo[SIM_CLAVES];
+  uint32_t visto[SIM_CLAVES];
+  char *texto;
+} Jugador;
+
+/**
+ * Una manera de jugar. @empezar se llama al elegir la palabra (puede ser
+ * NULL) e @intentar hace exactamente un intento en la partida del jugador,
+ * con jugador_intentar_letra() o jugador_intentar_palabra().
+ *
+ * Para agregar una estrategia basta con escribir sus funciones y agregarla
+ * a @estrategias.
+ */
+typedef struct {
+  const char *nombre;
+  const char *descripcion;
+  void (*empezar)(Jugador *);
+  void (*intentar)(Jugador *);
+} Estrategia;
+
+/* Lo que se acumula de las partidas de una estrategia en una categoría */
+typedef struct {
+  uint64_t partidas;
+  uint64_t ganadas;
+  uint64_t intentos;
+  uint64_t vidas_perdidas;
+} SimResultado;
+
+/**
+ * Todo lo de una simulación. Las partidas se numeran de 0 a @n_total; la
+ * partida @n es la número @n % @n_partidas de la combinación @n /
+ * @n_partidas de estrategia y categoría. Con una @dificultad (o -1 para
+ * cualquiera), las palabras se eligen solo entre las de esa dificultad. Los
+ * hilos toman bloques de
+ * partidas de @siguiente y acumulan en sus propios @resultados, que se
+ * suman al final.
+ */
+typedef struct {
+  SimCategoria *categorias;
+  size_t n_categorias;
+  const Estrategia **estrategias;
+  size_t n_estrategias;
+  uint64_t n_partidas;
+  uint64_t n_total;
+  uint64_t semilla;
+  int dificultad;
+  atomic_uint_fast64_t siguiente;
+} Simulacion;
+
+typedef struct {
+  Simulacion *simulacion;
+  pthread_t hilo;
+  SimResultado *resultados;
+} SimHilo;
+
+void sim_categoria_preparar(SimCategoria *, Categoria *);
+void sim_categoria_liberar(SimCategoria *);
+void *sim_trabajar(void *);
+void sim_jugar(Simulacion *, Jugador *, uint64_t, SimResultado *);
+void sim_imprimir(Simulacion *, SimResultado *, double);
+double sim_ahora(void);
+
+uint32_t jugador_siguiente_libre(Jugador *);
+void jugador_intentar_letra(Jugador *, uint32_t);
+void jugador_intentar_palabra(Jugador *, size_t);
+void jugador_intentar_alfabeto(Jugador *, const char *);
+
+void estrategia_aleatoria(Jugador *);
+void estrategia_frecuencia(Jugador *);
+void estrategia_diccionario_empezar(Jugador *);
+void estrategia_diccionario(Jugador *);
+
+const Estrategia estrategias[] = {
+  {
+    "aleatoria",
+    "Letras del alfabeto al azar",
+    NULL,
+    estrategia_aleatoria,
+  },
+  {
+    "frecuencia",
+    "Letras en orden de frecuencia en español",
+    NULL,
+    estrategia_frecuencia,
+  },
+  {
+    "diccionario",
+    "Descarta las palabras de la categoría que ya no coinciden y prueba la "
+    "letra más común entre las que quedan",
+    estrategia_diccionario_empezar,
+    estrategia_diccionario,
+  },
+};
+#define N_ESTRATEGIAS (sizeof(estrategias) / sizeof(estrategias[0]))
+
+/* Los nombres de las dificultades para --difficulty, sin acentos */
+const char *const dificultades[CATEGORIA_N_DIFICULTADES] = {
+  "facil",
+  "media",
+  "dificil",
+};
+
+/* Las letras del español, en el orden de frecuencia que usa "frecuencia" */
+#define ALFABETO "eaosrnidlctumpbgvyqhfzjñxkw"
+
+int main(int argc,
+         char **argv)
+{
+  Simulacion simulacion = { 0 };
+  const Estrategia *elegidas[N_ESTRATEGIAS];
+  Recursos *recursos;
+  SimHilo *hilos;
+  SimResultado *total;
+  long n_hilos = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t n_resultados;
+  double inicio, duracion;
+
+  simulacion.n_partidas = SIM_PARTIDAS_POR_DEFECTO;
+  simulacion.semilla = SIM_SEMILLA_POR_DEFECTO;
+  simulacion.dificultad = -1;
+  simulacion.estrategias = elegidas;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+      simulacion.n_partidas = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      n_hilos = strtol(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      simulacion.semilla = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--strategy") == 0 && i + 1 < argc) {
+      const char *nombre = argv[++i];
+      size_t e;
+
+      for (e = 0; e < N_ESTRATEGIAS; e++) {
+        if (strcmp(estrategias[e].nombre, nombre) == 0) {
+          break;
+        }
+      }
+      if (e == N_ESTRATEGIAS) {
+        fprintf(stderr, "Estrategia desconocida: %s\n", nombre);
+        return EXIT_FAILURE;
+      }
+      if (simulacion.n_estrategias < N_ESTRATEGIAS) {
+        elegidas[simulacion.n_estrategias++] = &estrategias[e];
+      }
+    } else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) {
+      const char *nombre = argv[++i];
+
+      for (simulacion.dificultad = 0;
+           simulacion.dificultad < CATEGORIA_N_DIFICULTADES;
+           simulacion.dificultad++) {
+        if (strcmp(dificultades[simulacion.dificultad], nombre) == 0) {
+          break;
+        }
+      }
+      if (simulacion.dificultad == CATEGORIA_N_DIFICULTADES) {
+        fprintf(stderr, "Dificultad desconocida: %s\n", nombre);
+        return EXIT_FAILURE;
+      }
+    } else {
+      fprintf(stderr,
+              "Uso: %s [--games N] [--threads N] [--seed N] [--strategy NOMBRE]...\n"
+              "       [--difficulty facil|media|dificil]\n"
+              "\nEstrategias:\n", argv[0]);
+      for (size_t e = 0; e < N_ESTRATEGIAS; e++) {
+        fprintf(stderr, "  %-12s %s\n", estrategias[e].nombre,
+                estrategias[e].descripcion);
+      }
+      return EXIT_FAILURE;
+    }
+  }
+  if (simulacion.n_estrategias == 0) {
+    for (size_t e = 0; e < N_ESTRATEGIAS; e++) {
+      elegidas[simulacion.n_estrategias++] = &estrategias[e];
+    }
+  }
+  if (n_hilos < 1) {
+    n_hilos = 1;
+  }
+
+  // Con ADIVINADOR_METRICAS o ADIVINADOR_TRAZA
+  metricas_iniciar(NULL, NULL);
+
+  recursos = recursos_cargar();
+  simulacion.n_categorias = recursos_get_n_categorias(recursos);
+  simulacion.categorias = calloc(simulacion.n_categorias, sizeof(SimCategoria));
+  for (size_t c = 0; c < simulacion.n_categorias; c++) {
+    sim_categoria_preparar(&simulacion.categorias[c],
+                           recursos_get_categoria(recursos, c));
+  }
+  simulacion.n_total = simulacion.n_partidas * simulacion.n_estrategias
+                       * simulacion.n_categorias;
+
+  n_resultados = simulacion.n_estrategias * simulacion.n_categorias;
+  hilos = calloc(n_hilos, sizeof(SimHilo));
+  inicio = sim_ahora();
+  for (long h = 0; h < n_hilos; h++) {
+    hilos[h].simulacion = &simulacion;
+    hilos[h].resultados = calloc(n_resultados, sizeof(SimResultado));
+    if (pthread_create(&hilos[h].hilo, NULL, sim_trabajar, &hilos[h]) != 0) {
+      fprintf(stderr, "No se pudo crear el hilo %ld\n", h);
+      return EXIT_FAILURE;
+    }
+  }
+
+  total = calloc(n_resultados, sizeof(SimResultado));
+  for (long h = 0; h < n_hilos; h++) {
+    pthread_join(hilos[h].hilo, NULL);
+    for (size_t r = 0; r < n_resultados; r++) {
+      total[r].partidas += hilos[h].resultados[r].partidas;
+      total[r].ganadas += hilos[h].resultados[r].ganadas;
+      total[r].intentos += hilos[h].resultados[r].intentos;
+      total[r].vidas_perdidas += hilos[h].resultados[r].vidas_perdidas;
+    }
+    free(hilos[h].resultados);
+  }
+  duracion = sim_ahora() - inicio;
+
+  printf("Semilla %llu, %llu partidas por estrategia y categoría, %ld hilos",
+         (unsigned long long) simulacion.semilla,
+         (unsigned long long) simulacion.n_partidas, n_hilos);
+  if (simulacion.dificultad >= 0) {
+    printf(", palabras de dificultad %s",
+           categoria_dificultad_to_string(simulacion.dificultad));
+  }
+  printf("\n\n");
+  sim_imprimir(&simulacion, total, duracion);
+
+  free(total);
+  free(hilos);
+  for (size_t c = 0; c < simulacion.n_categorias; c++) {
+    sim_categoria_liberar(&simulacion.categorias[c]);
+  }
+  free(simulacion.categorias);
+  recursos_destruir(recursos);
+
+  metricas_finalizar();
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Decodifica y pliega una sola vez todas las palabras de @categoria. Si la
+ * categoría está indexada, cada palabra se lee del archivo a @arena.
+ */
+void sim_categoria_preparar(SimCategoria *self,
+                            Categoria    *categoria)
+{
+  size_t n_claves = 0;
+  Arena *arena = arena_nueva(4096);
+
+  self->categoria = categoria;
+  self->n_palabras = categoria_get_n_palabras(categoria);
+  self->inicios = malloc((self->n_palabras + 1) * sizeof(size_t));
+
+  // Una palabra nunca tiene más caracteres que bytes
+  for (size_t i = 0; i < self->n_palabras; i++) {
+    size_t len = categoria_get_longitud_palabra(categoria, i);
+
+    n_claves += len;
+    if (len > self->max_len) {
+      self->max_len = len;
+    }
+  }
+  self->claves = malloc((n_claves + 1) * sizeof(uint32_t));
+
+  self->inicios[0] = 0;
+  for (size_t i = 0; i < self->n_palabras; i++) {
+    uint32_t *claves = &self->claves[self->inicios[i]];
+    const char *palabra = categoria_leer_palabra(categoria, i, arena);
+    size_t n = 0;
+
+    if (palabra != NULL) {
+      n = u8_decodificar_cadena(palabra,
+                                categoria_get_longitud_palabra(categoria, i),
+                                claves, NULL);
+    }
+    for (size_t j = 0; j < n; j++) {
+      claves[j] = u8_plegar(claves[j]);
+    }
+    self->inicios[i + 1] = self->inicios[i] + n;
+    arena_reiniciar(arena);
+  }
+  arena_destruir(arena);
+}
+
+void sim_categoria_liberar(SimCategoria *self)
+{
+  free(self->claves);
+  free(self->inicios);
+}
+
+double sim_ahora(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * Lo que hace cada hilo: toma bloques de partidas hasta que se acaban
+ *
+ * @datos El SimHilo
+ */
+void *sim_trabajar(void *datos)
+{
+  SimHilo *self = datos;
+  Simulacion *simulacion = self->simulacion;
+  Jugador *jugador;
+  size_t max_palabras = 0, max_len = 0;
+
+  for (size_t c = 0; c < simulacion->n_categorias; c++) {
+    if (simulacion->categorias[c].n_palabras > max_palabras) {
+      max_palabras = simulacion->categorias[c].n_palabras;
+    }
+    if (simulacion->categorias[c].max_len > max_len) {
+      max_len = simulacion->categorias[c].max_len;
+    }
+  }
+
+  jugador = calloc(1, sizeof(Jugador));
+  jugador->partida = partida_nueva();
+  jugador->candidatas = malloc((max_palabras + 1) * sizeof(uint32_t));
+  // Una palabra tiene a lo más max_len llaves, de hasta 4 bytes cada una
+  jugador->texto = malloc(4 * max_len + 1);
+
+  for (;;) {
+    uint64_t inicio = atomic_fetch_add(&simulacion->siguiente, SIM_BLOQUE);
+    uint64_t fin = inicio + SIM_BLOQUE;
+
+    if (inicio >= simulacion->n_total) {
+      break;
+    }
+    if (fin > simulacion->n_total) {
+      fin = simulacion->n_total;
+    }
+    for (uint64_t n = inicio; n < fin; n++) {
+      sim_jugar(simulacion, jugador, n, self->resultados);
+    }
+  }
+
+  partida_destruir(jugador->partida);
+  free(jugador->candidatas);
+  free(jugador->texto);
+  free(jugador);
+  return NULL;
+}
+
+/**
+ * Juega la partida número @n de @simulacion de principio a fin y la suma a
+ * @resultados
+ */
+void sim_jugar(Simulacion   *simulacion,
+               Jugador      *jugador,
+               uint64_t      n,
+               SimResultado *resultados)
+{
+  size_t combinacion = n / simulacion->n_partidas;
+  size_t e = combinacion / simulacion->n_categorias;
+  size_t c = combinacion % simulacion->n_categorias;
+  const Estrategia *estrategia = simulacion->estrategias[e];
+  SimResultado *resultado = &resultados[combinacion];
+  Categoria *categoria = simulacion->categorias[c].categoria;
+  int n_palabras = 0;
+  size_t indice;
+
+  jugador->categoria = &simulacion->categorias[c];
+  if (jugador->categoria->n_palabras == 0) {
+    return;
+  }
+  azar_sembrar(&jugador->azar, azar_mezclar(simulacion->semilla, n));
+  jugador->intentos = 0;
+  memset(jugador->probada, 0, sizeof(jugador->probada));
+
+  if (simulacion->dificultad >= 0) {
+    n_palabras = categoria_get_n_palabras_dificultad(categoria,
+                                                     simulacion->dificultad);
+  }
+  if (n_palabras > 0) {
+    indice = categoria_get_palabra_dificultad(categoria, simulacion->dificultad,
+                                              azar_acotado(&jugador->azar,
+                                                           n_palabras));
+  } else {
+    indice = azar_acotado(&jugador->azar, jugador->categoria->n_palabras);
+  }
+  partida_elegir_palabra_indice(jugador->partida, categoria, indice);
+  if (estrategia->empezar != NULL) {
+    estrategia->empezar(jugador);
+  }
+  while (partida_get_estado(jugador->partida) == PARTIDA_EN_CURSO) {
+    estrategia->intentar(jugador);
+  }
+
+  resultado->partidas++;
+  resultado->ganadas += partida_get_estado(jugador->partida) == PARTIDA_GANADA;
+  resultado->intentos += jugador->intentos;
+  resultado->vidas_perdidas += PARTIDA_VIDAS - partida_get_vidas(jugador->partida);
+}
+
+void sim_imprimir(Simulacion   *simulacion,
+                  SimResultado *resultados,
+                  double        duracion)
+{
+  uint64_t partidas = 0, intentos = 0;
+
+  printf("%-12s %-20s %10s %8s %10s %10s\n", "estrategia", "categoría",
+         "partidas", "ganadas", "intentos", "vidas");
+  for (size_t e = 0; e < simulacion->n_estrategias; e++) {
+    for (size_t c = 0; c < simulacion->n_categorias; c++) {
+      SimResultado *r = &resultados[e * simulacion->n_categorias + c];
+      double n = r->partidas > 0 ? r->partidas : 1;
+
+      printf("%-12s %-20s %10llu %7.2f%% %10.2f %10.2f\n",
+             simulacion->estrategias[e]->nombre,
+             categoria_get_nombre(simulacion->categorias[c].categoria),
+             (unsigned long long) r->partidas, 100.0 * r->ganadas / n,
+             r->intentos / n, r->vidas_perdidas / n);
+      partidas += r->partidas;
+      intentos += r->intentos;
+    }
+  }
+
+  printf("\n%llu partidas y %llu intentos en %.3f s: %.0f partidas/s, "
+         "%.0f intentos/s\n",
+         (unsigned long long) partidas, (unsigned long long) intentos,
+         duracion, partidas / duracion, intentos / duracion);
+}
+
+/**
+ * La primera llave que no se ha intentado, para cuando una estrategia ya no
+ * tiene qué probar (por ejemplo, si la palabra tiene un guión). Cada llave
+ * se intenta una sola vez, así que la partida siempre termina.
+ *
+ * Returns: Una llave sin intentar, o 0 si ya se intentaron todas
+ */
+uint32_t jugador_siguiente_libre(Jugador *self)
+{
+  for (uint32_t clave = '!'; clave < SIM_CLAVES; clave++) {
+    if (!self->probada[clave] && u8_plegar(clave) == clave) {
+      return clave;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Intenta la letra con llave @clave en la partida de @self
+ */
+void jugador_intentar_letra(Jugador  *self,
+                            uint32_t  clave)
+{
+  char letra[5];
+
+  if (clave == 0) {
+    // Ya no queda nada que probar: nos rendimos con una palabra vacía
+    partida_intentar_palabra(self->partida, "");
+    self->intentos++;
+    return;
+  }
+  if (clave < SIM_CLAVES) {
+    self->probada[clave] = true;
+  }
+  letra[u8_codificar(clave, letra)] = '\0';
+  partida_intentar_caracter(self->partida, letra);
+  self->intentos++;
+}
+
+/**
+ * Intenta adivinar que la palabra es la número @indice de la categoría. La
+ * escribimos a partir de sus llaves: ya están plegadas, pero la palabra se
+ * compara sin importar mayúsculas ni acentos.
+ */
+void jugador_intentar_palabra(Jugador *self,
+                              size_t   indice)
+{
+  SimCategoria *categoria = self->categoria;
+  size_t len = 0;
+
+  for (size_t i = categoria->inicios[indice]; i < categoria->inicios[indice + 1];
+       i++) {
+    len += u8_codificar(categoria->claves[i], &self->texto[len]);
+  }
+  self->texto[len] = '\0';
+  partida_intentar_palabra(self->partida, self->texto);
+  self->intentos++;
+}
+
+/**
+ * Intenta la primera letra de @alfabeto (en UTF-8) que no se ha intentado
+ */
+void jugador_intentar_alfabeto(Jugador    *self,
+                               const char *alfabeto)
+{
+  size_t len = strlen(alfabeto);
+
+  for (size_t i = 0; i < len;) {
+    size_t consumidos;
+    uint32_t clave = u8_decodificar(&alfabeto[i], len - i, &consumidos);
+
+    if (!self->probada[clave]) {
+      jugador_intentar_letra(self, clave);
+      return;
+    }
+    i += consumidos;
+  }
+  jugador_intentar_letra(self, jugador_siguiente_libre(self));
+}
+
+void estrategia_aleatoria(Jugador *self)
+{
+  uint32_t libres[sizeof(ALFABETO)];
+  size_t n_libres = 0, len = strlen(ALFABETO);
+
+  for (size_t i = 0; i < len;) {
+    size_t consumidos;
+    uint32_t clave = u8_decodificar(&ALFABETO[i], len - i, &consumidos);
+
+    if (!self->probada[clave]) {
+      libres[n_libres++] = clave;
+    }
+    i += consumidos;
+  }
+
+  if (n_libres == 0) {
+    jugador_intentar_letra(self, jugador_siguiente_libre(self));
+    return;
+  }
+  jugador_intentar_letra(self, libres[azar_acotado(&self->azar, n_libres)]);
+}
+
+void estrategia_frecuencia(Jugador *self)
+{
+  jugador_intentar_alfabeto(self, ALFABETO);
+}
+
+/**
+ * Al empezar, las candidatas son todas las palabras de la categoría con el
+ * mismo número de caracteres, que es lo único que se ve
+ */
+void estrategia_diccionario_empezar(Jugador *self)
+{
+  SimCategoria *categoria = self->categoria;
+  size_t n_caracteres = palabra_get_n_caracteres(partida_get_palabra(self->partida));
+
+  self->n_candidatas = 0;
+  for (size_t i = 0; i < categoria->n_palabras; i++) {
+    if (categoria->inicios[i + 1] - categoria->inicios[i] == n_caracteres) {
+      self->candidatas[self->n_candidatas++] = i;
+    }
+  }
+}
+
+void estrategia_diccionario(Jugador *self)
+{
+  SimCategoria *categoria = self->categoria;
+  Palabra *palabra = partida_get_palabra(self->partida);
+  size_t n_caracteres = palabra_get_n_caracteres(palabra);
+  size_t n = 0;
+  uint32_t mejor = 0;
+
+  /*
+   * Una candidata sigue en pie si coincide en todo lo que ya se ve y no
+   * tiene ninguna letra ya intentada donde todavía hay un guión (si la
+   * tuviera, ya se habría revelado)
+   */
+  for (size_t i = 0; i < self->n_candidatas; i++) {
+    const uint32_t *claves = &categoria->claves[categoria->inicios[self->candidatas[i]]];
+    bool coincide = true;
+
+    for (size_t j = 0; j < n_caracteres && coincide; j++) {
+      uint32_t visible = palabra_get_clave_visible(palabra, j);
+
+      if (visible != 0) {
+        coincide = claves[j] == visible;
+      } else {
+        coincide = claves[j] >= SIM_CLAVES || !self->probada[claves[j]];
+      }
+    }
+    if (coincide) {
+      self->candidatas[n++] = self->candidatas[i];
+    }
+  }
+  self->n_candidatas = n;
+
+  if (self->n_candidatas == 0) {
+    estrategia_frecuencia(self);
+    return;
+  }
+  if (self->n_candidatas == 1) {
+    jugador_intentar_palabra(self, self->candidatas[0]);
+    self->n_candidatas = 0;
+    return;
+  }
+
+  // La letra sin intentar que aparece en más candidatas
+  memset(self->conteo, 0, sizeof(self->conteo));
+  for (size_t i = 0; i < self->n_candidatas; i++) {
+    size_t inicio = categoria->inicios[self->candidatas[i]];
+
+    for (size_t j = 0; j < n_caracteres; j++) {
+      uint32_t clave = categoria->claves[inicio + j];
+
+      if (clave >= SIM_CLAVES || clave == ' ' || self->probada[clave]
+          || self->visto[clave] == i + 1) {
+        continue;
+      }
+      self->visto[clave] = i + 1;
+      if (++self->conteo[clave] > self->conteo[mejor]) {
+        mejor = clave;
+      }
+    }
+  }
+  memset(self->visto, 0, sizeof(self->visto));
+
+  // Ya no hay letras que las distingan: probamos una y, si no era, la quitamos
+  if (mejor == 0) {
+    jugador_intentar_palabra(self, self->candidatas[0]);
+    self->candidatas[0] = self->candidatas[--self->n_candidatas];
+    return;
+  }
+  jugador_intentar_letra(self, mejor);
+}
@@ -0,0 +1,329 @@
+/* teclado.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "teclado.h"
+#include "u8.h"
+
+/* Las teclas que manda la terminal como bytes de control */
+#define TECLADO_CTRL_C 0x03
+#define TECLADO_CTRL_D 0x04
+#define TECLADO_ESC 0x1B
+#define TECLADO_DEL 0x7F
+
+/*
+ * Las señales que terminan el programa sin pasar por teclado_destruir(). Con
+ * la terminal en modo crudo no llegan del teclado, pero sí de kill(1) o de
+ * cerrar la terminal.
+ */
+const int teclado_senales[] = { SIGHUP, SIGINT, SIGTERM };
+#define TECLADO_N_SENALES (sizeof(teclado_senales) / sizeof(teclado_senales[0]))
+
+/**
+ * Lo que llega de @fd se junta en @buffer, de @inicio a @fin, y se lee de
+ * ahí tecla por tecla: un solo read(2) trae todos los bytes de un carácter
+ * o de una secuencia de escape, o varias líneas si la entrada es un archivo.
+ *
+ * Si @fd es una terminal, mientras exista el Teclado queda en modo crudo
+ * (@crudo) y se restaura con @original al destruirlo, o si llega una de
+ * teclado_senales antes; @anteriores son las acciones que esas señales
+ * tenían. La terminal ya no muestra lo que se escribe, así que
+ * teclado_leer_linea() lo muestra.
+ */
+struct __Teclado {
+  int fd;
+  bool crudo;
+  struct termios original;
+  struct sigaction anteriores[TECLADO_N_SENALES];
+
+  unsigned char buffer[64];
+  size_t inicio;
+  size_t fin;
+};
+
+/* El teclado que dejó la terminal en modo crudo, para teclado_restaurar() */
+Teclado *teclado_crudo;
+
+void teclado_atrapar_senales(Teclado *);
+void teclado_restaurar(int);
+bool teclado_llenar(Teclado *, size_t);
+uint32_t teclado_leer_escape(Teclado *);
+void teclado_eco(Teclado *, const char *, size_t);
+
+/**
+ * Crea un teclado que lee de @fd, y lo pone en modo crudo si es una
+ * terminal
+ *
+ * Returns: (transfer: full) El teclado nuevo
+ */
+Teclado *teclado_nuevo(int fd)
+{
+  Teclado *self = calloc(1, sizeof(Teclado));
+  struct termios crudo;
+
+  self->fd = fd;
+  if (isatty(fd) && tcgetattr(fd, &self->original) == 0) {
+    crudo = self->original;
+    // Sin ISIG, Ctrl-C llega como una tecla más y el juego termina
+    // normalmente, restaurando la terminal
+    crudo.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    crudo.c_cc[VMIN] = 1;
+    crudo.c_cc[VTIME] = 0;
+    self->crudo = tcsetattr(fd, TCSAFLUSH, &crudo) == 0;
+  }
+  if (self->crudo) {
+    teclado_atrapar_senales(self);
+  }
+
+  return self;
+}
+
+/**
+ * Hace que las señales que terminarían el programa restauren antes la
+ * terminal, para no dejarla sin eco. Las que ya tenían otra acción (por
+ * ejemplo, SIGHUP ignorada con nohup) se quedan como estaban.
+ */
+void teclado_atrapar_senales(Teclado *self)
+{
+  struct sigaction accion = { .sa_handler = teclado_restaurar };
+
+  sigemptyset(&accion.sa_mask);
+  teclado_crudo = self;
+  for (size_t i = 0; i < TECLADO_N_SENALES; i++) {
+    sigaction(teclado_senales[i], NULL, &self->anteriores[i]);
+    if (self->anteriores[i].sa_handler == SIG_DFL) {
+      sigaction(teclado_senales[i], &accion, NULL);
+    }
+  }
+}
+
+/**
+ * Restaura la terminal y vuelve a mandar @senal con su acción por omisión,
+ * que termina el programa
+ */
+void teclado_restaurar(int senal)
+{
+  Teclado *self = teclado_crudo;
+
+  if (self != NULL) {
+    tcsetattr(self->fd, TCSANOW, &self->original);
+  }
+  signal(senal, SIG_DFL);
+  raise(senal);
+}
+
+/**
+ * Se asegura de que haya al menos @n bytes en el buffer, esperando lo que
+ * falte. Antes vaciamos stdout, para que se vea la pregunta que se está
+ * contestando.
+ *
+ * Returns: false si la entrada se acabó antes
+ */
+bool teclado_llenar(Teclado *self,
+                    size_t   n)
+{
+  ssize_t leidos;
+
+  if (self->fin - self->inicio >= n) {
+    return true;
+  }
+
+  memmove(self->buffer, &self->buffer[self->inicio], self->fin - self->inicio);
+  self->fin -= self->inicio;
+  self->inicio = 0;
+
+  fflush(stdout);
+  while (self->fin < n) {
+    leidos = read(self->fd, &self->buffer[self->fin],
+                  sizeof(self->buffer) - self->fin);
+    if (leidos == -1 && errno == EINTR) {
+      continue;
+    }
+    if (leidos <= 0) {
+      return false;
+    }
+    self->fin += leidos;
+  }
+  return true;
+}
+
+/**
+ * Espera la siguiente tecla
+ *
+ * Returns: El carácter de la tecla, '\n' para ENTER, o TECLADO_FIN,
+ * TECLADO_ESCAPE, TECLADO_BORRAR o TECLADO_OTRA
+ */
+uint32_t teclado_leer(Teclado *self)
+{
+  unsigned char c;
+  size_t n, consumidos;
+  uint32_t codigo;
+
+  if (self == NULL || !teclado_llenar(self, 1)) {
+    return TECLADO_FIN;
+  }
+
+  c = self->buffer[self->inicio];
+  if (c < 0x80) {
+    self->inicio++;
+    switch (c) {
+    case '\n':
+      return '\n';
+    case TECLADO_CTRL_C:
+    case TECLADO_CTRL_D:
+      return TECLADO_FIN;
+    case TECLADO_ESC:
+      return teclado_leer_escape(self);
+    case TECLADO_DEL:
+    case '\b':
+      return TECLADO_BORRAR;
+    default:
+      // El '\r' de los archivos con "\r\n" y los demás controles
+      return c < 0x20 ? TECLADO_OTRA : c;
+    }
+  }
+
+  // El primer byte dice cuántos trae el carácter
+  if ((c & 0xE0) == 0xC0) {
+    n = 2;
+  } else if ((c & 0xF0) == 0xE0) {
+    n = 3;
+  } else if ((c & 0xF8) == 0xF0) {
+    n = 4;
+  } else {
+    self->inicio++;
+    return TECLADO_OTRA;
+  }
+  if (!teclado_llenar(self, n)) {
+    self->inicio = self->fin;
+    return TECLADO_OTRA;
+  }
+
+  codigo = u8_decodificar((const char *) &self->buffer[self->inicio], n,
+                          &consumidos);
+  self->inicio += consumidos;
+  return codigo != U8_INVALIDO ? codigo : TECLADO_OTRA;
+}
+
+/**
+ * Después de un ESC: las flechas y teclas de función llegan como ESC [ o
+ * ESC O seguido de la secuencia, todo en el mismo read(2), así que solo
+ * revisamos lo que ya está en el buffer. Si no viene nada, es la tecla ESC.
+ */
+uint32_t teclado_leer_escape(Teclado *self)
+{
+  if (self->inicio == self->fin
+      || (self->buffer[self->inicio] != '[' && self->buffer[self->inicio] != 'O')) {
+    return TECLADO_ESCAPE;
+  }
+
+  // Parámetros e intermedios, y luego el byte final
+  self->inicio++;
+  while (self->inicio < self->fin
+         && self->buffer[self->inicio] >= 0x20 && self->buffer[self->inicio] < 0x40) {
+    self->inicio++;
+  }
+  if (self->inicio < self->fin
+      && self->buffer[self->inicio] >= 0x40 && self->buffer[self->inicio] < 0x7F) {
+    self->inicio++;
+  }
+  return TECLADO_OTRA;
+}
+
+/**
+ * Lee una línea hasta ENTER, mostrándola mientras se escribe y dejando
+ * borrar. ESC la cancela.
+ *
+ * @linea (out) La línea, sin el salto; vacía si se canceló
+ * @size El tamaño de @linea; lo que no quepa se ignora
+ *
+ * Returns: false si la entrada se acabó
+ */
+bool teclado_leer_linea(Teclado *self,
+                        char    *linea,
+                        size_t   size)
+{
+  size_t len = 0, n;
+  uint32_t tecla;
+  char u8[4];
+
+  for (;;) {
+    tecla = teclado_leer(self);
+    if (tecla == TECLADO_FIN) {
+      linea[0] = '\0';
+      return false;
+    }
+    if (tecla == '\n') {
+      break;
+    }
+    if (tecla == TECLADO_ESCAPE) {
+      len = 0;
+      break;
+    }
+    if (tecla == TECLADO_BORRAR) {
+      if (len > 0) {
+        // Quitamos el carácter completo, no solo su último byte
+        do {
+          len--;
+        } while (len > 0 && PARTE_U8(linea[len]));
+        teclado_eco(self, "\b \b", 3);
+      }
+      continue;
+    }
+    if (tecla == TECLADO_OTRA) {
+      continue;
+    }
+
+    n = u8_codificar(tecla, u8);
+    if (len + n < size) {
+      memcpy(&linea[len], u8, n);
+      len += n;
+      teclado_eco(self, u8, n);
+    }
+  }
+
+  linea[len] = '\0';
+  teclado_eco(self, "\n", 1);
+  return true;
+}
+
+/**
+ * En modo crudo la terminal no muestra lo que se escribe; lo mostramos
+ * nosotros
+ */
+void teclado_eco(Teclado    *self,
+                 const char *texto,
+                 size_t      len)
+{
+  if (self->crudo) {
+    fwrite(texto, 1, len, stdout);
+  }
+}
+
+void teclado_destruir(Teclado *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  if (self->crudo) {
+    for (size_t i = 0; i < TECLADO_N_SENALES; i++) {
+      sigaction(teclado_senales[i], &self->anteriores[i], NULL);
+    }
+    teclado_crudo = NULL;
+    tcsetattr(self->fd, TCSADRAIN, &self->original);
+  }
+  free(self);
+}
@@ -0,0 +1,35 @@
+/* teclado.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Lee la terminal tecla por tecla, sin esperar ENTER ni mostrar lo que se
+ * escribe, y junta los bytes de cada carácter de UTF-8. Si la entrada no es
+ * una terminal (un archivo, una tubería) se lee igual, byte por byte.
+ *
+ * teclado_leer() regresa el carácter de la tecla, '\n' para ENTER, o alguna
+ * de estas teclas, que quedan fuera de Unicode:
+ */
+#define TECLADO_FIN 0x110000      /* Se acabó la entrada, Ctrl-C o Ctrl-D */
+#define TECLADO_ESCAPE 0x110001
+#define TECLADO_BORRAR 0x110002
+#define TECLADO_OTRA 0x110003     /* Flechas, teclas de función, etc. */
+
+struct __Teclado;
+typedef struct __Teclado Teclado;
+
+Teclado *teclado_nuevo(int);
+uint32_t teclado_leer(Teclado *);
+bool teclado_leer_linea(Teclado *, char *, size_t);
+void teclado_destruir(Teclado *);
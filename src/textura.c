@@ -0,0 +1,350 @@
+/* textura.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "textura.h"
+
+
+#define BUFFER_DEFAULT 20
+
+/**
+ * Una textura es una estructura que representa a una imagen creada a partir de
+ * caracteres ASCII
+ *
+ * Todas las lineas viven juntas en @datos, una después de otra. Cada linea
+ * ocupa @rowstride bytes, rellenados con espacios, seguidos de un salto de
+ * linea; así dibujar la textura completa es copiar @datos tal cual. En
+ * @longitudes guardamos cuánto mide cada linea sin el relleno.
+ *
+ * Si @en_arena es true, la textura completa vive en una arena y no se libera.
+ */
+struct __Textura {
+  size_t rowstride;
+  size_t altura;
+  char   *datos;
+  size_t *longitudes;
+  bool   en_arena;
+};
+
+Textura *textura_construir(size_t, size_t, Arena *);
+void textura_copiar_linea(Textura *, size_t, const char *, size_t);
+void textura_dibujar_linea_unsafe(Textura *, size_t, Marco *);
+
+/**
+ * Aloja una textura de @altura lineas de @rowstride bytes, con todas sus
+ * lineas en blanco
+ *
+ * @arena (nullable) Una arena donde alojar la textura, o NULL para usar malloc
+ */
+Textura *textura_construir(size_t  rowstride,
+                           size_t  altura,
+                           Arena  *arena)
+{
+  Textura *self;
+  size_t datos_size = (rowstride + 1) * altura;
+
+  if (arena != NULL) {
+    self = arena_alojar(arena, sizeof(Textura));
+    self->datos = arena_alojar(arena, datos_size);
+    self->longitudes = arena_alojar0(arena, altura * sizeof(size_t));
+  } else {
+    self = malloc(sizeof(Textura));
+    self->datos = malloc(datos_size);
+    self->longitudes = calloc(altura, sizeof(size_t));
+  }
+  self->rowstride = rowstride;
+  self->altura = altura;
+  self->en_arena = arena != NULL;
+
+  memset(self->datos, ' ', datos_size);
+  for (size_t i = 0; i < altura; i++) {
+    self->datos[i * (rowstride + 1) + rowstride] = '\n';
+  }
+
+  return self;
+}
+
+/**
+ * Copia @len bytes de @linea a la linea @indice de @self. @len no puede ser
+ * mayor al rowstride.
+ */
+void textura_copiar_linea(Textura    *self,
+                          size_t      indice,
+                          const char *linea,
+                          size_t      len)
+{
+  memcpy(&self->datos[indice * (self->rowstride + 1)], linea, len);
+  self->longitudes[indice] = len;
+}
+
+/**
+ * Crea una textura nueva a partir de @camino, un archivo de texto plano
+ * válido
+ *
+ * @camino Un camino válido a un archivo de texto plano válido
+ *
+ * Returns: La nueva textura creada a partir del archivo, o NULL en caso de
+ * haber fallado
+ */
+Textura *textura_nueva_desde_archivo(const char *camino)
+{
+  FILE *stream = NULL;
+  char *linea = NULL, **lineas = NULL;
+  size_t caracteres = 0, size = 0, altura = 0, lineas_size = 0;
+  size_t longitud_maxima = 0;
+  Textura *self = NULL;
+
+  if (camino == NULL) {
+    return NULL;
+  }
+
+  stream = fopen(camino, "r");
+  if (stream == NULL) {
+    printf ("No se pudo abrir el archivo %s para crear una textura\n", camino);
+    return NULL;
+  }
+
+  /*
+   * Primero leemos todas las lineas, porque hasta conocer la más larga no
+   * sabemos el rowstride de la textura
+   */
+  while ((caracteres = getline(&linea, &size, stream)) != -1)
+  {
+    if (caracteres > 0 && linea[caracteres - 1] == '\n') {
+      linea[--caracteres] = 0;
+    }
+    if (caracteres > longitud_maxima) {
+      longitud_maxima = caracteres;
+    }
+
+    if (altura >= lineas_size) {
+      lineas_size += BUFFER_DEFAULT;
+      lineas = realloc(lineas, lineas_size * sizeof(char *));
+    }
+    lineas[altura++] = strdup(linea);
+  }
+  free (linea);
+  fclose (stream);
+
+  // Dejamos una columna de separación después de la linea más larga
+  self = textura_construir(longitud_maxima + 1, altura, NULL);
+  for (size_t i = 0; i < altura; i++) {
+    textura_copiar_linea(self, i, lineas[i], strlen(lineas[i]));
+    free(lineas[i]);
+  }
+  free(lineas);
+
+  return self;
+}
+
+/**
+ * Crea una textura nueva a partir de @altura lineas que ya están en memoria.
+ * Las lineas se copian, así que no tienen que vivir más que la textura.
+ *
+ * Igual que al leer un archivo, el rowstride deja una columna de separación
+ * después de la linea más larga.
+ *
+ * @lineas Las lineas de la textura, cada una terminada en NUL
+ * @altura El número de lineas
+ * @arena (nullable) Una arena donde alojar la textura, o NULL para usar malloc
+ *
+ * Returns: La nueva textura
+ */
+Textura *textura_nueva_desde_memoria(const char * const *lineas,
+                                     size_t              altura,
+                                     Arena              *arena)
+{
+  Textura *self = NULL;
+  size_t longitud_maxima = 0;
+
+  if (lineas == NULL) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < altura; i++) {
+    size_t longitud = strlen(lineas[i]);
+    if (longitud > longitud_maxima) {
+      longitud_maxima = longitud;
+    }
+  }
+
+  self = textura_construir(longitud_maxima + 1, altura, arena);
+  for (size_t i = 0; i < altura; i++) {
+    textura_copiar_linea(self, i, lineas[i], strlen(lineas[i]));
+  }
+
+  return self;
+}
+
+/**
+ * Crea una textura nueva con @veces copias de @self, una junto a la otra.
+ * Sirve para dibujar de un solo golpe algo que se repite, como las vidas.
+ *
+ * @self La textura que se quiere repetir
+ * @veces Cuántas veces se repite; con 0 se obtienen lineas vacías
+ * @arena (nullable) Una arena donde alojar la textura, o NULL para usar malloc
+ *
+ * Returns: La nueva textura, o NULL si @self es NULL
+ */
+Textura *textura_nueva_repetida(Textura *self,
+                                size_t   veces,
+                                Arena   *arena)
+{
+  Textura *repetida;
+
+  if (self == NULL) {
+    return NULL;
+  }
+
+  repetida = textura_construir(self->rowstride * veces, self->altura, arena);
+  for (size_t i = 0; i < self->altura; i++) {
+    for (size_t j = 0; j < veces; j++) {
+      memcpy(&repetida->datos[i * (repetida->rowstride + 1)
+                              + j * self->rowstride],
+             &self->datos[i * (self->rowstride + 1)], self->rowstride);
+    }
+    repetida->longitudes[i] = repetida->rowstride;
+  }
+
+  return repetida;
+}
+
+/**
+ * Retorna el número de caracteres de @self por linea
+ *
+ * @self La instancia de una textura
+ *
+ * Returns: El numero de caracteres por linea de @self
+ */
+int textura_get_rowstride(Textura *self)
+{
+  if (self == NULL) {
+    return -1;
+  }
+  return self->rowstride;
+}
+
+/**
+ * Retorna la altura de @self
+ *
+ * @self La instancia de una textura
+ *
+ * Returns: La altura de @self
+ */
+int textura_get_altura(Textura *self)
+{
+  if (self == NULL) {
+    return -1;
+  }
+  return self->altura;
+}
+
+/**
+ * Retorna la linea numero @indice de @self. La linea no termina en NUL: mide
+ * textura_get_longitud_linea() bytes.
+ *
+ * @self La instancia de una textura
+ * @indice La posicion de la linea que se quiere obtener
+ *
+ * Returns: La linea @indice de @self o NULL en caso de @indice invalido
+ */
+const char *textura_get_linea(Textura *self,
+                              size_t indice)
+{
+  if (self == NULL) {
+    return NULL;
+  }
+  if (indice >= self->altura) {
+    printf ("Índice %lu no válido!\n", indice);
+    return NULL;
+  }
+  return &self->datos[indice * (self->rowstride + 1)];
+}
+
+/**
+ * Retorna cuánto mide la linea numero @indice de @self, sin el relleno
+ *
+ * Returns: La longitud en bytes de la linea, o -1 en caso de @indice invalido
+ */
+int textura_get_longitud_linea(Textura *self,
+                               size_t   indice)
+{
+  if (self == NULL || indice >= self->altura) {
+    return -1;
+  }
+  return self->longitudes[indice];
+}
+
+/**
+ * Agrega la linea numero @indice de @self a @marco, rellenada con espacios
+ * hasta el rowstride de la textura
+ *
+ * @self La instancia de una textura
+ * @indice La posicion de la linea que se quiere dibujar
+ * @marco El marco en el que se está armando la pantalla
+ */
+void textura_dibujar_linea(Textura *self,
+                           size_t   indice,
+                           Marco   *marco)
+{
+  if (self == NULL) {
+    return;
+  }
+  if (indice >= self->altura) {
+    printf ("Índice %lu no válido!\n", indice);
+    return;
+  }
+  textura_dibujar_linea_unsafe(self, indice, marco);
+}
+
+void textura_dibujar_linea_unsafe(Textura *self,
+                                  size_t   indice,
+                                  Marco   *marco)
+{
+  marco_agregar(marco, &self->datos[indice * (self->rowstride + 1)],
+                self->rowstride);
+}
+
+/**
+ * Agrega la imagen contenida en @self a @marco. Como las lineas ya están
+ * rellenadas y separadas por saltos de linea, es una sola copia.
+ *
+ * @self - La instancia que se desea dibujar
+ * @marco - El marco en el que se está armando la pantalla
+ */
+void textura_dibujar(Textura *self,
+                     Marco   *marco)
+{
+  if (self == NULL) {
+    return;
+  }
+  marco_agregar(marco, self->datos, (self->rowstride + 1) * self->altura);
+}
+
+/**
+ * Libera la información contenida en @self
+ *
+ * @self La instancia que se quiera liberar
+ */
+void textura_liberar(Textura *self)
+{
+  if (self == NULL) {
+    return;
+  }
+  if (self->en_arena) {
+    return;
+  }
+  free(self->datos);
+  free(self->longitudes);
+  free(self);
+}
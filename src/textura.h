@@ -0,0 +1,29 @@
+/* textura.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "arena.h"
+#include "marco.h"
+
+struct __Textura;
+typedef struct __Textura Textura;
+
+Textura *textura_nueva_desde_archivo(const char *);
+Textura *textura_nueva_desde_memoria(const char * const *, size_t, Arena *);
+Textura *textura_nueva_repetida(Textura *, size_t, Arena *);
+int textura_get_rowstride(Textura *);
+int textura_get_altura(Textura *);
+const char *textura_get_linea(Textura *, size_t);
+int textura_get_longitud_linea(Textura *, size_t);
+void textura_dibujar_linea(Textura *, size_t, Marco *);
+void textura_dibujar(Textura *, Marco *);
+void textura_liberar(Textura *);
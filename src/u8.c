@@ -0,0 +1,559 @@
+/* u8.c
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "u8.h"
+#include "u8-tablas.h"
+
+const U8Casilla *u8_buscar_casilla(uint32_t);
+size_t u8_validar_caracter(const unsigned char *, size_t);
+size_t u8_validar_escalar(const unsigned char *, size_t, size_t, size_t, bool *);
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) __m256i u8_validar_bloque_avx2(__m256i,
+                                                               __m256i);
+__attribute__((target("avx2"))) __m256i u8_incompleto_avx2(__m256i);
+__attribute__((target("avx2"))) bool u8_validar_avx2(const unsigned char *,
+                                                     size_t, bool *);
+bool u8_validar_sse2(const unsigned char *, size_t, bool *);
+#endif
+
+/**
+ * Retorna la minuscula de @c
+ *
+ * @c - El caracter que se quiere convertir a minusculas
+ *
+ * Returns: La minuscula de @c, si es que tiene
+ */
+int char_minuscula(int c)
+{
+  if (c >= 65 && c <= 90) {
+    return c + 32;
+  }
+  return c;
+}
+
+/**
+ * Decodifica el caracter UTF-8 que empieza en @str.
+ *
+ * Los caracteres codificados en UTF-8 tienen unas caracteristicas particulares
+ * que nos pueden ayudar a identificarlos:
+ *
+ * 1. Los bits más significativos del primer byte dicen cuántos bytes ocupa
+ * el caracter: 0xxxxxxx es ASCII, 110xxxxx ocupa dos, 1110xxxx tres y
+ * 11110xxx cuatro. La macro PRIMER_U8 reconoce a los que ocupan más de uno.
+ *
+ * 2. Los dos bits más significativos de los demás bytes son 10, lo que
+ * revisa la macro PARTE_U8. Los seis bits restantes son parte del código.
+ *
+ * Si @str no tiene un caracter válido, consumimos un solo byte y regresamos
+ * U8_INVALIDO, para que quien esté recorriendo la cadena siempre avance.
+ *
+ * @str El inicio del caracter
+ * @len Cuántos bytes quedan en @str
+ * @consumidos Una dirección válida donde guardar cuántos bytes ocupa el
+ * caracter
+ *
+ * Returns: El código (code point) del caracter
+ */
+uint32_t u8_decodificar(const char *str,
+                        size_t      len,
+                        size_t     *consumidos)
+{
+  const unsigned char *u = (const unsigned char *) str;
+  uint32_t codigo;
+  size_t n;
+
+  *consumidos = 1;
+  if (len == 0) {
+    return U8_INVALIDO;
+  }
+  if (u[0] < 0x80) {
+    return u[0];
+  }
+
+  if ((u[0] & 0xE0) == 0xC0) {
+    n = 2;
+    codigo = u[0] & 0x1F;
+  } else if ((u[0] & 0xF0) == 0xE0) {
+    n = 3;
+    codigo = u[0] & 0x0F;
+  } else if ((u[0] & 0xF8) == 0xF0) {
+    n = 4;
+    codigo = u[0] & 0x07;
+  } else {
+    return U8_INVALIDO;
+  }
+  if (n > len) {
+    return U8_INVALIDO;
+  }
+
+  for (size_t i = 1; i < n; i++) {
+    if (!PARTE_U8 (u[i])) {
+      return U8_INVALIDO;
+    }
+    codigo = (codigo << 6) | (u[i] & 0x3F);
+  }
+
+  *consumidos = n;
+  return codigo;
+}
+
+/**
+ * Decodifica los @len bytes de @str a códigos.
+ *
+ * @codigos Donde guardar el código de cada caracter. Debe tener espacio para
+ * @len códigos
+ * @offsets (nullable) Donde guardar en qué byte de @str empieza cada
+ * caracter, más uno al final con @len. Debe tener espacio para @len + 1
+ *
+ * Returns: El número de caracteres decodificados
+ */
+size_t u8_decodificar_cadena(const char *str,
+                             size_t      len,
+                             uint32_t   *codigos,
+                             uint32_t   *offsets)
+{
+  size_t n = 0, i = 0;
+
+  while (i < len) {
+    size_t consumidos;
+
+    if (offsets != NULL) {
+      offsets[n] = i;
+    }
+    codigos[n++] = u8_decodificar (&str[i], len - i, &consumidos);
+    i += consumidos;
+  }
+  if (offsets != NULL) {
+    offsets[n] = len;
+  }
+
+  return n;
+}
+
+/**
+ * Escribe @codigo en UTF-8 en @destino, que debe tener espacio para al menos
+ * 4 bytes. Los códigos inválidos se escriben como U8_INVALIDO.
+ *
+ * Returns: Cuántos bytes se escribieron
+ */
+size_t u8_codificar(uint32_t  codigo,
+                    char     *destino)
+{
+  if (codigo > 0x10FFFF || (codigo >= 0xD800 && codigo <= 0xDFFF)) {
+    codigo = U8_INVALIDO;
+  }
+
+  if (codigo < 0x80) {
+    destino[0] = codigo;
+    return 1;
+  }
+  if (codigo < 0x800) {
+    destino[0] = 0xC0 | (codigo >> 6);
+    destino[1] = 0x80 | (codigo & 0x3F);
+    return 2;
+  }
+  if (codigo < 0x10000) {
+    destino[0] = 0xE0 | (codigo >> 12);
+    destino[1] = 0x80 | ((codigo >> 6) & 0x3F);
+    destino[2] = 0x80 | (codigo & 0x3F);
+    return 3;
+  }
+  destino[0] = 0xF0 | (codigo >> 18);
+  destino[1] = 0x80 | ((codigo >> 12) & 0x3F);
+  destino[2] = 0x80 | ((codigo >> 6) & 0x3F);
+  destino[3] = 0x80 | (codigo & 0x3F);
+  return 4;
+}
+
+/**
+ * Busca la casilla de @codigo en las tablas generadas por
+ * generar-tablas-u8.py, o NULL si @codigo está fuera de ellas
+ */
+const U8Casilla *u8_buscar_casilla(uint32_t codigo)
+{
+  if (codigo > U8_ULTIMO_TABULADO) {
+    return NULL;
+  }
+  return &u8_bloques[u8_paginas[codigo / U8_PAGINA]][codigo % U8_PAGINA];
+}
+
+/**
+ * Retorna la minúscula de @codigo, si es que tiene
+ */
+uint32_t u8_minuscula(uint32_t codigo)
+{
+  const U8Casilla *casilla = u8_buscar_casilla(codigo);
+  return casilla != NULL ? codigo + casilla->minuscula : codigo;
+}
+
+/**
+ * Retorna la mayúscula de @codigo, si es que tiene
+ */
+uint32_t u8_mayuscula(uint32_t codigo)
+{
+  const U8Casilla *casilla = u8_buscar_casilla(codigo);
+  return casilla != NULL ? codigo + casilla->mayuscula : codigo;
+}
+
+/**
+ * Retorna la llave plegada de @codigo: su letra base en minúscula, sin
+ * acento. Dos caracteres que el juego considera iguales tienen la misma
+ * llave, así que comparar letras es comparar sus llaves. La ñ se queda como
+ * ñ, porque en español es otra letra y no una n con tilde.
+ *
+ * Cubre Latin-1 y Latin Extended-A; cualquier otro caracter es su propia
+ * llave.
+ *
+ * @codigo El código de un caracter
+ *
+ * Returns: La llave de @codigo
+ */
+uint32_t u8_plegar(uint32_t codigo)
+{
+  const U8Casilla *casilla = u8_buscar_casilla(codigo);
+  return casilla != NULL ? codigo + casilla->base : codigo;
+}
+
+/**
+ * Returns: true si @codigo es una letra del español: su llave plegada (ver
+ * u8_plegar()) es de la a a la z, o la ñ
+ */
+bool u8_es_letra(uint32_t codigo)
+{
+  uint32_t llave = u8_plegar(codigo);
+  return (llave >= 'a' && llave <= 'z') || llave == 0xF1;
+}
+
+/*
+ * Validación de UTF-8
+ *
+ * Las listas de palabras pueden ser enormes, así que las validamos a la
+ * velocidad de la memoria: en x86-64 usamos AVX2 si el procesador lo tiene
+ * (con el algoritmo de tablas de Keiser y Lemire, "Validating UTF-8 In Less
+ * Than One Instruction Per Byte"), y si no, SSE2, que todos tienen, para
+ * saltarnos de 16 en 16 los bytes ASCII. En cualquier otro caso (incluso
+ * i386, donde SSE2 no está garantizado), o para lo que sobra al final, usamos
+ * la versión escalar.
+ */
+
+/**
+ * Valida el caracter UTF-8 que empieza en @u, rechazando las formas
+ * demasiado largas, los sustitutos (U+D800 a U+DFFF) y lo que pase de
+ * U+10FFFF
+ *
+ * Returns: Cuántos bytes ocupa el caracter, o 0 si no es válido
+ */
+size_t u8_validar_caracter(const unsigned char *u,
+                           size_t               len)
+{
+  size_t n;
+  uint32_t codigo;
+
+  if (u[0] < 0x80) {
+    return 1;
+  } else if (u[0] >= 0xC2 && u[0] <= 0xDF) {
+    n = 2;
+  } else if ((u[0] & 0xF0) == 0xE0) {
+    n = 3;
+  } else if (u[0] >= 0xF0 && u[0] <= 0xF4) {
+    n = 4;
+  } else {
+    return 0;
+  }
+  if (n > len) {
+    return 0;
+  }
+  for (size_t i = 1; i < n; i++) {
+    if (!PARTE_U8 (u[i])) {
+      return 0;
+    }
+  }
+
+  if (n == 3) {
+    codigo = ((u[0] & 0x0F) << 12) | ((u[1] & 0x3F) << 6) | (u[2] & 0x3F);
+    if (codigo < 0x800 || (codigo >= 0xD800 && codigo <= 0xDFFF)) {
+      return 0;
+    }
+  } else if (n == 4) {
+    codigo = ((u[0] & 0x07) << 18) | ((u[1] & 0x3F) << 12)
+             | ((u[2] & 0x3F) << 6) | (u[3] & 0x3F);
+    if (codigo < 0x10000 || codigo > 0x10FFFF) {
+      return 0;
+    }
+  }
+
+  return n;
+}
+
+/**
+ * Valida @len bytes de @u desde @inicio, que debe ser el inicio de un
+ * caracter, hasta @fin. Puede terminar un poco después de @fin si ahí queda
+ * un caracter a medias.
+ *
+ * Returns: Dónde terminó, o (size_t) -1 si encontró algo inválido
+ */
+size_t u8_validar_escalar(const unsigned char *u,
+                          size_t               len,
+                          size_t               inicio,
+                          size_t               fin,
+                          bool                *ascii)
+{
+  size_t i = inicio;
+
+  while (i < fin) {
+    size_t n = u8_validar_caracter(&u[i], len - i);
+    if (n == 0) {
+      return (size_t) -1;
+    }
+    if (n > 1) {
+      *ascii = false;
+    }
+    i += n;
+  }
+  return i;
+}
+
+#if defined(__x86_64__)
+
+#define U8_TOO_SHORT      (1 << 0)
+#define U8_TOO_LONG       (1 << 1)
+#define U8_OVERLONG_3     (1 << 2)
+#define U8_TOO_LARGE      (1 << 3)
+#define U8_SURROGATE      (1 << 4)
+#define U8_OVERLONG_2     (1 << 5)
+#define U8_TOO_LARGE_1000 (1 << 6)
+#define U8_OVERLONG_4     (1 << 6)
+#define U8_TWO_CONTS      (1 << 7)
+#define U8_CARRY          (U8_TOO_SHORT | U8_TOO_LONG | U8_TWO_CONTS)
+
+#define U8_TABLA(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+/**
+ * Revisa 32 bytes de @entrada, sabiendo que los anteriores eran @anterior.
+ * Cada par de bytes consecutivos se clasifica con tres tablas de 16 casillas
+ * (los 4 bits altos del primero, los 4 bajos del primero y los 4 altos del
+ * segundo); si los tres coinciden en algún error, el par no es válido.
+ *
+ * Returns: Un vector con algún bit encendido si hubo errores
+ */
+__attribute__((target("avx2")))
+__m256i u8_validar_bloque_avx2(__m256i entrada,
+                               __m256i anterior)
+{
+  const __m256i bajos = _mm256_set1_epi8(0x0F);
+  const __m256i tabla_1_altos = U8_TABLA(
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+    U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS,
+    U8_TOO_SHORT | U8_OVERLONG_2,
+    U8_TOO_SHORT,
+    U8_TOO_SHORT | U8_OVERLONG_3 | U8_SURROGATE,
+    U8_TOO_SHORT | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_OVERLONG_4);
+  const __m256i tabla_1_bajos = U8_TABLA(
+    U8_CARRY | U8_OVERLONG_3 | U8_OVERLONG_2 | U8_OVERLONG_4,
+    U8_CARRY | U8_OVERLONG_2,
+    U8_CARRY,
+    U8_CARRY,
+    U8_CARRY | U8_TOO_LARGE,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_SURROGATE,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000);
+  const __m256i tabla_2_altos = U8_TABLA(
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3
+    | U8_TOO_LARGE_1000 | U8_OVERLONG_4,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 | U8_TOO_LARGE,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT);
+  __m256i cruce, previo1, previo2, previo3, especial, tercero, cuarto, debe;
+
+  // Los bytes anteriores a cada byte, tomando los del bloque anterior
+  cruce = _mm256_permute2x128_si256(anterior, entrada, 0x21);
+  previo1 = _mm256_alignr_epi8(entrada, cruce, 15);
+  previo2 = _mm256_alignr_epi8(entrada, cruce, 14);
+  previo3 = _mm256_alignr_epi8(entrada, cruce, 13);
+
+  especial = _mm256_and_si256(
+    _mm256_and_si256(
+      _mm256_shuffle_epi8(tabla_1_altos,
+                          _mm256_and_si256(_mm256_srli_epi16(previo1, 4),
+                                           bajos)),
+      _mm256_shuffle_epi8(tabla_1_bajos, _mm256_and_si256(previo1, bajos))),
+    _mm256_shuffle_epi8(tabla_2_altos,
+                        _mm256_and_si256(_mm256_srli_epi16(entrada, 4),
+                                         bajos)));
+
+  // El tercer y cuarto byte de un caracter deben ser de continuación
+  tercero = _mm256_subs_epu8(previo2, _mm256_set1_epi8((char) (0xE0 - 0x80)));
+  cuarto = _mm256_subs_epu8(previo3, _mm256_set1_epi8((char) (0xF0 - 0x80)));
+  debe = _mm256_and_si256(_mm256_or_si256(tercero, cuarto),
+                          _mm256_set1_epi8((char) 0x80));
+
+  return _mm256_xor_si256(debe, especial);
+}
+
+/**
+ * Returns: Un vector con algún bit encendido si @entrada termina a la mitad
+ * de un caracter
+ */
+__attribute__((target("avx2")))
+__m256i u8_incompleto_avx2(__m256i entrada)
+{
+  const __m256i maximo = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+  return _mm256_subs_epu8(entrada, maximo);
+}
+
+__attribute__((target("avx2")))
+bool u8_validar_avx2(const unsigned char *u,
+                     size_t               len,
+                     bool                *ascii)
+{
+  __m256i anterior = _mm256_setzero_si256();
+  __m256i incompleto = _mm256_setzero_si256();
+  __m256i error = _mm256_setzero_si256();
+  unsigned char resto[32];
+  size_t i = 0;
+
+  for (; i < len; i += 32) {
+    __m256i entrada;
+
+    if (i + 32 <= len) {
+      entrada = _mm256_loadu_si256((const __m256i *) &u[i]);
+    } else {
+      // Lo que sobra al final lo rellenamos con ceros, que son ASCII
+      memset(resto, 0, sizeof(resto));
+      memcpy(resto, &u[i], len - i);
+      entrada = _mm256_loadu_si256((const __m256i *) resto);
+    }
+
+    if (_mm256_movemask_epi8(entrada) == 0) {
+      // Todo es ASCII: solo falta que el bloque anterior no quedara a medias
+      error = _mm256_or_si256(error, incompleto);
+      incompleto = _mm256_setzero_si256();
+    } else {
+      *ascii = false;
+      error = _mm256_or_si256(error, u8_validar_bloque_avx2(entrada, anterior));
+      incompleto = u8_incompleto_avx2(entrada);
+    }
+    anterior = entrada;
+  }
+  error = _mm256_or_si256(error, incompleto);
+
+  return _mm256_testz_si256(error, error);
+}
+
+bool u8_validar_sse2(const unsigned char *u,
+                     size_t               len,
+                     bool                *ascii)
+{
+  size_t i = 0;
+
+  while (i + 16 <= len) {
+    __m128i bloque = _mm_loadu_si128((const __m128i *) &u[i]);
+
+    if (_mm_movemask_epi8(bloque) == 0) {
+      i += 16;
+      continue;
+    }
+    i = u8_validar_escalar(u, len, i, i + 16, ascii);
+    if (i == (size_t) -1) {
+      return false;
+    }
+  }
+
+  return u8_validar_escalar(u, len, i, len, ascii) != (size_t) -1;
+}
+
+#endif
+
+/**
+ * Revisa que los @len bytes de @str sean UTF-8 válido
+ *
+ * @str Los datos, que no necesitan terminar en NUL
+ * @len Cuántos bytes revisar
+ * @ascii (nullable) Dónde guardar si todos los bytes son ASCII
+ *
+ * Returns: true si @str es UTF-8 válido
+ */
+bool u8_validar(const char *str,
+                size_t      len,
+                bool       *ascii)
+{
+  const unsigned char *u = (const unsigned char *) str;
+  bool es_ascii = true, valido;
+
+  if (str == NULL) {
+    return false;
+  }
+
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    valido = u8_validar_avx2(u, len, &es_ascii);
+  } else {
+    valido = u8_validar_sse2(u, len, &es_ascii);
+  }
+#else
+  valido = u8_validar_escalar(u, len, 0, len, &es_ascii) != (size_t) -1;
+#endif
+
+  if (ascii != NULL) {
+    *ascii = valido && es_ascii;
+  }
+  return valido;
+}
+
+/**
+ * Returns: true si los @len bytes de @str son ASCII
+ */
+bool u8_es_ascii(const char *str,
+                 size_t      len)
+{
+  const unsigned char *u = (const unsigned char *) str;
+  size_t i = 0;
+
+  if (str == NULL) {
+    return false;
+  }
+
+#if defined(__x86_64__)
+  for (; i + 16 <= len; i += 16) {
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *) &u[i])) != 0) {
+      return false;
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    if (u[i] >= 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
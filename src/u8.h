@@ -0,0 +1,37 @@
+/* u8.h
+ *
+ * Copyright 2023 Diego Iván M.E
+ * Copyright 2023 Juan Pablo Alquicer
+ * Copyright 2023 Mariana García
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Nos ayudará a reconocer caracteres codificados en UTF-8 en vez de ASCII
+ *
+ * Macros implementadas gracias a: https://dev.to/rdentato/utf-8-strings-in-c-1-3-42a4
+ */
+#define PRIMER_U8(c) ((c & 0xC0) == 0xC0)
+#define PARTE_U8(c) ((c & 0xC0) == 0x80)
+#define ES_ASCII(c) (c >= 0)
+
+/* Lo que regresa u8_decodificar() cuando no encuentra un caracter válido */
+#define U8_INVALIDO 0xFFFD
+
+int char_minuscula(int);
+uint32_t u8_decodificar(const char *, size_t, size_t *);
+size_t u8_decodificar_cadena(const char *, size_t, uint32_t *, uint32_t *);
+size_t u8_codificar(uint32_t, char *);
+uint32_t u8_minuscula(uint32_t);
+uint32_t u8_mayuscula(uint32_t);
+uint32_t u8_plegar(uint32_t);
+bool u8_es_letra(uint32_t);
+bool u8_validar(const char *, size_t, bool *);
+bool u8_es_ascii(const char *, size_t);